@@ -17,6 +17,20 @@ function(Scions_setup_dependencies)
     cpmaddpackage("gh:catchorg/Catch2@3.3.2")
   endif()
 
+  if(Scions_BUILD_BENCHMARKS AND NOT TARGET benchmark::benchmark)
+    cpmaddpackage(
+      NAME
+      benchmark
+      GITHUB_REPOSITORY
+      google/benchmark
+      VERSION
+      1.8.3
+      OPTIONS
+      "BENCHMARK_ENABLE_TESTING OFF"
+      "BENCHMARK_ENABLE_INSTALL OFF"
+      "BENCHMARK_ENABLE_WERROR OFF")
+  endif()
+
 #  if(NOT TARGET tools::tools)
 #    cpmaddpackage("gh:lefticus/tools#update_build_system")
 #  endif()
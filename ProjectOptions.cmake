@@ -23,6 +23,7 @@ macro(Scions_setup_options)
   option(Scions_ENABLE_HARDENING "Enable hardening" OFF)
   option(Scions_ENABLE_COVERAGE "Enable coverage reporting" OFF)
   option(Scions_BUILD_EXAMPLE "Enable building of examples" ON)
+  option(Scions_BUILD_BENCHMARKS "Enable the benchmark targets" OFF)
   option(Scions_TRACE_TIME_CLANG "Enable Clang -ftime-trace feature" OFF)
 
   cmake_dependent_option(
@@ -0,0 +1,41 @@
+// Translation unit compiled once per (shape, size) step by run_compile_bench.cmake. Everything below is
+// evaluated by the compiler, the measured quantity is the cost of building this object.
+//
+//   MANIFOLD_BENCH_SHAPE : 0 chain, 1 fan out, 2 pinned groups (see scions::bench::Shape)
+//   MANIFOLD_BENCH_SIZE  : number of expressions (groups for shape 2)
+
+#ifndef MANIFOLD_BENCH_SHAPE
+#define MANIFOLD_BENCH_SHAPE 0
+#endif
+
+#ifndef MANIFOLD_BENCH_SIZE
+#define MANIFOLD_BENCH_SIZE 64
+#endif
+
+// No precompiled header here, parsing manifold is part of every measured step
+#include "manifold/common.hpp"
+
+#include "graph_shapes.hpp"
+
+namespace {
+using scions::bench::Shape;
+constexpr auto SHAPE = static_cast<Shape>(MANIFOLD_BENCH_SHAPE);
+constexpr uint32_t SIZE = MANIFOLD_BENCH_SIZE;
+
+constexpr auto container = scions::bench::makeGraph<SHAPE, SIZE>();
+constexpr auto dag       = container.to_dag<container.tableSizes()>().topologicalSort();
+
+// Prune to the last tensor, for the fan out shape this drops every other consumer
+constexpr std::array<uint32_t, 1> sub_out{ SIZE };
+constexpr auto sub = dag.subgraph<dag.subGraphCount(sub_out)>(sub_out);
+
+constexpr auto meta = manifold::graphMetadata(dag);
+constexpr auto graph = manifold::compact<meta>(dag);
+}  // namespace
+
+// Emitted so the size of the lowered graph shows up in the object
+extern const decltype(graph) manifold_bench_graph;
+const decltype(graph) manifold_bench_graph = graph;
+
+extern const uint32_t manifold_bench_sub_ops;
+const uint32_t manifold_bench_sub_ops = sub.edges.size();
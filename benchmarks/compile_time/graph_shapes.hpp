@@ -0,0 +1,66 @@
+#pragma once
+#include "manifold/ops/element_wise_ops.hpp"
+#include "manifold/ops/special_ops.hpp"
+#include "manifold/static_graph.hpp"
+#include "manifold/tensor.hpp"
+
+//! Synthetic SymbolContainers for the compile time benchmarks. Expressions are emitted consumers first so
+//! topologicalSort always has to reorder the whole graph.
+
+namespace scions::bench {
+enum class Shape : uint8_t { CHAIN, FANOUT, GROUPS };
+
+using BenchTensor = manifold::Tensor<manifold::TBase<manifold::DType::F32, 16>>;
+
+//! t_{i+1} = exp(t_i), @tparam N expressions deep
+template<uint32_t N>
+consteval auto chainGraph() {
+  using namespace manifold;
+  std::array<TensorReflection, N + 1> tensors{};
+  std::array<ExpressionReflection, N> exprs{};
+  for (uint32_t i{}; i <= N; i++) { tensors[i] = BenchTensor(i).reflect(); }
+  for (uint32_t i{}; i < N; i++) { exprs[N - 1 - i] = op::exp(N + 1 + i, BenchTensor(i + 1), BenchTensor(i)); }
+  return SymbolContainer{ tensors, exprs };
+}
+
+//! A single input read by @tparam N expressions
+template<uint32_t N>
+consteval auto fanoutGraph() {
+  using namespace manifold;
+  std::array<TensorReflection, N + 1> tensors{};
+  std::array<ExpressionReflection, N> exprs{};
+  for (uint32_t i{}; i <= N; i++) { tensors[i] = BenchTensor(i).reflect(); }
+  for (uint32_t i{}; i < N; i++) { exprs[i] = op::exp(N + 1 + i, BenchTensor(i + 1), BenchTensor(0)); }
+  return SymbolContainer{ tensors, exprs };
+}
+
+//! @tparam N pinned groups of { t_{i+1} = copy(t_i), t_{i+1} += 1 }, the read-modify-write pattern of gates_v3
+template<uint32_t N>
+consteval auto groupGraph() {
+  using namespace manifold;
+  std::array<TensorReflection, N + 1> tensors{};
+  std::array<ExpressionReflection, 3 * N> exprs{};
+  for (uint32_t i{}; i <= N; i++) { tensors[i] = BenchTensor(i).reflect(); }
+  for (uint32_t i{}; i < N; i++) {
+    const uint32_t id   = N + 1 + 3 * i;
+    const auto copy     = op::copy(id + 1, BenchTensor(i + 1), BenchTensor(i));
+    const auto add      = op::elm_add(id + 2, BenchTensor(i + 1), 1.0F);
+    const uint32_t slot = 3 * (N - 1 - i);
+    exprs[slot]         = op::exp_group(id, std::array{ copy, add }, true);
+    exprs[slot + 1]     = copy;
+    exprs[slot + 2]     = add;
+  }
+  return SymbolContainer{ tensors, exprs };
+}
+
+template<Shape S, uint32_t N>
+consteval auto makeGraph() {
+  if constexpr (S == Shape::CHAIN) {
+    return chainGraph<N>();
+  } else if constexpr (S == Shape::FANOUT) {
+    return fanoutGraph<N>();
+  } else {
+    return groupGraph<N>();
+  }
+}
+}  // namespace scions::bench
@@ -0,0 +1,116 @@
+# Compiles compile_bench.cpp once per (shape, size) step and records the cost of each build.
+#
+# cmake -DCXX=<compiler> -DSOURCE=<compile_bench.cpp> -DINCLUDE_DIRS=<dirs> -DOUTPUT=<csv>
+#       [-DSHAPES=chain;fanout;groups] [-DSIZES=64;256;1024] [-DCXX_FLAGS=...]
+#       [-DBASELINE=<csv>] -P run_compile_bench.cmake
+#
+# Every row of the csv holds: shape,size,compile_ms,peak_rss_kb,object_bytes. Peak RSS needs GNU time
+# (/usr/bin/time), it is reported as -1 without it. With BASELINE, each step is printed next to the matching
+# row of an earlier run.
+
+cmake_minimum_required(VERSION 3.23)
+
+foreach(required CXX SOURCE INCLUDE_DIRS OUTPUT)
+  if(NOT DEFINED ${required})
+    message(FATAL_ERROR "run_compile_bench: ${required} is required")
+  endif()
+endforeach()
+
+if(NOT DEFINED SHAPES)
+  set(SHAPES chain fanout groups)
+endif()
+if(NOT DEFINED SIZES)
+  set(SIZES 64 256 1024)
+endif()
+
+find_program(GNU_TIME NAMES time PATHS /usr/bin NO_DEFAULT_PATH)
+
+get_filename_component(WORK_DIR "${OUTPUT}" DIRECTORY)
+set(OBJECT "${WORK_DIR}/compile_bench_step.o")
+set(RSS_FILE "${WORK_DIR}/compile_bench_step.rss")
+
+set(INCLUDE_FLAGS)
+foreach(dir ${INCLUDE_DIRS})
+  list(APPEND INCLUDE_FLAGS "-I${dir}")
+endforeach()
+separate_arguments(EXTRA_FLAGS NATIVE_COMMAND "${CXX_FLAGS}")
+
+# Baseline rows keyed by shape_size
+if(DEFINED BASELINE AND EXISTS "${BASELINE}")
+  file(STRINGS "${BASELINE}" baseline_rows)
+  foreach(row ${baseline_rows})
+    string(REPLACE "," ";" fields "${row}")
+    list(GET fields 0 b_shape)
+    list(GET fields 1 b_size)
+    list(GET fields 2 b_ms)
+    list(GET fields 3 b_rss)
+    set(BASE_${b_shape}_${b_size} "${b_ms} ms, ${b_rss} KiB")
+  endforeach()
+endif()
+
+set(shape_index 0)
+set(csv "shape,size,compile_ms,peak_rss_kb,object_bytes\n")
+message(STATUS "shape    size\tcompile_ms\tpeak_rss_kb\tobject_bytes")
+
+foreach(shape chain fanout groups)
+  list(FIND SHAPES ${shape} selected)
+  if(selected EQUAL -1)
+    math(EXPR shape_index "${shape_index} + 1")
+    continue()
+  endif()
+
+  foreach(size ${SIZES})
+    set(command
+        ${CXX}
+        -std=c++23
+        -O1
+        -c
+        ${INCLUDE_FLAGS}
+        ${EXTRA_FLAGS}
+        -DMANIFOLD_BENCH_SHAPE=${shape_index}
+        -DMANIFOLD_BENCH_SIZE=${size}
+        ${SOURCE}
+        -o
+        ${OBJECT})
+    if(GNU_TIME)
+      set(command ${GNU_TIME} -f "%M" -o ${RSS_FILE} ${command})
+    endif()
+
+    file(REMOVE ${OBJECT} ${RSS_FILE})
+    string(TIMESTAMP start "%s%f")
+    execute_process(COMMAND ${command} RESULT_VARIABLE result ERROR_VARIABLE error_log)
+    string(TIMESTAMP stop "%s%f")
+
+    if(NOT result EQUAL 0)
+      message(WARNING "run_compile_bench: ${shape} ${size} failed to compile\n${error_log}")
+      string(APPEND csv "${shape},${size},-1,-1,-1\n")
+      continue()
+    endif()
+
+    # %s%f is microseconds since the epoch
+    math(EXPR compile_ms "(${stop} - ${start}) / 1000")
+    file(SIZE ${OBJECT} object_bytes)
+    set(peak_rss -1)
+    if(EXISTS ${RSS_FILE})
+      file(STRINGS ${RSS_FILE} rss_lines REGEX "^[0-9]+$")
+      list(GET rss_lines -1 peak_rss)
+    endif()
+
+    string(APPEND csv "${shape},${size},${compile_ms},${peak_rss},${object_bytes}\n")
+    set(line "${shape}")
+    string(LENGTH "${shape}" len)
+    foreach(pad RANGE ${len} 8)
+      string(APPEND line " ")
+    endforeach()
+    string(APPEND line "${size}\t${compile_ms}\t${peak_rss}\t${object_bytes}")
+    if(DEFINED BASE_${shape}_${size})
+      string(APPEND line "\t(baseline ${BASE_${shape}_${size}})")
+    endif()
+    message(STATUS "${line}")
+  endforeach()
+  math(EXPR shape_index "${shape_index} + 1")
+endforeach()
+
+file(REMOVE ${OBJECT} ${RSS_FILE})
+file(WRITE ${OUTPUT} "${csv}")
+message(STATUS "Compile time results written to ${OUTPUT}")
@@ -0,0 +1,124 @@
+# Compares a Google Benchmark json report against a baseline report, run in script mode
+#
+#   cmake -DCURRENT=<json> -DBASELINE=<json> [-DTHRESHOLD=<percent>] [-DFAIL_ON_REGRESSION=ON]
+#         -P compare_bench.cmake
+#
+# Benchmarks are matched by name and compared on real time. Every benchmark slower than the baseline by more
+# than THRESHOLD percent is reported as a regression, the script fails on any when FAIL_ON_REGRESSION is set.
+
+cmake_minimum_required(VERSION 3.21)
+
+if(NOT DEFINED CURRENT)
+  message(FATAL_ERROR "compare_bench: CURRENT (json report) is required")
+endif()
+if(NOT DEFINED THRESHOLD)
+  set(THRESHOLD 5)
+endif()
+if(NOT DEFINED BASELINE OR BASELINE STREQUAL "")
+  message(FATAL_ERROR "compare_bench: BASELINE (json report) is required")
+endif()
+if(NOT EXISTS "${BASELINE}")
+  message(FATAL_ERROR "compare_bench: no baseline at '${BASELINE}', store one with scions_runtime_bench_save_baseline")
+endif()
+
+# json doubles are written as 1.2345e+03, cmake math only knows int64 so times are turned into picoseconds
+function(time_to_ps value unit out)
+  if(NOT value MATCHES "^([0-9]+)\\.?([0-9]*)e?([-+]?[0-9]*)$")
+    message(FATAL_ERROR "compare_bench: can't parse time '${value}'")
+  endif()
+  set(digits "${CMAKE_MATCH_1}${CMAKE_MATCH_2}")
+  string(LENGTH "${CMAKE_MATCH_1}" point)
+  set(exponent "${CMAKE_MATCH_3}")
+  if(exponent STREQUAL "")
+    set(exponent 0)
+  endif()
+
+  if(unit STREQUAL "ns")
+    math(EXPR exponent "${exponent} + 3")
+  elseif(unit STREQUAL "us")
+    math(EXPR exponent "${exponent} + 6")
+  elseif(unit STREQUAL "ms")
+    math(EXPR exponent "${exponent} + 9")
+  elseif(unit STREQUAL "s")
+    math(EXPR exponent "${exponent} + 12")
+  else()
+    message(FATAL_ERROR "compare_bench: unknown time unit '${unit}'")
+  endif()
+
+  # position of the decimal point once scaled, everything after it is dropped
+  math(EXPR point "${point} + ${exponent}")
+  string(LENGTH "${digits}" len)
+  if(point LESS_EQUAL 0)
+    set(${out} 0 PARENT_SCOPE)
+    return()
+  endif()
+  while(len LESS point)
+    string(APPEND digits "0")
+    math(EXPR len "${len} + 1")
+  endwhile()
+  string(SUBSTRING "${digits}" 0 ${point} digits)
+  string(REGEX REPLACE "^0+" "" digits "${digits}")
+  if(digits STREQUAL "")
+    set(digits 0)
+  endif()
+  set(${out} ${digits} PARENT_SCOPE)
+endfunction()
+
+# sets <prefix>_names and <prefix>_<name> (real time in ps) for every successful benchmark of a report
+function(read_report file prefix)
+  file(READ "${file}" json)
+  string(JSON count ERROR_VARIABLE err LENGTH "${json}" benchmarks)
+  if(err)
+    message(FATAL_ERROR "compare_bench: ${file} is not a benchmark json report (${err})")
+  endif()
+
+  set(names "")
+  if(count GREATER 0)
+    math(EXPR last "${count} - 1")
+    foreach(i RANGE ${last})
+      string(JSON error ERROR_VARIABLE missing GET "${json}" benchmarks ${i} error_occurred)
+      if(NOT missing AND error)
+        continue()
+      endif()
+      string(JSON name GET "${json}" benchmarks ${i} name)
+      string(JSON time GET "${json}" benchmarks ${i} real_time)
+      string(JSON unit GET "${json}" benchmarks ${i} time_unit)
+      time_to_ps("${time}" "${unit}" ps)
+      string(MAKE_C_IDENTIFIER "${name}" key)
+      list(APPEND names "${name}")
+      set(${prefix}_${key} ${ps} PARENT_SCOPE)
+    endforeach()
+  endif()
+  set(${prefix}_names "${names}" PARENT_SCOPE)
+endfunction()
+
+read_report("${CURRENT}" cur)
+read_report("${BASELINE}" base)
+
+set(regressions 0)
+set(compared 0)
+message(STATUS "compare_bench: ${CURRENT} against ${BASELINE} (threshold ${THRESHOLD}%)")
+foreach(name IN LISTS cur_names)
+  string(MAKE_C_IDENTIFIER "${name}" key)
+  if(NOT DEFINED base_${key})
+    message(STATUS "  new         ${name}")
+    continue()
+  endif()
+  if(base_${key} EQUAL 0)
+    continue()
+  endif()
+
+  math(EXPR change "(${cur_${key}} - ${base_${key}}) * 100 / ${base_${key}}")
+  math(EXPR compared "${compared} + 1")
+  if(change GREATER THRESHOLD)
+    math(EXPR regressions "${regressions} + 1")
+    message(STATUS "  REGRESSED   ${name} : +${change}%")
+  elseif(change LESS -${THRESHOLD})
+    message(STATUS "  improved    ${name} : ${change}%")
+  endif()
+endforeach()
+
+message(STATUS "compare_bench: ${compared} compared, ${regressions} regressed")
+if(regressions GREATER 0 AND FAIL_ON_REGRESSION)
+  message(FATAL_ERROR "compare_bench: ${regressions} benchmarks are more than ${THRESHOLD}% slower than the baseline")
+endif()
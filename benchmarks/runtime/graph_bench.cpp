@@ -0,0 +1,435 @@
+#include "manifold/graph_file.hpp"
+#include "manifold/ops/element_wise_ops.hpp"
+#include "manifold/ops/special_ops.hpp"
+#include "manifold/runtime_graph.hpp"
+#include "manifold/static_graph.hpp"
+#include "manifold/tensor.hpp"
+#include "scions/ep/cpu/autotune.hpp"
+#include "scions/ep/cpu/batch_graph.hpp"
+#include "scions/ep/cpu/cpu_graph.hpp"
+#include "scions/ep/cpu/cpu_mem_store.hpp"
+#include "scions/ep/cpu/exec_graph_gen.hpp"
+#include "scions/ep/cpu/profiler.hpp"
+#include "scions/ep/cpu/runtime_exec.hpp"
+#include "scions/ep/cpu/scalar_graph.hpp"
+#include "scions/ep/cpu/thread_pool.hpp"
+#include <benchmark/benchmark.h>
+#include <functional>
+#include <vector>
+
+//! End to end graph benchmarks, every graph is run through each executor able to take it:
+//!  - gates : the scalar gate network of examples/gates_v3.cpp, per sample and batched. graph/gates/scalar is the
+//!            latency of one evaluation as straight line code, graph/gates/op_by_op the same graph run op by op over
+//!            the CpuMemStore buffers
+//!  - mlp : layers of h' = exp(h * w + b). Manifold has no matmul yet, so a layer is its element wise part only
+//!  - reduction : a tree of MANIFOLD_MAX_EXP_INPUT-ary adds folding many tensors into one, stands in for
+//!                reductions (OpType::ARRAY_SUM has no kernel yet)
+//! Static graphs go through exec_cpu_graph, the same shapes are also built with manifold::GraphBuilder and run
+//! through RuntimeCpuGraph at sizes too large for constexpr evaluation.
+//! The wide benchmarks run independent chains given layer by layer under every SortOrder objective, with more
+//! chains than fit in the L2 the locality order keeps every chain in cache while the index order streams them all,
+//! peak_kb shows the planned memory of each order.
+//! The startup benchmarks compare planning a runtime graph from scratch with loading the same plan from a graph file.
+//! The dispatch benchmarks run a graph of tiny tensors (4 floats) so the time per op is mostly the cost of getting to
+//! the kernel : unrolled exec_cpu_graph, the flat CpuGraph stream, and a std::function per op as CpuGraph used to be.
+
+namespace {
+using namespace manifold;
+
+consteval auto gatesGraph() {
+  const auto v1 = Scalar<DType::F32>(0);
+  const auto v2 = Scalar<DType::F32>(1);
+  const auto v3 = Scalar<DType::F32>(2);
+  const auto v4 = Scalar<DType::F32>(3);
+
+  const auto exp        = op::exp(4, v2, v1);
+  const auto copy_v2_v3 = op::copy(5, v3, v2);
+  const auto add_2      = op::elm_add(6, v3, 1.0F);
+  const auto group      = op::exp_group(7, std::array{ copy_v2_v3, add_2 }, true);
+  const auto mul        = op::elm_mul(8, v4, std::array{ v2, v3 });
+
+  const auto container = SymbolContainer{ std::array{ v1.reflect(), v2.reflect(), v3.reflect(), v4.reflect() },
+    std::array{ exp, group, mul, add_2, copy_v2_v3 } };
+  return container.to_dag().topologicalSort();
+}
+
+//! x, then { w, b, x * w, + b, exp } per layer
+template<uint32_t W, uint32_t L>
+consteval auto mlpGraph() {
+  using T = Tensor<TBase<DType::F32, W>>;
+  std::array<TensorReflection, 1 + 5 * L> tensors{};
+  std::array<ExpressionReflection, 3 * L> exprs{};
+  for (uint32_t i{}; i < tensors.size(); i++) { tensors[i] = T(i).reflect(); }
+  for (uint32_t i{}; i < L; i++) {
+    const uint32_t base = 1 + 5 * i;
+    const uint32_t id   = static_cast<uint32_t>(tensors.size()) + 3 * i;
+    exprs[3 * i]        = op::elm_mul(id, T(base + 2), std::array{ T(base - 1), T(base) });
+    exprs[3 * i + 1]    = op::elm_add(id + 1, T(base + 3), std::array{ T(base + 2), T(base + 1) });
+    exprs[3 * i + 2]    = op::exp(id + 2, T(base + 4), T(base + 3));
+  }
+  return SymbolContainer{ tensors, exprs }.to_dag().topologicalSort();
+}
+
+//! MANIFOLD_MAX_EXP_INPUT^2 leaves folded by two levels of adds
+template<uint32_t W>
+consteval auto reductionGraph() {
+  using T              = Tensor<TBase<DType::F32, W>>;
+  constexpr uint32_t K = MANIFOLD_MAX_EXP_INPUT;
+  std::array<TensorReflection, K * K + K + 1> tensors{};
+  std::array<ExpressionReflection, K + 1> exprs{};
+  for (uint32_t i{}; i < tensors.size(); i++) { tensors[i] = T(i).reflect(); }
+
+  std::array<T, K> partial{};
+  for (uint32_t i{}; i < K; i++) {
+    std::array<T, K> leaves{};
+    for (uint32_t j{}; j < K; j++) { leaves[j] = T(i * K + j); }
+    partial[i] = T(K * K + i);
+    exprs[i]   = op::elm_add(static_cast<uint32_t>(tensors.size()) + i, partial[i], leaves);
+  }
+  exprs[K] = op::elm_add(static_cast<uint32_t>(tensors.size()) + K, T(K * K + K), partial);
+  return SymbolContainer{ tensors, exprs }.to_dag().topologicalSort();
+}
+
+//! A sorted StaticDAG together with its metadata and executable form
+template<auto dag>
+struct StaticCase {
+  static constexpr auto META  = graphMetadata(dag);
+  static constexpr auto GRAPH = compact<META>(dag);
+};
+
+using Gates     = StaticCase<gatesGraph()>;
+using Mlp       = StaticCase<mlpGraph<4096, 8>()>;
+using Reduction = StaticCase<reductionGraph<4096>()>;
+using Dispatch  = StaticCase<mlpGraph<4, 64>()>;
+
+//! Runtime version of mlpGraph
+CompactRuntimeGraph runtimeMlp(const uint32_t width, const uint32_t layers) {
+  GraphBuilder builder;
+  builder.reserve(1 + 5 * static_cast<size_t>(layers), 3 * static_cast<size_t>(layers));
+  const std::array shape{ width };
+  uint32_t prev = builder.tensor(DType::F32, shape);
+  for (uint32_t i{}; i < layers; i++) {
+    const auto weight = builder.tensor(DType::F32, shape);
+    const auto bias   = builder.tensor(DType::F32, shape);
+    const auto mul    = builder.tensor(DType::F32, shape);
+    const auto add    = builder.tensor(DType::F32, shape);
+    const auto act    = builder.tensor(DType::F32, shape);
+    builder.elementWise(OpType::ELM_MUL, mul, std::array{ prev, weight });
+    builder.elementWise(OpType::ELM_ADD, add, std::array{ mul, bias });
+    builder.elementWise(OpType::EXPONENTIAL, act, std::array{ add });
+    prev = act;
+  }
+  return compact(builder.toDag().topologicalSort());
+}
+
+//! Runtime version of reductionGraph, @param leaves are folded level by level until a single tensor is left
+CompactRuntimeGraph runtimeReduction(const uint32_t width, const uint32_t leaves) {
+  GraphBuilder builder;
+  const std::array shape{ width };
+  std::vector<uint32_t> level(leaves);
+  for (auto &leaf : level) { leaf = builder.tensor(DType::F32, shape); }
+
+  while (level.size() > 1) {
+    std::vector<uint32_t> next;
+    for (size_t i{}; i < level.size(); i += MANIFOLD_MAX_EXP_INPUT) {
+      const auto count = std::min<size_t>(MANIFOLD_MAX_EXP_INPUT, level.size() - i);
+      if (count == 1) {
+        next.push_back(level[i]);
+        continue;
+      }
+      const auto out = builder.tensor(DType::F32, shape);
+      builder.elementWise(OpType::ELM_ADD, out, std::span<const uint32_t>(level).subspan(i, count));
+      next.push_back(out);
+    }
+    level = std::move(next);
+  }
+  return compact(builder.toDag().topologicalSort());
+}
+
+//! @param chains independent chains of x' = x + x, given layer by layer (breadth first)
+CompactRuntimeGraph runtimeWide(const uint32_t width, const uint32_t chains, const SortOrder objective) {
+  constexpr uint32_t layers = 8;
+  GraphBuilder builder;
+  const std::array shape{ width };
+  std::vector<uint32_t> heads(chains);
+  for (auto &head : heads) { head = builder.tensor(DType::F32, shape); }
+  for (uint32_t layer{}; layer < layers; layer++) {
+    for (auto &head : heads) {
+      const auto next = builder.tensor(DType::F32, shape);
+      builder.elementWise(OpType::ELM_ADD, next, std::array{ head, head });
+      head = next;
+    }
+  }
+  return compact(builder.toDag().topologicalSort(objective));
+}
+
+void BM_GatesScalar(benchmark::State &state) {
+  float val = 0.5F;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(val);
+    benchmark::DoNotOptimize(scions::cpu::exec_scalar_graph<Gates::GRAPH>({ val }));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+//! Records nothing, only makes exec_cpu_graph run the ops one by one
+struct NoRecorder {
+  void begin() {}
+  void end(size_t) {}
+  void endRun() {}
+};
+
+void BM_GatesOpByOp(benchmark::State &state) {
+  scions::cpu::CpuMemStore<Gates::META> store(Gates::GRAPH);
+  store.initializeMemory();
+  NoRecorder recorder;
+  auto input = store.tensorSpan<float>(scions::cpu::graph_inputs<Gates::GRAPH>[0]);
+  for (auto _ : state) {
+    input[0] = 0.5F;
+    scions::cpu::exec_cpu_graph<Gates::GRAPH>(store, recorder);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+//! range(0) : samples per run
+void BM_GatesBatch(benchmark::State &state) {
+  const auto batch = static_cast<size_t>(state.range(0));
+  scions::cpu::BatchExecutor<Gates::GRAPH> executor(batch);
+  std::ranges::fill(executor.tensorSpan<float>(scions::cpu::graph_inputs<Gates::GRAPH>[0]), 0.5F);
+  for (auto _ : state) {
+    executor.run();
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(batch));
+}
+
+template<typename Case>
+void BM_StaticGraph(benchmark::State &state) {
+  static constexpr auto &GRAPH = Case::GRAPH;
+  scions::cpu::CpuMemStore<Case::META> store(GRAPH);
+  store.initializeMemory();
+  for (const auto idx : scions::cpu::graph_inputs<GRAPH>) {
+    std::ranges::fill(store.template tensorSpan<float>(idx), 0.01F);
+  }
+
+  for (auto _ : state) {
+    scions::cpu::exec_cpu_graph<GRAPH>(store);
+    benchmark::ClobberMemory();
+  }
+  state.counters["ops"] = static_cast<double>(GRAPH.expressions.size());
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(Case::META.total));
+}
+
+enum class Dispatcher : uint8_t { STATIC, FLAT, FUNCTION };
+
+template<Dispatcher D>
+void BM_Dispatch(benchmark::State &state) {
+  static constexpr auto &GRAPH = Dispatch::GRAPH;
+  scions::cpu::CpuMemStore<Dispatch::META> store(GRAPH);
+  store.initializeMemory();
+  for (const auto idx : scions::cpu::graph_inputs<GRAPH>) {
+    std::ranges::fill(store.template tensorSpan<float>(idx), 0.01F);
+  }
+
+  std::vector<void *> ptrs;
+  for (const auto &ref : store.tensor_refs) { ptrs.push_back(ref.data_ptr); }
+  const scions::cpu::CpuGraph plan(GRAPH, ptrs);
+  std::vector<std::function<void()>> functions;
+  for (const auto &ins : plan.stream()) { functions.emplace_back([ins] { ins.kernel(ins); }); }
+
+  for (auto _ : state) {
+    if constexpr (D == Dispatcher::STATIC) {
+      scions::cpu::exec_cpu_graph<GRAPH>(store);
+    } else if constexpr (D == Dispatcher::FLAT) {
+      plan.run();
+    } else {
+      for (const auto &function : functions) { function(); }
+    }
+    benchmark::ClobberMemory();
+  }
+  state.counters["time_per_op"] = benchmark::Counter(
+    static_cast<double>(state.iterations()) * static_cast<double>(GRAPH.expressions.size()),
+    benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+//! range(0) : tensor width, range(1) : layers or leaves depending on @param make
+template<CompactRuntimeGraph (*make)(uint32_t, uint32_t)>
+void BM_RuntimeGraph(benchmark::State &state) {
+  scions::cpu::RuntimeCpuGraph graph(
+    make(static_cast<uint32_t>(state.range(0)), static_cast<uint32_t>(state.range(1))));
+  for (const auto idx : graph.inputs()) { std::ranges::fill(graph.tensorSpan<float>(idx), 0.01F); }
+
+  for (auto _ : state) {
+    graph.run();
+    benchmark::ClobberMemory();
+  }
+  state.counters["ops"] = static_cast<double>(graph.compactGraph().expressions.size());
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(graph.compactGraph().meta.total));
+}
+
+//! BM_RuntimeGraph running element wise segments tile by tile (RuntimeCpuGraph::runTiled)
+template<CompactRuntimeGraph (*make)(uint32_t, uint32_t)>
+void BM_RuntimeGraphTiled(benchmark::State &state) {
+  scions::cpu::RuntimeCpuGraph graph(
+    make(static_cast<uint32_t>(state.range(0)), static_cast<uint32_t>(state.range(1))));
+  for (const auto idx : graph.inputs()) { std::ranges::fill(graph.tensorSpan<float>(idx), 0.01F); }
+
+  for (auto _ : state) {
+    graph.runTiled();
+    benchmark::ClobberMemory();
+  }
+  state.counters["segments"] = static_cast<double>(graph.tileSchedule().segments().size());
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(graph.compactGraph().meta.total));
+}
+
+//! BM_RuntimeGraph with the kernels autotuned for this machine beforehand (1 s budget)
+template<CompactRuntimeGraph (*make)(uint32_t, uint32_t)>
+void BM_RuntimeGraphTuned(benchmark::State &state) {
+  auto compact_graph = make(static_cast<uint32_t>(state.range(0)), static_cast<uint32_t>(state.range(1)));
+  const auto table   = scions::cpu::autotune(compact_graph, std::chrono::seconds(1));
+  scions::cpu::RuntimeCpuGraph graph(std::move(compact_graph), table);
+  for (const auto idx : graph.inputs()) { std::ranges::fill(graph.tensorSpan<float>(idx), 0.01F); }
+
+  for (auto _ : state) {
+    graph.run();
+    benchmark::ClobberMemory();
+  }
+  state.counters["chunked"] = static_cast<double>(
+    std::ranges::count_if(table.chunks, [](const auto &entry) { return entry.second != 0; }));
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(graph.compactGraph().meta.total));
+}
+
+//! BM_RuntimeGraph on a ThreadPool of range(2) workers
+template<CompactRuntimeGraph (*make)(uint32_t, uint32_t)>
+void BM_RuntimeGraphPool(benchmark::State &state) {
+  scions::cpu::RuntimeCpuGraph graph(
+    make(static_cast<uint32_t>(state.range(0)), static_cast<uint32_t>(state.range(1))));
+  for (const auto idx : graph.inputs()) { std::ranges::fill(graph.tensorSpan<float>(idx), 0.01F); }
+  scions::cpu::ThreadPool pool(static_cast<size_t>(state.range(2)));
+
+  for (auto _ : state) {
+    graph.run(pool);
+    benchmark::ClobberMemory();
+  }
+  state.counters["tasks"] = static_cast<double>(graph.taskGraph().size());
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(graph.compactGraph().meta.total));
+}
+
+//! Time to get a runnable plan of the runtime mlp : built and planned (Load false) or read from a graph file
+//! range(0) : tensor width, range(1) : layers
+template<bool Load>
+void BM_GraphStartup(benchmark::State &state) {
+  const auto width  = static_cast<uint32_t>(state.range(0));
+  const auto layers = static_cast<uint32_t>(state.range(1));
+  const auto path   = std::filesystem::temp_directory_path() / "manifold_graph_bench.mfg";
+  if constexpr (Load) { saveGraph(path, runtimeMlp(width, layers)); }
+
+  for (auto _ : state) {
+    CompactRuntimeGraph graph = Load ? loadGraph(path) : runtimeMlp(width, layers);
+    benchmark::DoNotOptimize(graph);
+  }
+  if constexpr (Load) { std::filesystem::remove(path); }
+}
+
+//! BM_RuntimeGraphPool with the arena placed over the NUMA nodes of the machine and workers pinned to them
+template<CompactRuntimeGraph (*make)(uint32_t, uint32_t)>
+void BM_RuntimeGraphNuma(benchmark::State &state) {
+  const auto topology = scions::cpu::NumaTopology::detect();
+  scions::cpu::RuntimeCpuGraph graph(
+    make(static_cast<uint32_t>(state.range(0)), static_cast<uint32_t>(state.range(1))));
+  graph.place(topology);
+  for (const auto idx : graph.inputs()) { std::ranges::fill(graph.tensorSpan<float>(idx), 0.01F); }
+  scions::cpu::ThreadPool pool(topology);
+
+  for (auto _ : state) {
+    graph.run(pool);
+    benchmark::ClobberMemory();
+  }
+  state.counters["nodes"]   = static_cast<double>(topology.size());
+  state.counters["threads"] = static_cast<double>(pool.size());
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(graph.compactGraph().meta.total));
+}
+
+//! range(0) : tensor width, range(1) : chains
+template<SortOrder objective>
+void BM_WideGraph(benchmark::State &state) {
+  scions::cpu::RuntimeCpuGraph graph(runtimeWide(
+    static_cast<uint32_t>(state.range(0)), static_cast<uint32_t>(state.range(1)), objective));
+  for (const auto idx : graph.inputs()) { std::ranges::fill(graph.tensorSpan<float>(idx), 0.01F); }
+
+  const scions::cpu::_internal::PerfCounters counters;
+  const auto start = counters.read();
+  for (auto _ : state) {
+    graph.run();
+    benchmark::ClobberMemory();
+  }
+  const auto stop = counters.read();
+  if (counters.valid()) {
+    state.counters["llc_misses"] =
+      benchmark::Counter(static_cast<double>(stop[2] - start[2]), benchmark::Counter::kAvgIterations);
+  }
+  state.counters["peak_kb"] = static_cast<double>(graph.compactGraph().meta.peakBytes()) / 1024.0;
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(graph.compactGraph().meta.unplanned));
+}
+}  // namespace
+
+BENCHMARK(BM_GatesScalar)->Name("graph/gates/scalar");
+BENCHMARK(BM_GatesOpByOp)->Name("graph/gates/op_by_op");
+BENCHMARK(BM_GatesBatch)->Name("graph/gates/batch")->RangeMultiplier(16)->Range(1 << 10, 1 << 22);
+BENCHMARK(BM_StaticGraph<Gates>)->Name("graph/gates/exec_cpu_graph");
+BENCHMARK(BM_StaticGraph<Mlp>)->Name("graph/mlp/exec_cpu_graph");
+BENCHMARK(BM_StaticGraph<Reduction>)->Name("graph/reduction/exec_cpu_graph");
+BENCHMARK(BM_Dispatch<Dispatcher::STATIC>)->Name("graph/dispatch/exec_cpu_graph");
+BENCHMARK(BM_Dispatch<Dispatcher::FLAT>)->Name("graph/dispatch/cpu_graph");
+BENCHMARK(BM_Dispatch<Dispatcher::FUNCTION>)->Name("graph/dispatch/std_function");
+BENCHMARK(BM_RuntimeGraph<runtimeMlp>)
+  ->Name("graph/mlp/runtime")
+  ->ArgNames({ "width", "layers" })
+  ->ArgsProduct({ { 1 << 10, 1 << 14 }, { 8, 64 } });
+BENCHMARK(BM_RuntimeGraph<runtimeMlp>)
+  ->Name("graph/mlp/runtime_large")
+  ->ArgNames({ "width", "layers" })
+  ->Args({ 1 << 20, 8 });
+BENCHMARK(BM_RuntimeGraphTiled<runtimeMlp>)
+  ->Name("graph/mlp/runtime_tiled")
+  ->ArgNames({ "width", "layers" })
+  ->ArgsProduct({ { 1 << 14, 1 << 20 }, { 8 } });
+BENCHMARK(BM_GraphStartup<false>)
+  ->Name("graph/mlp/startup_plan")
+  ->ArgNames({ "width", "layers" })
+  ->ArgsProduct({ { 1 << 10 }, { 8, 512 } });
+BENCHMARK(BM_GraphStartup<true>)
+  ->Name("graph/mlp/startup_load")
+  ->ArgNames({ "width", "layers" })
+  ->ArgsProduct({ { 1 << 10 }, { 8, 512 } });
+BENCHMARK(BM_RuntimeGraph<runtimeReduction>)
+  ->Name("graph/reduction/runtime")
+  ->ArgNames({ "width", "leaves" })
+  ->ArgsProduct({ { 1 << 10, 1 << 14 }, { 25, 625 } });
+BENCHMARK(BM_RuntimeGraphTuned<runtimeReduction>)
+  ->Name("graph/reduction/runtime_tuned")
+  ->ArgNames({ "width", "leaves" })
+  ->ArgsProduct({ { 1 << 10, 1 << 14 }, { 25, 625 } });
+BENCHMARK(BM_WideGraph<SortOrder::INDEX>)
+  ->Name("graph/wide/index_order")
+  ->ArgNames({ "width", "chains" })
+  ->ArgsProduct({ { 1 << 12 }, { 16, 256 } });
+BENCHMARK(BM_WideGraph<SortOrder::LOCALITY>)
+  ->Name("graph/wide/locality_order")
+  ->ArgNames({ "width", "chains" })
+  ->ArgsProduct({ { 1 << 12 }, { 16, 256 } });
+BENCHMARK(BM_WideGraph<SortOrder::MEMORY>)
+  ->Name("graph/wide/memory_order")
+  ->ArgNames({ "width", "chains" })
+  ->ArgsProduct({ { 1 << 12 }, { 16, 256 } });
+BENCHMARK(BM_RuntimeGraphPool<runtimeReduction>)
+  ->Name("graph/reduction/runtime_pool")
+  ->ArgNames({ "width", "leaves", "threads" })
+  ->ArgsProduct({ { 1 << 14 }, { 625 }, { 1, 2, 4 } })
+  ->UseRealTime();
+BENCHMARK(BM_RuntimeGraphNuma<runtimeReduction>)
+  ->Name("graph/reduction/runtime_numa")
+  ->ArgNames({ "width", "leaves" })
+  ->Args({ 1 << 14, 625 })
+  ->UseRealTime();
@@ -0,0 +1,153 @@
+#include "scions/ep/cpu/aligned_buffer.hpp"
+#include "scions/ep/cpu/ops/element_wise_cpu.hpp"
+#include "scions/ep/cpu/page_provider.hpp"
+#include <benchmark/benchmark.h>
+#include <numeric>
+#include <random>
+
+//! Micro benchmarks of the runtime length CPU kernels (element_wise_cpu.hpp).
+//!
+//! `range(0)` is the element count of one kernel call. With `Threads(t)` every thread runs the kernel over its own
+//! buffers, items/s and bytes/s are summed over the threads so they show how far the kernel scales before the
+//! threads start fighting over caches and memory bandwidth.
+//!
+//! `pages/walk/*` is TLB bound rather than bandwidth bound : it visits a line of every 4 KiB page of an arena in a
+//! random order, so normal pages miss the dTLB on nearly every load while huge pages cover the arena with a few
+//! entries. NormalPages advises MADV_NOHUGEPAGE, THP "always" mode doesn't turn the normal case into a huge one. The
+//! label is the kind of pages the provider got (scions/common/page_provider.hpp), "advised" ones are only huge when
+//! the kernel had free 2 MiB pages, AnonHugePages in /proc/self/smaps tells.
+
+namespace {
+using namespace scions::cpu;
+
+enum class Kernel : uint8_t { ADD, SUB, MUL, DIV, EXP, SCL_ADD, SCL_SUB, SCL_MUL, SCL_DIV, FILL, COPY };
+
+//! Buffers of a single thread, inputs hold values away from 0 so the div and exp kernels stay finite
+template<typename T>
+struct KernelBuffers {
+  explicit KernelBuffers(const size_t n)
+    : len(n), bytes(allocateAligned(std::max<size_t>(3 * n * sizeof(T), 1))), out(reinterpret_cast<T *>(bytes.get())),
+      in({ out + n, out + 2 * n }) {
+    for (size_t i{}; i < n; i++) {
+      in[0][i] = static_cast<T>(1 + i % 7);
+      in[1][i] = static_cast<T>(1 + i % 5);
+    }
+    std::fill_n(out, n, T{ 1 });
+  }
+
+  size_t len;
+  AlignedBuffer bytes;
+  T *out;
+  std::array<T *, 2> in;
+};
+
+template<typename T, Kernel K>
+void runKernel(KernelBuffers<T> &buf) {
+  const size_t n = buf.len;
+  if constexpr (K == Kernel::ADD) {
+    element_wise_add(buf.out, buf.in, n);
+  } else if constexpr (K == Kernel::SUB) {
+    element_wise_sub(buf.out, buf.in, n);
+  } else if constexpr (K == Kernel::MUL) {
+    element_wise_mul(buf.out, buf.in, n);
+  } else if constexpr (K == Kernel::DIV) {
+    element_wise_div(buf.out, buf.in, n);
+  } else if constexpr (K == Kernel::EXP) {
+    element_wise_exp(buf.out, buf.in[1], n);
+  } else if constexpr (K == Kernel::SCL_ADD) {
+    scalar_add(buf.out, T{ 1 }, n);
+  } else if constexpr (K == Kernel::SCL_SUB) {
+    scalar_sub(buf.out, T{ 1 }, n);
+  } else if constexpr (K == Kernel::SCL_MUL) {
+    // alternates between two values instead of overflowing after a few iterations
+    scalar_mul(buf.out, T{ -1 }, n);
+  } else if constexpr (K == Kernel::SCL_DIV) {
+    scalar_div(buf.out, T{ -1 }, n);
+  } else if constexpr (K == Kernel::FILL) {
+    fill(buf.out, T{ 3 }, n);
+  } else {
+    copy(buf.out, buf.in[0], n);
+  }
+}
+
+//! Tensors read plus written by one call of @tparam K, used for the bytes/s column
+template<Kernel K>
+constexpr size_t kernelStreams() {
+  if constexpr (K == Kernel::FILL) {
+    return 1;
+  } else if constexpr (K == Kernel::EXP || K == Kernel::COPY || K == Kernel::SCL_ADD || K == Kernel::SCL_SUB
+                       || K == Kernel::SCL_MUL || K == Kernel::SCL_DIV) {
+    return 2;
+  } else {
+    return 3;
+  }
+}
+
+template<typename T, Kernel K>
+void BM_Kernel(benchmark::State &state) {
+  const auto n = static_cast<size_t>(state.range(0));
+  KernelBuffers<T> buf(n);
+
+  for (auto _ : state) {
+    runKernel<T, K>(buf);
+    benchmark::DoNotOptimize(buf.out);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n));
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(n * sizeof(T) * kernelStreams<K>()));
+}
+
+//! Pointer chase over one line per 4 KiB page of a `range(0)` MiB arena from @tparam P, a single random cycle
+template<PageProvider P>
+void BM_PageWalk(benchmark::State &state) {
+  constexpr size_t PAGE  = 4096;
+  const size_t pages     = (static_cast<size_t>(state.range(0)) << 20) / PAGE;
+  const PageBuffer arena = P{}.allocate(pages * PAGE);
+  // a different line in every page, so the walk doesn't pile up in a few cache sets
+  const auto slot = [&](const size_t page) { return arena.data() + page * PAGE + page % (PAGE / 64) * 64; };
+
+  std::vector<size_t> order(pages);
+  std::iota(order.begin(), order.end(), size_t{});
+  std::shuffle(order.begin(), order.end(), std::mt19937_64{ 42 });
+  for (size_t i{}; i < pages; i++) {
+    *reinterpret_cast<std::byte **>(slot(order[i])) = slot(order[(i + 1) % pages]);
+  }
+
+  std::byte *next = slot(order[0]);
+  for (auto _ : state) {
+    for (size_t i{}; i < pages; i++) { next = *reinterpret_cast<std::byte **>(next); }
+    benchmark::DoNotOptimize(next);
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(pages));
+  state.SetLabel(std::string(pageKindToString(arena.kind())));
+}
+
+//! 4 KiB to 8 MiB of f32 per tensor, from L1 resident to DRAM bound
+void kernelArgs(benchmark::internal::Benchmark *bench) {
+  bench->RangeMultiplier(8)->Range(1 << 10, 1 << 21)->UseRealTime();
+  for (const int threads : { 1, 2, 4, 8 }) { bench->Threads(threads); }
+}
+}  // namespace
+
+#define SCIONS_KERNEL_BENCH(type, kernel) \
+  BENCHMARK(BM_Kernel<type, Kernel::kernel>)->Name("kernel/" #kernel "/" #type)->Apply(kernelArgs)
+
+#define SCIONS_KERNEL_BENCH_TYPES(kernel) \
+  SCIONS_KERNEL_BENCH(float, kernel);     \
+  SCIONS_KERNEL_BENCH(double, kernel);    \
+  SCIONS_KERNEL_BENCH(int32_t, kernel)
+
+SCIONS_KERNEL_BENCH_TYPES(ADD);
+SCIONS_KERNEL_BENCH_TYPES(SUB);
+SCIONS_KERNEL_BENCH_TYPES(MUL);
+SCIONS_KERNEL_BENCH_TYPES(DIV);
+SCIONS_KERNEL_BENCH_TYPES(EXP);
+SCIONS_KERNEL_BENCH_TYPES(SCL_ADD);
+SCIONS_KERNEL_BENCH_TYPES(SCL_SUB);
+SCIONS_KERNEL_BENCH_TYPES(SCL_MUL);
+SCIONS_KERNEL_BENCH_TYPES(SCL_DIV);
+SCIONS_KERNEL_BENCH_TYPES(FILL);
+SCIONS_KERNEL_BENCH_TYPES(COPY);
+
+BENCHMARK(BM_PageWalk<NormalPages>)->Name("pages/walk/normal")->Arg(64)->Arg(512)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PageWalk<HugePages>)->Name("pages/walk/huge")->Arg(64)->Arg(512)->Unit(benchmark::kMicrosecond);
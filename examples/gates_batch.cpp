@@ -0,0 +1,61 @@
+#include "manifold/ops/element_wise_ops.hpp"
+#include "manifold/ops/special_ops.hpp"
+#include "manifold/static_graph.hpp"
+#include "manifold/tensor.hpp"
+#include "scions/ep/cpu/batch_graph.hpp"
+#include "scions/ep/cpu/scalar_graph.hpp"
+#include <chrono>
+#include <print>
+#include <vector>
+
+// Same gate network as gates_v3, evaluated for many independent samples
+
+[[nodiscard]] consteval auto graphGen() {
+  using namespace manifold;
+
+  const auto v1 = Scalar<DType::F32>(0);
+  const auto v2 = Scalar<DType::F32>(1);
+  const auto v3 = Scalar<DType::F32>(2);
+  const auto v4 = Scalar<DType::F32>(3);
+
+  const auto exp        = op::exp(4, v2, v1);
+  const auto copy_v2_v3 = op::copy(5, v3, v2);
+  const auto add_2      = op::elm_add(6, v3, 1.0F);
+  const auto group      = op::exp_group(7, std::array{ copy_v2_v3, add_2 }, true);
+  const auto mul        = op::elm_mul(8, v4, std::array{ v2, v3 });
+
+  const auto container = SymbolContainer{ std::array{ v1.reflect(), v2.reflect(), v3.reflect(), v4.reflect() },
+    std::array{ exp, group, mul, add_2, copy_v2_v3 } };
+
+  return container.to_dag();
+}
+
+int main() {
+  using namespace std::chrono;
+  static constexpr auto graph   = graphGen().topologicalSort();
+  static constexpr auto meta    = manifold::graphMetadata(graph);
+  static constexpr auto compact = manifold::compact<meta>(graph);
+
+  constexpr size_t samples = 1 << 22;
+  std::vector<float> inputs(samples);
+  for (size_t i{}; i < samples; i++) { inputs[i] = static_cast<float>(i % 1024) / 1024.0F; }
+
+  // One sample at a time through the straight line path
+  float checksum{};
+  auto start = high_resolution_clock::now();
+  for (const float val : inputs) { checksum += scions::cpu::exec_scalar_graph<compact>({ val })[0]; }
+  const duration<double> single = high_resolution_clock::now() - start;
+
+  // Whole batch at once, every op runs over all the samples
+  scions::cpu::BatchExecutor<compact> executor(samples);
+  start                        = high_resolution_clock::now();
+  const auto outputs           = executor.run<float>({ std::span<const float>(inputs) });
+  const duration<double> batch = high_resolution_clock::now() - start;
+
+  float batch_checksum{};
+  for (const float val : outputs[0]) { batch_checksum += val; }
+
+  std::print("samples        : {}\n", samples);
+  std::print("single sample  : {:.3e} samples/s (checksum {})\n", samples / single.count(), checksum);
+  std::print("batched        : {:.3e} samples/s (checksum {})\n", samples / batch.count(), batch_checksum);
+}
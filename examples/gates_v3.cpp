@@ -4,6 +4,7 @@
 #include "manifold/ops/special_ops.hpp"
 #include "manifold/static_graph.hpp"
 #include "manifold/tensor.hpp"
+#include "scions/ep/cpu/scalar_graph.hpp"
 #include <array>
 #include <print>
 
@@ -49,4 +50,10 @@ int main() {
 
   std::print("{}", graph.toDot());
   std::ranges::for_each(io.in_tensor_idxs, [](auto i){std::print("{}",i);});
+
+  // Every tensor is a Scalar, so the whole graph runs as straight line code on registers
+  static constexpr auto meta    = graphMetadata(graph);
+  static constexpr auto compact = manifold::compact<meta>(graph);
+  const auto outputs            = scions::cpu::exec_scalar_graph<compact>({ 1.0F });
+  std::print("\nv4 = {}\n", outputs[0]);
 }
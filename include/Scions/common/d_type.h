@@ -2,6 +2,7 @@
 // Created by sid on 20/10/23.
 //
 #pragma once
+#include <cstddef>
 #include <cstdint>
 
 namespace scions::d_type {
@@ -15,6 +16,9 @@ enum TYPE {
   F64,
 };
 
+//! Number of entries of TYPE, size of tables indexed by it
+constexpr size_t TYPE_COUNT = F64 + 1;
+
 constexpr uint8_t getDTypeSizeBytes(const TYPE t) {
   switch (t) {
   case INT8: return sizeof(int8_t);
@@ -14,7 +14,7 @@ public:
     : OpDesc(MEM_COPY_OP_ID, input, output, "Memory Copy Op") {}
 
   constexpr MemCopy(const size_t &input1, const size_t &output)
-    : OpDesc(MEM_COPY_OP_ID, { input1 }, { output }, "Memory Copy Op") {}
+    : OpDesc(MEM_COPY_OP_ID, { input1 + 1 }, { output + 1 }, "Memory Copy Op") {}
 };
 
 class MemFillRandom : public OpDesc {
@@ -24,7 +24,7 @@ public:
     : OpDesc(MEM_FILL_RANDOM_OP_ID, input, output, "Memory Fill Random Op") {}
 
   constexpr MemFillRandom(const size_t &input1, const size_t &output)
-    : OpDesc(MEM_FILL_RANDOM_OP_ID, { input1 }, { output }, "Memory Fill Random Op") {}
+    : OpDesc(MEM_FILL_RANDOM_OP_ID, { input1 + 1 }, { output + 1 }, "Memory Fill Random Op") {}
 };
 
 class MemFree : public OpDesc {
@@ -34,7 +34,7 @@ public:
     : OpDesc(MEM_FREE_OP_ID, input, output, "Memory Free Op") {}
 
   constexpr MemFree(const size_t &input1, const size_t &output)
-    : OpDesc(MEM_FREE_OP_ID, { input1 }, { output }, "Memory Free Op") {}
+    : OpDesc(MEM_FREE_OP_ID, { input1 + 1 }, { output + 1 }, "Memory Free Op") {}
 };
 
 }  // namespace scions::op::mem
@@ -35,7 +35,8 @@ public:
    * @param desc The description of the operation.
    */
   constexpr OpDesc(int32_t id, OpIOIndicesInfo info_, const std::string_view &desc)
-    : op_id(id), op_desc(desc), info(info_) {}
+    : op_id(id), info(info_), num_inputs(countIndices(info_.inputs)), num_outputs(countIndices(info_.outputs)),
+      op_desc(desc) {}
 
   /**
    * @brief Constructs an OpDesc object.
@@ -51,10 +52,7 @@ public:
     const std::array<const size_t, SC_OP_INPUT_MAX> &inp,
     const std::array<const size_t, SC_OP_OUTPUT_MAX> &out,
     const std::string_view &desc)
-    : op_id(id), op_desc(desc), info({ inp, out }) {
-    num_inputs  = std::distance(inp.begin(), std::ranges::find(inp, 0)) + 1;
-    num_outputs = std::distance(out.begin(), std::ranges::find(out, 0)) + 1;
-  }
+    : op_id(id), info({ inp, out }), num_inputs(countIndices(inp)), num_outputs(countIndices(out)), op_desc(desc) {}
 
   /**
    * @brief Returns the description of the operation.
@@ -66,6 +64,14 @@ public:
   constexpr std::string_view getDesc() { return op_desc; }
 
 private:
+  /**
+   * @brief Number of indices before the first unused (0) slot, indices are 1 based (see OpIOIndicesInfo).
+   */
+  template<size_t N>
+  static constexpr uint64_t countIndices(const std::array<const size_t, N> &indices) {
+    return static_cast<uint64_t>(std::distance(indices.begin(), std::ranges::find(indices, 0)));
+  }
+
   const std::string_view op_desc;
 };
 
@@ -12,8 +12,8 @@
 namespace scions::graph {
 class RuntimeSequentialGraph {
 public:
-  RuntimeSequentialGraph(std::span<const mem::MemObject> &mem_span,
-    std::span<const op::OpDesc> &op_span,
+  RuntimeSequentialGraph(std::span<const mem::MemObject> mem_span,
+    std::span<const op::OpDesc> op_span,
     uint64_t memory_size);
 
   template<size_t Ops, size_t Mem>
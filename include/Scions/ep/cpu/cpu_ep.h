@@ -8,11 +8,11 @@
 #include "Scions/ep/common/common.h"
 #include "Scions/ep/common/runtime_sequential_graph.h"
 #include "Scions/ep/cpu/mem/mem_manager.h"
+#include "Scions/ep/cpu/mem/runtime_mem_manager.h"
 #include "cpu_execution_stats.h"
-#include "mkl.h"
 #include "op/execute_op.h"
 
-constexpr std::string formatBytes(const size_t bytes) {
+inline std::string formatBytes(const size_t bytes) {
   constexpr std::array units{ "b", "KiB", "MiB", "GiB", "TiB" };
   size_t i    = 0;
   double size = static_cast<double>(bytes);
@@ -47,7 +47,6 @@ public:
 
   // Todo: Constructor without manger passed in
 
-  template<>
   std::expected<CPUExecutionStats, std::string> executeGraph() {
     using namespace std::chrono;
     const auto start = high_resolution_clock::now();
@@ -64,4 +63,44 @@ private:
   const CPUOptions options;
 };
 
+/**
+ * @class CPURuntimeExecutionProvider
+ * @brief Runs a RuntimeSequentialGraph, ie. a graph whose ops and memory objects are only known at runtime.
+ *
+ *     graph::RuntimeSequentialGraph graph(mem_span, op_span, total_bytes);
+ *     cpu::RuntimeCpuMemoryManager manager(graph);
+ *     auto stats = cpu::CPURuntimeExecutionProvider(graph, manager, {}).executeGraph();
+ */
+class CPURuntimeExecutionProvider {
+public:
+  [[nodiscard]] CPURuntimeExecutionProvider(const graph::RuntimeSequentialGraph &graph_,
+    RuntimeCpuMemoryManager &manager_,
+    const CPUOptions &options_)
+    : graph(graph_), manager(manager_), options(options_) {
+    if (manager.mem_refs.size() != graph.mem_objects.size()) {
+      throw std::invalid_argument(fmt::format("CPU EP: memory manager holds {} objects for a graph of {}",
+        manager.mem_refs.size(),
+        graph.mem_objects.size()));
+    }
+  }
+
+  std::expected<CPUExecutionStats, std::string> executeGraph() {
+    using namespace std::chrono;
+    const auto start = high_resolution_clock::now();
+
+    try {
+      for (const op::OpDesc &op : graph.ops) { executeOp(op, manager); }
+    } catch (const std::runtime_error &err) {
+      return std::unexpected(std::string(err.what()));
+    }
+    const auto end = high_resolution_clock::now();
+    return CPUExecutionStats{ duration_cast<microseconds>(end - start) };
+  }
+
+private:
+  const graph::RuntimeSequentialGraph graph;
+  RuntimeCpuMemoryManager &manager;
+  const CPUOptions options;
+};
+
 }  // namespace scions::ep::cpu
@@ -5,8 +5,18 @@
 
 #include "Scions/core/mem/mem_desc.h"
 #include "Scions/ep/common/common.h"
+#include "scions/common/page_provider.hpp"
+#include <cstring>
 
 namespace scions::ep::cpu {
+// page providers shared with the v2 CPU EP (scions/common/page_provider.hpp)
+using mem::HugePages;
+using mem::NormalPages;
+using mem::PageBuffer;
+using mem::PageKind;
+using mem::PageProvider;
+using mem::pageKindToString;
+
 namespace _internal {
   struct CpuMemRef {
     std::span<uint8_t> memory_bytes_ref;
@@ -16,16 +26,23 @@ namespace _internal {
   };
 }  // namespace _internal
 
-template<size_t Mem, uint64_t StaticSize>
+// Pages : where the static memory comes from, huge pages when the system has some (scions/common/page_provider.hpp)
+template<size_t Mem, uint64_t StaticSize, PageProvider Pages = HugePages>
 class CpuMemoryManager {
+  PageBuffer pages;
+
 public:
-  std::array<uint8_t, StaticSize> static_memory;
+  std::span<uint8_t, StaticSize> static_memory;
 
   std::vector<_internal::CpuMemRef> mem_refs;
   // Not used as of now
   // std::vector<std::shared_ptr<uint8_t[]>> dynamic_memory;
 
-  CpuMemoryManager(const mem::MemDescriptor<Mem> d_) : descriptor(d_), static_memory() {
+  CpuMemoryManager(const mem::MemDescriptor<Mem> d_, const Pages &provider = {})
+    : pages(provider.allocate(std::max<uint64_t>(StaticSize, 1))),
+      static_memory(reinterpret_cast<uint8_t *>(pages.data()), StaticSize), descriptor(d_) {
+    // mapped pages come zeroed
+    if (pages.kind() == PageKind::NORMAL) { std::memset(pages.data(), 0, pages.size()); }
     mem_refs.reserve(descriptor.memoryObjects.size());
     for (size_t i = 0; const mem::MemObject &obj : descriptor.memoryObjects) {
       const auto ref_span   = std::span<uint8_t>(static_memory.begin() + obj.offset, obj.bytes);
@@ -46,6 +63,8 @@ public:
 
   _internal::CpuMemRef getMemRef(size_t index) const { return mem_refs.at(index); }
 
+  [[nodiscard]] PageKind pageKind() const noexcept { return pages.kind(); }
+
 private:
   const mem::MemDescriptor<Mem> descriptor;
 };
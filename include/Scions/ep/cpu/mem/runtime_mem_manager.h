@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Scions/core/mem/mem_object.h"
+#include "Scions/ep/common/common.h"
+#include "Scions/ep/common/runtime_sequential_graph.h"
+#include "mem_manager.h"
+#include <cstring>
+#include <memory>
+#include <new>
+
+namespace scions::ep::cpu {
+struct CpuMemOptions {
+  // alignment (bytes) of the start of the region, a power of two
+  size_t alignment = 64;
+  // back the region with huge pages (hugetlb, then transparent ones, see scions/common/page_provider.hpp), falls back
+  // to an aligned heap allocation
+  bool huge_pages = false;
+};
+
+/**
+ * @class RuntimeCpuMemoryManager
+ * @brief Memory of a RuntimeSequentialGraph, a single heap or mmap region sized at runtime.
+ *
+ * Unlike CpuMemoryManager nothing is sized at compile time and the region never lives on the stack, a graph
+ * loaded at runtime gets its memory without recompiling.
+ */
+class RuntimeCpuMemoryManager {
+public:
+  std::vector<_internal::CpuMemRef> mem_refs;
+
+  explicit RuntimeCpuMemoryManager(const graph::RuntimeSequentialGraph &graph, const CpuMemOptions &options = {})
+    : bytes(std::max<uint64_t>(graph.total_memory_size, 1)) {
+    if (options.alignment == 0 || (options.alignment & (options.alignment - 1)) != 0) {
+      throw std::invalid_argument("RuntimeCpuMemoryManager: alignment has to be a power of two");
+    }
+    allocate(options);
+
+    mem_refs.reserve(graph.mem_objects.size());
+    for (const mem::MemObject &obj : graph.mem_objects) {
+      if (obj.offset + obj.bytes > graph.total_memory_size) {
+        throw std::runtime_error(fmt::format(
+          "RuntimeCpuMemoryManager: memory object \"{}\" ends past the {} bytes of the graph", obj.name, bytes));
+      }
+      const auto ref_span   = std::span<uint8_t>(memory + obj.offset, obj.bytes);
+      const auto shape_span = std::span(obj.shape.begin(), obj.dimension);
+      mem_refs.emplace_back(ref_span, obj.type, shape_span, obj.dimension);
+    }
+  }
+
+  RuntimeCpuMemoryManager(const RuntimeCpuMemoryManager &)            = delete;
+  RuntimeCpuMemoryManager &operator=(const RuntimeCpuMemoryManager &) = delete;
+
+  template<typename T>
+  std::span<T> getSpan(size_t index) {
+    const std::span<uint8_t> ref = mem_refs.at(index).memory_bytes_ref;
+    return std::span<T>(reinterpret_cast<T *>(ref.data()), ref.size() / sizeof(T));
+  }
+
+  _internal::CpuMemRef getMemRef(size_t index) const { return mem_refs.at(index); }
+
+  [[nodiscard]] uint64_t totalBytes() const noexcept { return bytes; }
+
+  // True if the region got huge pages, hugetlb ones or transparent ones requested
+  [[nodiscard]] bool usesHugePages() const noexcept { return pageKind() != PageKind::NORMAL; }
+
+  [[nodiscard]] PageKind pageKind() const noexcept { return pages.kind(); }
+
+private:
+  // Frees the heap region, a member so the region is released when the constructor throws after allocating it
+  struct AlignedDelete {
+    size_t alignment;
+
+    void operator()(uint8_t *ptr) const noexcept { ::operator delete[](ptr, std::align_val_t{ alignment }); }
+  };
+
+  void allocate(const CpuMemOptions &options) {
+    if (options.huge_pages) {
+      // mapped pages are page aligned and zeroed, the heap fallback below honours the alignment
+      PageBuffer buffer = HugePages{}.allocate(bytes);
+      const bool aligned             = reinterpret_cast<uintptr_t>(buffer.data()) % options.alignment == 0;
+      if (buffer.kind() != PageKind::NORMAL && aligned) {
+        pages  = std::move(buffer);
+        memory = reinterpret_cast<uint8_t *>(pages.data());
+        return;
+      }
+    }
+    heap = std::unique_ptr<uint8_t[], AlignedDelete>(
+      static_cast<uint8_t *>(::operator new[](bytes, std::align_val_t{ options.alignment })),
+      AlignedDelete{ options.alignment });
+    memory = heap.get();
+    // zeroed like the static memory of CpuMemoryManager and fresh anonymous mappings
+    std::memset(memory, 0, bytes);
+  }
+
+  uint64_t bytes;
+  uint8_t *memory = nullptr;
+  // owns the region, one of them is empty
+  PageBuffer pages;
+  std::unique_ptr<uint8_t[], AlignedDelete> heap{ nullptr, AlignedDelete{ 0 } };
+};
+}  // namespace scions::ep::cpu
@@ -8,17 +8,41 @@
 #include "tensor_ops.h"
 
 namespace scions::ep::cpu {
-template<size_t Mem, uint64_t Size>
-inline void executeOp(const op::OpDesc &op, CpuMemoryManager<Mem, Size> &manager) {
-  using namespace scions::op::tensor;
-
-  switch (op.op_id) {
-  case TENSOR_ADD_OP_ID: _internal::tensorAdd(op, manager); break;
-  case TENSOR_MULTIPLY_OP_ID: _internal::tensorMul(op, manager); break;
-  default:
+// Runs @param op on the memory objects @param refs, indexed like the memory descriptor of the graph
+inline void executeOp(const op::OpDesc &op, std::span<const _internal::CpuMemRef> refs) {
+  const size_t slot = _internal::kernelSlot(op.op_id);
+  if (slot == _internal::OP_COUNT || op.num_inputs == 0 || op.num_outputs == 0) {
     print(fg(fmt::color::blue_violet), "CPU EP: ");
     fmt::print("Op ID \"{}\" Either not implemented in CPU EP or does not exist\n", op.op_id);
     throw std::runtime_error("Cpu EP: OP not found");
   }
+
+  // every operand has to be a memory object of the same data type, indices are 1 based
+  auto checkOperand = [&](const size_t index) -> const _internal::CpuMemRef & {
+    if (index == 0 || index > refs.size()) {
+      throw std::runtime_error(
+        fmt::format("Cpu EP: Op \"{}\" uses memory object {} out of {}", op.op_id, index, refs.size()));
+    }
+    return refs[index - 1];
+  };
+  const d_type::TYPE type = checkOperand(op.info.outputs[0]).type;
+  auto checkType          = [&](const size_t index) {
+    if (checkOperand(index).type != type) { throw std::runtime_error("Cpu EP: Op operands have different data types"); }
+  };
+  for (size_t j = 0; j < op.num_inputs; j++) { checkType(op.info.inputs[j]); }
+  for (size_t j = 1; j < op.num_outputs; j++) { checkType(op.info.outputs[j]); }
+
+  const _internal::Kernel kernel = _internal::KERNELS[slot][type];
+  if (kernel == nullptr) {
+    throw std::runtime_error(
+      fmt::format("Cpu EP: Op \"{}\" has no kernel for data type {}", op.op_id, static_cast<int>(type)));
+  }
+  kernel(op, refs);
+}
+
+// Works with CpuMemoryManager and RuntimeCpuMemoryManager
+template<typename Manager>
+inline void executeOp(const op::OpDesc &op, Manager &manager) {
+  executeOp(op, std::span<const _internal::CpuMemRef>(manager.mem_refs));
 }
 }  // namespace scions::ep::cpu
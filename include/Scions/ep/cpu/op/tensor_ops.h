@@ -3,40 +3,238 @@
 //
 #pragma once
 
+#include "Scions/common/d_type.h"
 #include "Scions/core/op/op.h"
+#include "Scions/core/op/op_ids.h"
 #include "Scions/ep/common/common.h"
 #include "Scions/ep/cpu/mem/mem_manager.h"
+#include <cmath>
+#include <cstring>
+#include <random>
+
+// Kernels of the CPU EP. Every op is a struct with a `run<T>` for each supported data type, the table
+// built from them (see kernelTable) is indexed by op and d_type::TYPE so executeOp does a single lookup.
+// Buffers may alias (out == in), element wise kernels read every input of element i before writing it.
 
 namespace scions::ep::cpu::_internal {
-template<size_t Mem, uint64_t Size>
-void tensorAdd(const op::OpDesc &desc, CpuMemoryManager<Mem, Size> &manager) {
-  auto &inputs          = desc.info.inputs;
-  auto &outputs         = desc.info.outputs;
-  const auto numInputs  = desc.num_inputs;
-  const auto numOutputs = desc.num_outputs;
+using Kernel = void (*)(const op::OpDesc &, std::span<const CpuMemRef>);
+
+template<typename T>
+std::span<T> typedSpan(const CpuMemRef &ref) {
+  return std::span<T>(reinterpret_cast<T *>(ref.memory_bytes_ref.data()), ref.memory_bytes_ref.size() / sizeof(T));
+}
+
+// Op indices are 1 based
+inline const CpuMemRef &inputRef(const op::OpDesc &desc, std::span<const CpuMemRef> refs, size_t j) {
+  return refs[desc.info.inputs[j] - 1];
+}
+
+inline const CpuMemRef &outputRef(const op::OpDesc &desc, std::span<const CpuMemRef> refs, size_t j) {
+  return refs[desc.info.outputs[j] - 1];
+}
 
-  if (numInputs == 2 && numOutputs == 1) {
-    const CpuMemRef &one_ref = manager.mem_refs.at(inputs[0]);
-    const CpuMemRef &two_ref = manager.mem_refs.at(inputs[1]);
-    const CpuMemRef &out_ref = manager.mem_refs.at(outputs[0]);
+inline void checkSameSize(const CpuMemRef &ref, const CpuMemRef &out) {
+  if (ref.memory_bytes_ref.size() != out.memory_bytes_ref.size()) {
+    throw std::runtime_error(fmt::format("Cpu EP: element wise op on buffers of {} and {} bytes",
+      ref.memory_bytes_ref.size(),
+      out.memory_bytes_ref.size()));
   }
 }
 
-template<size_t Mem, uint64_t Size>
-void tensorMul(const op::OpDesc &desc, CpuMemoryManager<Mem, Size> &manager) {
-  auto &inputs  = desc.info.inputs;
-  auto &outputs = desc.info.outputs;
+// out = in_0 OP in_1 OP ... in_n, left to right
+template<typename T, typename Fn>
+void foldInputs(const op::OpDesc &desc, std::span<const CpuMemRef> refs, Fn fn) {
+  const CpuMemRef &out_ref = outputRef(desc, refs, 0);
+  for (size_t j = 0; j < desc.num_inputs; j++) { checkSameSize(inputRef(desc, refs, j), out_ref); }
+
+  const std::span<T> out = typedSpan<T>(out_ref);
+  const std::span<T> lhs = typedSpan<T>(inputRef(desc, refs, 0));
+  if (desc.num_inputs == 1) {
+    std::copy(lhs.begin(), lhs.end(), out.begin());
+    return;
+  }
+
+  const std::span<T> rhs = typedSpan<T>(inputRef(desc, refs, 1));
+  if (desc.num_inputs == 2) {
+    for (size_t i = 0; i < out.size(); i++) { out[i] = fn(lhs[i], rhs[i]); }
+    return;
+  }
+
+  std::array<std::span<T>, SC_OP_INPUT_MAX> rest{};
+  for (size_t j = 2; j < desc.num_inputs; j++) { rest[j] = typedSpan<T>(inputRef(desc, refs, j)); }
+
+  // out may alias any input, accumulate element by element
+  for (size_t i = 0; i < out.size(); i++) {
+    T acc = fn(lhs[i], rhs[i]);
+    for (size_t j = 2; j < desc.num_inputs; j++) { acc = fn(acc, rest[j][i]); }
+    out[i] = acc;
+  }
+}
+
+template<typename T, typename Fn>
+void mapInput(const op::OpDesc &desc, std::span<const CpuMemRef> refs, Fn fn) {
+  const CpuMemRef &in_ref  = inputRef(desc, refs, 0);
+  const CpuMemRef &out_ref = outputRef(desc, refs, 0);
+  checkSameSize(in_ref, out_ref);
+
+  const std::span<T> in  = typedSpan<T>(in_ref);
+  const std::span<T> out = typedSpan<T>(out_ref);
+  for (size_t i = 0; i < out.size(); i++) { out[i] = fn(in[i]); }
+}
+
+// Math functions of integer tensors go through double
+template<typename T>
+T viaDouble(double value) {
+  return static_cast<T>(value);
+}
+
+struct Add {
+  template<typename T>
+  static void run(const op::OpDesc &desc, std::span<const CpuMemRef> refs) {
+    foldInputs<T>(desc, refs, [](T a, T b) { return static_cast<T>(a + b); });
+  }
+};
+
+struct Subtract {
+  template<typename T>
+  static void run(const op::OpDesc &desc, std::span<const CpuMemRef> refs) {
+    foldInputs<T>(desc, refs, [](T a, T b) { return static_cast<T>(a - b); });
+  }
+};
+
+struct Multiply {
+  template<typename T>
+  static void run(const op::OpDesc &desc, std::span<const CpuMemRef> refs) {
+    foldInputs<T>(desc, refs, [](T a, T b) { return static_cast<T>(a * b); });
+  }
+};
+
+struct Divide {
+  template<typename T>
+  static void run(const op::OpDesc &desc, std::span<const CpuMemRef> refs) {
+    foldInputs<T>(desc, refs, [](T a, T b) { return static_cast<T>(a / b); });
+  }
+};
+
+// out = in_0 ^ in_1, element wise
+struct Exponentiate {
+  template<typename T>
+  static void run(const op::OpDesc &desc, std::span<const CpuMemRef> refs) {
+    foldInputs<T>(desc, refs, [](T a, T b) { return viaDouble<T>(std::pow(a, b)); });
+  }
+};
+
+struct Log {
+  template<typename T>
+  static void run(const op::OpDesc &desc, std::span<const CpuMemRef> refs) {
+    mapInput<T>(desc, refs, [](T a) { return viaDouble<T>(std::log(a)); });
+  }
+};
+
+struct SquareRoot {
+  template<typename T>
+  static void run(const op::OpDesc &desc, std::span<const CpuMemRef> refs) {
+    mapInput<T>(desc, refs, [](T a) { return viaDouble<T>(std::sqrt(a)); });
+  }
+};
+
+// Every output element is the mean of an equal, contiguous run of input elements: a single element output
+// is the mean of the whole tensor, an output of `rows` elements the mean of each row of the input
+struct Mean {
+  template<typename T>
+  static void run(const op::OpDesc &desc, std::span<const CpuMemRef> refs) {
+    const std::span<T> in  = typedSpan<T>(inputRef(desc, refs, 0));
+    const std::span<T> out = typedSpan<T>(outputRef(desc, refs, 0));
+    if (out.empty() || in.size() % out.size() != 0) {
+      throw std::runtime_error(
+        fmt::format("Cpu EP: Mean of {} elements can't be split in {} outputs", in.size(), out.size()));
+    }
 
-  fmt::print("Inputs :");
-  for (size_t input : inputs) {
-    if (input) fmt::print(" {} ", input);
+    const size_t run = in.size() / out.size();
+    for (size_t i = 0; i < out.size(); i++) {
+      double sum = 0;
+      for (size_t k = i * run; k < (i + 1) * run; k++) { sum += static_cast<double>(in[k]); }
+      out[i] = static_cast<T>(sum / static_cast<double>(run));
+    }
   }
-  fmt::print("\n");
+};
 
-  fmt::print("Outputs :");
-  for (size_t output : outputs) {
-    if (output) fmt::print(" {} ", output);
+struct Copy {
+  template<typename T>
+  static void run(const op::OpDesc &desc, std::span<const CpuMemRef> refs) {
+    const CpuMemRef &in_ref  = inputRef(desc, refs, 0);
+    const CpuMemRef &out_ref = outputRef(desc, refs, 0);
+    checkSameSize(in_ref, out_ref);
+    std::memmove(out_ref.memory_bytes_ref.data(), in_ref.memory_bytes_ref.data(), out_ref.memory_bytes_ref.size());
   }
-  fmt::print("\n");
+};
+
+// Uniform values in [0, 1) for floating point tensors and [0, 100] for integer ones
+struct FillRandom {
+  template<typename T>
+  static void run(const op::OpDesc &desc, std::span<const CpuMemRef> refs) {
+    thread_local std::mt19937_64 engine{ std::random_device{}() };
+    for (size_t j = 0; j < desc.num_outputs; j++) {
+      const std::span<T> out = typedSpan<T>(outputRef(desc, refs, j));
+      if constexpr (std::is_floating_point_v<T>) {
+        std::uniform_real_distribution<T> dist(0, 1);
+        for (T &val : out) { val = dist(engine); }
+      } else {
+        std::uniform_int_distribution<int64_t> dist(0, 100);
+        for (T &val : out) { val = static_cast<T>(dist(engine)); }
+      }
+    }
+  }
+};
+
+// Memory is owned by the CpuMemoryManager for the whole graph, nothing to release
+struct Free {
+  template<typename T>
+  static void run(const op::OpDesc &, std::span<const CpuMemRef>) {}
+};
+
+// Kernels of OP for every d_type::TYPE, F16 has no CPU arithmetic type so it has none
+template<typename OP>
+constexpr std::array<Kernel, d_type::TYPE_COUNT> typedKernels() {
+  std::array<Kernel, d_type::TYPE_COUNT> kernels{};
+  kernels[d_type::INT8]  = &OP::template run<int8_t>;
+  kernels[d_type::INT16] = &OP::template run<int16_t>;
+  kernels[d_type::INT32] = &OP::template run<int32_t>;
+  kernels[d_type::INT64] = &OP::template run<int64_t>;
+  kernels[d_type::F32]   = &OP::template run<float>;
+  kernels[d_type::F64]   = &OP::template run<double>;
+  return kernels;
 }
+
+// Tensor ops (ids 1 to 8) come first, then memory ops (ids -1 to -3)
+constexpr size_t TENSOR_OP_COUNT = 8;
+constexpr size_t MEM_OP_COUNT    = 3;
+constexpr size_t OP_COUNT        = TENSOR_OP_COUNT + MEM_OP_COUNT;
+
+// Row of @param op_id in the kernel table, OP_COUNT if the op doesn't exist
+constexpr size_t kernelSlot(int32_t op_id) {
+  if (op_id >= 1 && op_id <= static_cast<int32_t>(TENSOR_OP_COUNT)) { return static_cast<size_t>(op_id - 1); }
+  if (op_id <= -1 && op_id >= -static_cast<int32_t>(MEM_OP_COUNT)) {
+    return TENSOR_OP_COUNT + static_cast<size_t>(-op_id - 1);
+  }
+  return OP_COUNT;
+}
+
+constexpr std::array<std::array<Kernel, d_type::TYPE_COUNT>, OP_COUNT> kernelTable() {
+  std::array<std::array<Kernel, d_type::TYPE_COUNT>, OP_COUNT> table{};
+  table[kernelSlot(op::tensor::TENSOR_ADD_OP_ID)]            = typedKernels<Add>();
+  table[kernelSlot(op::tensor::TENSOR_SUBTRACT_OP_ID)]       = typedKernels<Subtract>();
+  table[kernelSlot(op::tensor::TENSOR_MULTIPLY_OP_ID)]       = typedKernels<Multiply>();
+  table[kernelSlot(op::tensor::TENSOR_DIVIDE_OP_ID)]         = typedKernels<Divide>();
+  table[kernelSlot(op::tensor::TENSOR_EXPONENTIATION_OP_ID)] = typedKernels<Exponentiate>();
+  table[kernelSlot(op::tensor::TENSOR_LOG_OP_ID)]            = typedKernels<Log>();
+  table[kernelSlot(op::tensor::TENSOR_SQUARE_ROOT_OP_ID)]    = typedKernels<SquareRoot>();
+  table[kernelSlot(op::tensor::TENSOR_MEAN_OP_ID)]           = typedKernels<Mean>();
+  table[kernelSlot(op::mem::MEM_COPY_OP_ID)]                 = typedKernels<Copy>();
+  table[kernelSlot(op::mem::MEM_FILL_RANDOM_OP_ID)]          = typedKernels<FillRandom>();
+  table[kernelSlot(op::mem::MEM_FREE_OP_ID)]                 = typedKernels<Free>();
+  return table;
+}
+
+inline constexpr auto KERNELS = kernelTable();
 }  // namespace scions::ep::cpu::_internal
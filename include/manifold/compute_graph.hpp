@@ -9,10 +9,17 @@
 #include <tuple>
 
 namespace manifold {
-template<size_t TSize, size_t ESize, size_t InSize, size_t OutSize>
+template<size_t TSize,
+  size_t ESize,
+  size_t InSize,
+  size_t OutSize,
+  size_t OSize = ESize * EXPR_OPERANDS_MAX,
+  size_t PSize = ESize * MANIFOLD_PARAM_BYTES_MAX>
 struct ComputeGraph {
   std::array<TensorNode, TSize> data;
   std::array<ExprEdge, ESize> edges;
+  typename StaticDAG<TSize, ESize, OSize, PSize>::OPERAND_TYPE operands;
+  typename StaticDAG<TSize, ESize, OSize, PSize>::PARAM_TYPE params;
   std::array<uint32_t, InSize> in_ids;
   std::array<uint32_t, OutSize> out_ids;
 
@@ -20,22 +27,24 @@ struct ComputeGraph {
   //! in the @param _data
   constexpr ComputeGraph(const std::array<TensorNode, TSize> &_data,
     const std::array<ExprEdge, ESize> &_edges,
+    const typename StaticDAG<TSize, ESize, OSize, PSize>::OPERAND_TYPE &_operands,
+    const typename StaticDAG<TSize, ESize, OSize, PSize>::PARAM_TYPE &_params,
     const std::array<uint32_t, InSize> &_in_data,
     const std::array<uint32_t, OutSize> &_out_data)
-    : data(_data), edges(_edges), in_ids(_in_data), out_ids(_out_data) {}
+    : data(_data), edges(_edges), operands(_operands), params(_params), in_ids(_in_data), out_ids(_out_data) {}
  //! @param dag : Subgraph generated for the specific @param _out_data, can be done using
   //! @StaticDAG::subgraph or @StaticDAG::subgraphByIdx
   //!
   //! Note: Here **in_data** and **out_data** is actual index of the Tensors that are
   //! in the @dag.data
-  constexpr ComputeGraph(const StaticDAG<TSize, ESize> &dag,
+  constexpr ComputeGraph(const StaticDAG<TSize, ESize, OSize, PSize> &dag,
     const std::array<uint32_t, InSize> &_in_data,
     const std::array<uint32_t, OutSize> &_out_data)
-    : ComputeGraph(dag.data, dag.edges, _in_data, _out_data) {}
+    : ComputeGraph(dag.data, dag.edges, dag.operands, dag.params, _in_data, _out_data) {}
 
 
-  constexpr ComputeGraph(const StaticDAG<TSize, ESize> &dag, const DagIOIdx<InSize, OutSize> &dag_io)
-    : ComputeGraph(dag.data, dag.edges, dag_io.in_tensor_idxs, dag_io.out_tensor_idxs) {}
+  constexpr ComputeGraph(const StaticDAG<TSize, ESize, OSize, PSize> &dag, const DagIOIdx<InSize, OutSize> &dag_io)
+    : ComputeGraph(dag.data, dag.edges, dag.operands, dag.params, dag_io.in_tensor_idxs, dag_io.out_tensor_idxs) {}
 
 
   constexpr void partialAdj(){
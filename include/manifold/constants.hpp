@@ -45,6 +45,36 @@ template<>
 struct DTypeToPrimitive<DType::UINT16> {
   using type = uint16_t;
 };
+
+template<>
+struct DTypeToPrimitive<DType::UINT32> {
+  using type = uint32_t;
+};
+
+template<>
+struct DTypeToPrimitive<DType::UINT64> {
+  using type = uint64_t;
+};
+
+template<>
+struct DTypeToPrimitive<DType::INT8> {
+  using type = int8_t;
+};
+
+template<>
+struct DTypeToPrimitive<DType::INT16> {
+  using type = int16_t;
+};
+
+template<>
+struct DTypeToPrimitive<DType::INT32> {
+  using type = int32_t;
+};
+
+template<>
+struct DTypeToPrimitive<DType::INT64> {
+  using type = int64_t;
+};
 #pragma endregion
 template<DType Type, typename T>
 concept IsCompatibleDType =
@@ -0,0 +1,229 @@
+#pragma once
+#include "manifold/dag_node.hpp"
+#include "manifold/macro.hpp"
+#include "manifold/op_type.hpp"
+#include "manifold/utility.hpp"
+#include <span>
+#include <string>
+
+//! Static cost model : flops and bytes moved of every expression, derived from its OpType and the sizes of its
+//! tensors, turned into time estimates with a roofline MachineModel. Everything here is constexpr so scheduling,
+//! fusion and tiling passes can run on it at compile time.
+//!
+//!     constexpr auto cost = dag.costModel(manifold::MachineModel{ 50.0, 500.0 });
+//!     static_assert(cost.parallelism() > 2.0);
+//!     std::print("{}", cost.report());
+
+namespace manifold {
+struct OpCost {
+  uint64_t flops;
+  uint64_t bytes_read;
+  uint64_t bytes_written;
+
+  [[nodiscard]] constexpr uint64_t bytes() const noexcept { return bytes_read + bytes_written; }
+
+  //! Arithmetic intensity (flop per byte moved)
+  [[nodiscard]] constexpr double intensity() const noexcept {
+    return bytes() == 0 ? 0.0 : static_cast<double>(flops) / static_cast<double>(bytes());
+  }
+
+  constexpr OpCost &operator+=(const OpCost &other) noexcept {
+    flops += other.flops;
+    bytes_read += other.bytes_read;
+    bytes_written += other.bytes_written;
+    return *this;
+  }
+};
+
+//! Roofline of the target : an op takes at least bytes / bandwidth and flops / throughput
+struct MachineModel {
+  //! GB/s, ie. bytes per ns
+  double bandwidth{ MANIFOLD_PEAK_GBPS };
+  //! GFLOP/s, ie. flops per ns
+  double throughput{ MANIFOLD_PEAK_GFLOPS };
+
+  //! Intensity above which an op is compute bound
+  [[nodiscard]] constexpr double ridge() const noexcept { return throughput / bandwidth; }
+
+  [[nodiscard]] constexpr double estimateNs(const OpCost &cost) const noexcept {
+    return std::max(static_cast<double>(cost.bytes()) / bandwidth, static_cast<double>(cost.flops) / throughput);
+  }
+
+  [[nodiscard]] constexpr bool isComputeBound(const OpCost &cost) const noexcept {
+    return cost.intensity() >= ridge();
+  }
+};
+
+//! Cost of a single call of an op of @param type writing @param num_outputs tensors of @param out_elements each
+//! from @param num_inputs tensors holding @param in_elements in total. Math functions (exp, sin ...) count as a
+//! single flop per element.
+[[nodiscard]] constexpr OpCost opCost(const OpType type,
+  const DType data_type,
+  const uint32_t num_inputs,
+  const uint64_t in_elements,
+  const uint32_t num_outputs,
+  const uint64_t out_elements) noexcept {
+  const uint64_t size = DTYPE_SIZES[static_cast<uint8_t>(data_type)];
+  OpCost cost{ 0, in_elements * size, num_outputs * out_elements * size };
+
+  switch (type) {
+  case OpType::ELM_ADD:
+  case OpType::ELM_SUB:
+  case OpType::ELM_MUL:
+  case OpType::ELM_DIV: cost.flops = (num_inputs > 1 ? num_inputs - 1 : 1) * out_elements; break;
+  case OpType::EXPONENTIAL:
+  case OpType::SIN:
+  case OpType::COS:
+  case OpType::ABS: cost.flops = out_elements; break;
+  case OpType::SCL_ELM_ADD:
+  case OpType::SCL_ELM_SUB:
+  case OpType::SCL_ELM_MUL:
+  case OpType::SCL_ELM_DIV:
+    // read-modify-write of the output
+    cost.bytes_read = out_elements * size;
+    cost.flops      = out_elements;
+    break;
+  case OpType::EXP_GROUP: return {};
+  default: break;
+  }
+  return cost;
+}
+
+//! opCost of the compacted expression @param exp whose indices point into @param data
+template<typename Exp>
+[[nodiscard]] constexpr OpCost expressionCost(const Exp &exp, const auto &data) noexcept {
+  uint64_t in_elements{};
+  for (size_t j{}; j < exp.inp_size; j++) { in_elements += data[exp.input_indices[j]].size; }
+  return opCost(exp.type, exp.data_type, exp.inp_size, in_elements, exp.out_size, data[exp.output_indices[0]].size);
+}
+
+//! opCost of @param edge of @param edges, its indices point into @param data
+[[nodiscard]] constexpr OpCost expressionCost(EdgeSpan edges, const ExprEdge &edge, const auto &data) noexcept {
+  if (edge.type == OpType::EXP_GROUP) { return {}; }
+  uint64_t in_elements{};
+  for (const uint32_t idx : edges.inputs(edge)) { in_elements += data[idx].size; }
+  return opCost(
+    edge.type, edge.data_type, edge.num_inputs, in_elements, edge.num_outputs, data[edges.outputs(edge)[0]].size);
+}
+
+//! Estimated costs of every expression of a (sorted) DAG, indexed like its edges. Group expressions cost nothing.
+template<size_t ESize>
+struct CostModel {
+  MachineModel machine;
+  std::array<OpCost, ESize> ops;
+  std::array<OpType, ESize> types;
+  std::array<DType, ESize> dtypes;
+  std::array<uint32_t, ESize> ids;
+  //! estimated ns of every op on @ref machine
+  std::array<double, ESize> ns;
+  //! earliest an op can finish when every op runs as soon as its inputs are ready
+  std::array<double, ESize> finish;
+  std::array<bool, ESize> critical;
+
+  OpCost total;
+  //! sum of every estimate, the time on a single core
+  double work_ns;
+  //! longest dependency chain, the time with unlimited cores
+  double critical_ns;
+
+  [[nodiscard]] constexpr double parallelism() const noexcept {
+    return critical_ns == 0.0 ? 1.0 : work_ns / critical_ns;
+  }
+
+  [[nodiscard]] constexpr double maxNs() const noexcept {
+    double max{};
+    for (const double val : ns) { max = std::max(max, val); }
+    return max;
+  }
+
+  //! Roofline report of every op, see toDot(CostModel) for the graph view
+  //!
+  //! Note: Not constexpr evaluable as it formats the report at runtime
+  [[nodiscard]] std::string report() const {
+    std::string str = std::format("machine : {:.1f} GB/s, {:.1f} GFLOP/s, ridge at {:.2f} flop/byte\n",
+      machine.bandwidth,
+      machine.throughput,
+      machine.ridge());
+    str += std::format("{:>6} {:>6} {:>12} {:>7} {:>12} {:>12} {:>10} {:>12} {:>8} {:>3}\n",
+      "idx",
+      "id",
+      "op",
+      "dtype",
+      "flops",
+      "bytes",
+      "flop/byte",
+      "est ns",
+      "bound",
+      "cp");
+    for (size_t i{}; i < ESize; i++) {
+      if (types[i] == OpType::EXP_GROUP) { continue; }
+      str += std::format("{:>6} {:>6} {:>12} {:>7} {:>12} {:>12} {:>10.3f} {:>12.1f} {:>8} {:>3}\n",
+        i,
+        ids[i],
+        optypeToString(types[i]),
+        dtypeToString(dtypes[i]),
+        ops[i].flops,
+        ops[i].bytes(),
+        ops[i].intensity(),
+        ns[i],
+        machine.isComputeBound(ops[i]) ? "compute" : "memory",
+        critical[i] ? "*" : "");
+    }
+    str += std::format("total : {} flops, {} bytes, work {:.1f} ns, critical path {:.1f} ns, parallelism {:.2f}\n",
+      total.flops,
+      total.bytes(),
+      work_ns,
+      critical_ns,
+      parallelism());
+    return str;
+  }
+};
+
+namespace _internal {
+  //! Fills @param cost from @param edges, which must be topologically sorted. Dependencies follow the last writer
+  //! of every tensor read, scalar ops (OpType::SCL_ELM_*) also depend on the last writer of their output.
+  template<size_t ESize>
+  constexpr void costModel(std::span<const TensorNode> data,
+    EdgeSpan edges,
+    std::span<uint32_t> last_writer,
+    CostModel<ESize> &cost) {
+    std::array<uint32_t, ESize> pred{};
+    std::ranges::fill(last_writer, UINT32_MAX);
+
+    uint32_t last = UINT32_MAX;
+    for (uint32_t i{}; i < ESize; i++) {
+      const ExprEdge &edg = edges[i];
+      cost.ops[i]         = expressionCost(edges, edg, data);
+      cost.types[i]       = edg.type;
+      cost.dtypes[i]      = edg.data_type;
+      cost.ids[i]         = edg.id;
+      cost.ns[i]          = cost.machine.estimateNs(cost.ops[i]);
+      cost.total += cost.ops[i];
+      cost.work_ns += cost.ns[i];
+      pred[i] = UINT32_MAX;
+      if (edg.type == OpType::EXP_GROUP) { continue; }
+
+      double start{};
+      const auto depend = [&](const uint32_t tensor) {
+        const uint32_t writer = last_writer[tensor];
+        if (writer != UINT32_MAX && cost.finish[writer] >= start) {
+          start   = cost.finish[writer];
+          pred[i] = writer;
+        }
+      };
+      for (const uint32_t idx : edges.inputs(edg)) { depend(idx); }
+      if (edg.num_inputs == 0) {
+        for (const uint32_t idx : edges.outputs(edg)) { depend(idx); }
+      }
+      cost.finish[i] = start + cost.ns[i];
+      for (const uint32_t idx : edges.outputs(edg)) { last_writer[idx] = i; }
+
+      if (last == UINT32_MAX || cost.finish[i] > cost.finish[last]) { last = i; }
+    }
+
+    if (last == UINT32_MAX) { return; }
+    cost.critical_ns = cost.finish[last];
+    for (uint32_t i = last; i != UINT32_MAX; i = pred[i]) { cost.critical[i] = true; }
+  }
+}  // namespace _internal
+}  // namespace manifold
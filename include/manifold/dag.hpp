@@ -1,9 +1,11 @@
 #pragma once
 
 #include "manifold/concepts.hpp"
+#include "manifold/cost_model.hpp"
 #include "manifold/expression.hpp"
 #include "manifold/macro.hpp"
 #include "manifold/op_type.hpp"
+#include "manifold/schedule.hpp"
 #include "manifold/tensor.hpp"
 #include <algorithm>
 #include <cassert>
@@ -12,6 +14,7 @@
 #include <format>
 #include <functional>
 #include <iterator>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -22,39 +25,32 @@
 
 namespace manifold {
 
-template<size_t InSize, size_t OutSize>
-struct DagIOIdx {
-  std::array<uint32_t, InSize> in_tensor_idxs;
-  std::array<uint32_t, OutSize> out_tensor_idxs;
+//! Objective of topologicalSort among the valid orders
+enum class SortOrder : uint8_t {
+  //! ready expressions in increasing position, an already valid order is kept as is
+  INDEX,
+  //! depth first, an expression runs right after the one that made it ready so consumers follow their producers
+  //! and tensors are read again while still in cache (smaller sum of reuse distances on wide graphs)
+  LOCALITY,
+  //! smallest peak of live intermediate bytes, see schedule.hpp. Members of free groups keep the INDEX order.
+  MEMORY,
 };
 
-template<size_t TSize, size_t ESize>
-struct StaticDAG {
-  std::array<TensorNode, TSize> data;
-  std::array<ExprEdge, ESize> edges;
-  std::array<int64_t, ESize> group_mask;
-
-  constexpr StaticDAG(std::array<TensorNode, TSize> &_data,
-    std::array<ExprEdge, ESize> &_edges,
-    std::array<int64_t, ESize> &masks)
-    : data(_data), edges(_edges), group_mask(masks) {}
-
-  constexpr StaticDAG(const std::array<TensorReflection, TSize> &tensors,
-    const std::array<ExpressionReflection, ESize> &exprs)
-    : edges(), data(), group_mask() {
-
-    for (uint32_t i = 0; i < TSize; ++i) { data[i] = TensorNode(tensors[i]); }
-    auto new_exprs = generateMaskWithIdxs(exprs, group_mask);
-    generateIndices(new_exprs, tensors, edges, data);
-  }
-
+//! Graph passes shared by the compile time StaticDAG and the RuntimeDAG, they work on any contiguous storage
+//! (std::array inside consteval, std::vector at runtime) and see the expressions through an EdgeSpan. Tensor ids are
+//! resolved through @param idx_of which maps an id to its index in the tensor storage or UINT32_MAX (see IdIndex).
+namespace _internal {
+  //! Moves the member expressions of every group right behind it and writes the group mask of each expression
+  //! (own index for free expressions, -group for pinned members and +group for free members).
+  //!
+  //! @param exprs   : expressions in user order, @param exprs_c receives the regrouped copy
   template<typename T>
-  static inline constexpr auto generateMaskWithIdxs(const std::array<T, ESize> &exprs,
-    _internal::IsStdArray auto &mask) {
-    std::array<T, ESize> exprs_c(exprs);
+  constexpr void groupExpressions(std::span<const T> exprs, std::span<T> exprs_c, std::span<int64_t> mask) {
+    const size_t e_size = exprs.size();
+    std::copy(exprs.begin(), exprs.end(), exprs_c.begin());
 
     // generate mask for fragmented groups
-    for (uint i = 0; i < ESize; i++) {
+    for (uint i = 0; i < e_size; i++) {
       const ExpressionReflection &e = exprs[i];
 
       if (e.type != OpType::EXP_GROUP) {
@@ -72,14 +68,14 @@ struct StaticDAG {
         }
         // else rotate the array from right of the i to expected id element
         uint dis = i + 1;
-        while (dis < ESize) {
+        while (dis < e_size) {
           if (exprs_c[dis].id == e.inputs[j]) {
             mask[dis] = expected_mask;
             break;
           }
           dis++;
         }
-        if (dis == ESize) {
+        if (dis == e_size) {
           throw std::logic_error(
             "Manifold: Member expression of a group not found toward right of the group in the array");
         }
@@ -91,112 +87,509 @@ struct StaticDAG {
       }
       i += e.num_inputs;
     }
-    return exprs_c;
   }
 
-  static inline constexpr void generateIndices(const auto &exprs, const auto &tensors, auto &edges, auto &data) {
-    for (uint32_t i = 0; i < ESize; ++i) {
-      // Reset expression
-      const ExpressionReflection &expr = exprs.at(i);
-      // weird way but okay
-      ExprEdge &edge = edges.at(i);
-      edge           = ExprEdge(expr);
+  //! Bytes of @param params up to the last non zero one, what the param table of a DAG keeps
+  constexpr uint32_t paramBytes(const ExpressionReflection::PARAM_TYPE &params) {
+    auto size = static_cast<uint32_t>(params.size());
+    while (size > 0 && params[size - 1] == std::byte{}) { size--; }
+    return size;
+  }
 
+  //! Operand slots and param bytes @param exprs take once lowered by generateIndices
+  constexpr std::pair<size_t, size_t> tableSizes(std::span<const ExpressionReflection> exprs) {
+    std::pair<size_t, size_t> sizes{};
+    for (const ExpressionReflection &expr : exprs) {
+      sizes.first += expr.num_inputs + (expr.type == OpType::EXP_GROUP ? 0 : expr.num_outputs);
+      sizes.second += paramBytes(expr.params);
+    }
+    return sizes;
+  }
+
+  //! Refills the incoming link (last writer) and reader count of every tensor of @param data from @param edges
+  constexpr void linkTensors(EdgeSpan edges, std::span<TensorNode> data) {
+    for (TensorNode &ten : data) {
+      ten.total_out = 0;
+      ten.incoming  = UINT32_MAX;
+    }
+    for (uint32_t i{}; i < edges.size(); i++) {
+      const ExprEdge &edge = edges[i];
       if (edge.type == OpType::EXP_GROUP) { continue; }
-      for (uint32_t j = 0; j < expr.num_outputs; ++j) {
-        // Search for the tensor with the output ID
-        auto is_ID    = [id = expr.outputs.at(j)](auto &ref) { return ref.id == id; };
-        auto iterator = std::ranges::find_if(tensors, is_ID);
-        if (iterator == tensors.end()) { throw std::logic_error("Internal Error: Could not find tensor with an ID"); }
-        auto idx              = static_cast<uint32_t>(std::ranges::distance(tensors.begin(), iterator));
-        data.at(idx).incoming = i;
-        edge.out_idxs.at(j)   = idx;
+      for (const uint32_t idx : edges.outputs(edge)) { data[idx].incoming = i; }
+      for (const uint32_t idx : edges.inputs(edge)) { data[idx].total_out++; }
+    }
+  }
+
+  //! Lowers @param exprs to @param edges : tensor ids are resolved to indices (through @param idx_of) into the
+  //! @param operands table, params are packed into the @param params table, then the tensors of @param data are
+  //! linked. The tables need the room given by tableSizes.
+  constexpr void generateIndices(std::span<const ExpressionReflection> exprs,
+    std::span<ExprEdge> edges,
+    std::span<uint32_t> operands,
+    std::span<std::byte> params,
+    std::span<TensorNode> data,
+    const auto &idx_of) {
+    const auto resolve = [&idx_of](const uint32_t iden) {
+      const uint32_t idx = idx_of(iden);
+      if (idx == UINT32_MAX) { throw std::logic_error("Internal Error: Could not find tensor with an ID"); }
+      return idx;
+    };
+
+    uint32_t slot{};
+    uint32_t byte{};
+    for (uint32_t i = 0; i < exprs.size(); ++i) {
+      const ExpressionReflection &expr = exprs[i];
+      const uint32_t param_bytes       = paramBytes(expr.params);
+      ExprEdge &edge                   = edges[i];
+
+      edge = ExprEdge{ expr.type, expr.data_type, expr.id, expr.num_inputs, expr.num_outputs, slot, byte, param_bytes };
+      std::copy_n(expr.params.begin(), param_bytes, params.begin() + byte);
+      byte += param_bytes;
+
+      if (edge.type == OpType::EXP_GROUP) {
+        edge.pinned = expr.outputs[0] == 1;
+        for (uint32_t j = 0; j < expr.num_inputs; ++j) { operands[slot++] = expr.inputs.at(j); }
+        continue;
       }
+      for (uint32_t j = 0; j < expr.num_inputs; ++j) { operands[slot++] = resolve(expr.inputs.at(j)); }
+      for (uint32_t j = 0; j < expr.num_outputs; ++j) { operands[slot++] = resolve(expr.outputs.at(j)); }
+    }
+    linkTensors(EdgeSpan{ edges, operands, params }, data);
+  }
 
-      for (uint32_t j = 0; j < expr.num_inputs; ++j) {
-        auto is_ID    = [id = expr.inputs.at(j)](auto &ref) { return ref.id == id; };
-        auto iterator = std::ranges::find_if(tensors, is_ID);
-        if (iterator == tensors.end()) { throw std::logic_error("Internal Error: Could not find tensor with an ID"); }
+  //! @param edge of @param edges back as the expression it was lowered from, tensor indices point into @param data
+  constexpr ExpressionReflection reflectExpression(EdgeSpan edges,
+    const ExprEdge &edge,
+    std::span<const TensorNode> data) {
+    ExpressionReflection expr{};
+    expr.type        = edge.type;
+    expr.data_type   = edge.data_type;
+    expr.id          = edge.id;
+    expr.num_inputs  = edge.num_inputs;
+    expr.num_outputs = edge.num_outputs;
+    expr.params      = edges.paramsOf(edge);
+
+    const auto inputs = edges.inputs(edge);
+    if (edge.type == OpType::EXP_GROUP) {
+      std::ranges::copy(inputs, expr.inputs.begin());
+      expr.outputs[0] = edge.pinned ? 1 : 0;
+      return expr;
+    }
+    std::ranges::transform(inputs, expr.inputs.begin(), [&](uint32_t idx) { return data[idx].id; });
+    std::ranges::transform(edges.outputs(edge), expr.outputs.begin(), [&](uint32_t idx) { return data[idx].id; });
+    return expr;
+  }
 
-        auto idx        = static_cast<uint32_t>(std::ranges::distance(tensors.begin(), iterator));
-        TensorNode &ten = data.at(idx);
-        if (ten.total_out > MANIFOLD_TENSORNODE_MAX_OUT) {
-          throw std::runtime_error("Error: more than MANIFOLD_TENSORNODE_MAX_OUT outgoing edges from a node");
+  //! Group mask (see groupExpressions) of @param edges, whose groups are already followed by their members
+  constexpr void groupMask(std::span<const ExprEdge> edges, std::span<int64_t> mask) {
+    for (uint32_t i{}; i < edges.size(); i++) {
+      const ExprEdge &edge = edges[i];
+      mask[i]              = i;
+      if (edge.type != OpType::EXP_GROUP) { continue; }
+
+      mask[i]                  = -static_cast<int64_t>(i);
+      const auto expected_mask = edge.pinned ? -static_cast<int64_t>(i) : i;
+      for (uint32_t j = 1; j <= edge.num_inputs && i + j < edges.size(); j++) { mask[i + j] = expected_mask; }
+      i += edge.num_inputs;
+    }
+  }
+
+  //! Readers of every tensor as a CSR table : the edges reading tensor `t` are
+  //! `consumers[offsets[t] .. offsets[t + 1]]` in increasing edge order. @param offsets holds one more entry than
+  //! there are tensors, @param consumers one per input slot of @param edges (sum of total_out).
+  constexpr void fanOut(EdgeSpan edges, std::span<uint32_t> offsets, std::span<uint32_t> consumers) {
+    std::ranges::fill(offsets, 0U);
+    for (const ExprEdge &edge : edges) {
+      if (edge.type == OpType::EXP_GROUP) { continue; }
+      for (const uint32_t idx : edges.inputs(edge)) { offsets[idx + 1]++; }
+    }
+    for (size_t i = 1; i < offsets.size(); i++) { offsets[i] += offsets[i - 1]; }
+
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (uint32_t i{}; i < edges.size(); i++) {
+      const ExprEdge &edge = edges[i];
+      if (edge.type == OpType::EXP_GROUP) { continue; }
+      for (const uint32_t idx : edges.inputs(edge)) { consumers[fill[idx]++] = i; }
+    }
+  }
+
+  //! Dense tensor id -> index table built once per pass. Ids are usually handed out close to 0..N, a direct
+  //! table is used when they are, otherwise a sorted (id, index) list searched in O(log N).
+  class IdIndex {
+  public:
+    constexpr explicit IdIndex(const auto &tensors) {
+      uint32_t max_id{};
+      for (const auto &ten : tensors) { max_id = std::max(max_id, ten.id); }
+
+      if (max_id < 4 * tensors.size() + 64) {
+        dense.assign(max_id + 1, UINT32_MAX);
+        for (uint32_t i{}; i < tensors.size(); i++) {
+          uint32_t &slot = dense[tensors[i].id];
+          if (slot != UINT32_MAX) { throw std::logic_error("Manifold: tensor id is used more than once"); }
+          slot = i;
         }
-        ten.outgoing.at(ten.total_out++) = i;
-        edge.inp_idxs.at(j)              = idx;
+        return;
+      }
+
+      sparse.reserve(tensors.size());
+      for (uint32_t i{}; i < tensors.size(); i++) { sparse.emplace_back(tensors[i].id, i); }
+      std::ranges::sort(sparse);
+      if (std::ranges::adjacent_find(sparse, {}, &std::pair<uint32_t, uint32_t>::first) != sparse.end()) {
+        throw std::logic_error("Manifold: tensor id is used more than once");
       }
     }
-  }
 
-  static constexpr int64_t computeRanks(auto &exprs, auto &tens, auto &ranks, uint32_t idx) {
-    ExprEdge &expr = exprs.at(idx);
-    if (ranks.at(idx)) { return ranks.at(idx); }
-    if (!expr.num_inputs) { return 0; }
+    [[nodiscard]] constexpr uint32_t operator()(uint32_t iden) const {
+      if (sparse.empty()) { return iden < dense.size() ? dense[iden] : UINT32_MAX; }
+      const auto iterator =
+        std::ranges::lower_bound(sparse, iden, {}, &std::pair<uint32_t, uint32_t>::first);
+      return iterator != sparse.end() && iterator->first == iden ? iterator->second : UINT32_MAX;
+    }
 
-    uint32_t rank = expr.num_inputs;
-    for (uint32_t i{}; i < exprs.at(idx).num_inputs; i++) {
-      auto &ten = tens.at(expr.inputs.at(i));
-      if (ten.incoming == UINT32_MAX) { continue; }
-      rank += computeRanks(exprs, tens, ranks, ten.incoming);
+  private:
+    std::vector<uint32_t> dense;
+    std::vector<std::pair<uint32_t, uint32_t>> sparse;
+  };
+
+  //! Kahn's algorithm over a CSR adjacency (@param offsets / @param succ). With SortOrder::INDEX ready nodes are
+  //! taken in increasing index order, with SortOrder::LOCALITY the last node made ready goes first (ties, ie. the
+  //! initial nodes and the successors of a single node, still in increasing index order).
+  //!
+  //! @return false if the nodes don't form a DAG
+  constexpr bool kahnOrder(std::span<const uint32_t> offsets,
+    std::span<const uint32_t> succ,
+    std::vector<uint32_t> in_degree,
+    std::vector<uint32_t> &order,
+    SortOrder objective = SortOrder::INDEX) {
+    std::vector<uint32_t> ready;
+    if (objective == SortOrder::LOCALITY) {
+      for (auto i = static_cast<uint32_t>(in_degree.size()); i-- > 0;) {
+        if (in_degree[i] == 0) { ready.push_back(i); }
+      }
+      while (!ready.empty()) {
+        const uint32_t node = ready.back();
+        ready.pop_back();
+        order.push_back(node);
+
+        const auto first = ready.size();
+        for (uint32_t k = offsets[node]; k < offsets[node + 1]; k++) {
+          if (--in_degree[succ[k]] == 0) { ready.push_back(succ[k]); }
+        }
+        std::ranges::sort(ready.begin() + static_cast<std::ptrdiff_t>(first), ready.end(), std::greater<>());
+      }
+      return order.size() == in_degree.size();
     }
 
-    ranks.at(idx) = rank;
-    return rank;
+    for (uint32_t i{}; i < in_degree.size(); i++) {
+      if (in_degree[i] == 0) { ready.push_back(i); }
+    }
+    std::ranges::make_heap(ready, std::greater<>());
+
+    while (!ready.empty()) {
+      std::ranges::pop_heap(ready, std::greater<>());
+      const uint32_t node = ready.back();
+      ready.pop_back();
+      order.push_back(node);
+
+      for (uint32_t k = offsets[node]; k < offsets[node + 1]; k++) {
+        if (--in_degree[succ[k]] == 0) {
+          ready.push_back(succ[k]);
+          std::ranges::push_heap(ready, std::greater<>());
+        }
+      }
+    }
+    return order.size() == in_degree.size();
   }
 
-  constexpr void topoSortGroup(std::array<ExprEdge, ESize> &exprs,
-    std::array<int64_t, ESize> &ranks,
-    uint32_t idx,
-    uint32_t inp_len) const {
-    for (auto i = idx; i < idx + inp_len; i++) {
-      ExprEdge &expr = exprs.at(i);
-      if (expr.type == OpType::EXP_GROUP) {
-        if (expr.outputs[0] == 1) {
-          i += expr.num_inputs;
-          continue;
+  //! Builds the CSR dependency graph between @param count nodes, @param node_of maps an expression position to its
+  //! node (UINT32_MAX to skip it). Expressions are taken in position order, the order they were given in, and tensors
+  //! as buffers they may write more than once (scalar ops, in place and reused tensors) :
+  //!  - a read depends on the last write before it (read after write), a tensor not written yet is a graph input
+  //!  - a write depends on the previous write (write after write), which also orders a read-modify-write op
+  //!    (OpType::SCL_ELM_*) after the value it updates
+  //!  - a write depends on the reads since the previous write (write after read), so they still see the old value
+  constexpr void dependencyCSR(EdgeSpan edges,
+    std::span<const TensorNode> data,
+    std::span<const uint32_t> node_of,
+    uint32_t count,
+    std::vector<uint32_t> &offsets,
+    std::vector<uint32_t> &succ,
+    std::vector<uint32_t> &in_degree) {
+    auto for_each_dep = [&](auto &&fn) {
+      std::vector<uint32_t> writer(data.size(), UINT32_MAX);
+      std::vector<std::vector<uint32_t>> readers(data.size());
+      const auto depend = [&](const uint32_t from, const uint32_t to) {
+        if (from != UINT32_MAX && from != to) { fn(from, to); }
+      };
+      for (uint32_t i{}; i < edges.size(); i++) {
+        const ExprEdge &edge = edges[i];
+        const uint32_t node  = node_of[i];
+        if (node == UINT32_MAX || edge.type == OpType::EXP_GROUP) { continue; }
+        for (const uint32_t tensor : edges.inputs(edge)) {
+          depend(writer[tensor], node);
+          if (readers[tensor].empty() || readers[tensor].back() != node) { readers[tensor].push_back(node); }
         }
-        auto max_len = std::min(expr.num_inputs, uint32_t(ESize) - idx - 1);
-        topoSortGroup(exprs, ranks, idx + 1, max_len);
-      }
-      // sort exprs using ranks skipping negative ranks
-      for (uint32_t j = i + 1; j < idx + inp_len; j++) {
-        if (ranks[j] > 0 &&  // Skip negative ranks
-            ranks[j] < ranks[i]) {
-          std::swap(exprs[i], exprs[j]);
-          std::swap(ranks[i], ranks[j]);
+        for (const uint32_t tensor : edges.outputs(edge)) {
+          depend(writer[tensor], node);
+          for (const uint32_t reader : readers[tensor]) { depend(reader, node); }
+          readers[tensor].clear();
+          writer[tensor] = node;
         }
       }
+    };
+
+    offsets.assign(count + 1, 0);
+    in_degree.assign(count, 0);
+    for_each_dep([&](uint32_t from, uint32_t to) {
+      offsets[from + 1]++;
+      in_degree[to]++;
+    });
+    for (uint32_t i{}; i < count; i++) { offsets[i + 1] += offsets[i]; }
+
+    succ.assign(offsets[count], 0);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for_each_dep([&](uint32_t from, uint32_t to) { succ[fill[from]++] = to; });
+  }
+
+  //! Tensors touched by every unit ([unit_start[u], unit_start[u + 1]) of @param edges) as the CSR
+  //! @param offsets / @param tensors, and the aligned bytes of every tensor of @param data in @param bytes (0 for the
+  //! graph inputs and outputs, they are alive whatever the order)
+  constexpr void liveModel(EdgeSpan edges,
+    std::span<const TensorNode> data,
+    std::span<const uint32_t> unit_start,
+    std::vector<uint32_t> &offsets,
+    std::vector<uint32_t> &tensors,
+    std::vector<size_t> &bytes) {
+    bytes.assign(data.size(), 0);
+    for (size_t i{}; i < data.size(); i++) {
+      const TensorNode &ten = data[i];
+      if (ten.incoming == UINT32_MAX || ten.total_out == 0) { continue; }
+      bytes[i] = alignedExtent(ten) * DTYPE_SIZES[static_cast<uint8_t>(ten.data_type)];
+    }
+
+    offsets.assign(1, 0);
+    for (size_t u{}; u + 1 < unit_start.size(); u++) {
+      const auto first = static_cast<std::ptrdiff_t>(tensors.size());
+      for (uint32_t i = unit_start[u]; i < unit_start[u + 1]; i++) {
+        const ExprEdge &edge = edges[i];
+        if (edge.type == OpType::EXP_GROUP) { continue; }
+        tensors.insert(tensors.end(), edges.inputs(edge).begin(), edges.inputs(edge).end());
+        tensors.insert(tensors.end(), edges.outputs(edge).begin(), edges.outputs(edge).end());
+      }
+      std::ranges::sort(tensors.begin() + first, tensors.end());
+      tensors.erase(std::unique(tensors.begin() + first, tensors.end()), tensors.end());
+      offsets.push_back(static_cast<uint32_t>(tensors.size()));
     }
   }
 
-  //! Topologically sorts and generates new DAG based on effective ranks.
+  //! Topologically sorts the expressions with Kahn's algorithm, then relinks the tensors and regroups.
   //!
-  //! Note : doesn't sort tensors but only the OP/ Expressions.
-  constexpr StaticDAG<TSize, ESize> topologicalSort() const {
-    std::array<ExprEdge, ESize> e_cpy(edges);
-    std::array<TensorNode, TSize> t_cpy(data);
-    std::array<int64_t, ESize> masks{};
+  //! Groups are scheduled as a single unit (the group expression followed by its members) so they stay
+  //! contiguous. Members of pinned groups keep their order, members of free groups are sorted among themselves.
+  //!
+  //! @param edges    : grouped expressions, ie. every group directly followed by its members
+  //! @param out_data : copy of the tensors of @param edges, its links get regenerated for the new expression order
+  //! @param out_edges : the sorted edges, they still point into the operand and param tables of @param edges
+  //! @param objective : order picked among the valid ones, for the groups and free expressions as well as for the
+  //!                    members of free groups
+  //! @param stats    : filled with the peaks of SortOrder::MEMORY when given
+  constexpr void topologicalSort(EdgeSpan edges,
+    std::span<TensorNode> out_data,
+    std::span<ExprEdge> out_edges,
+    std::span<int64_t> out_mask,
+    SortOrder objective  = SortOrder::INDEX,
+    ScheduleStats *stats = nullptr) {
+    const auto e_size = static_cast<uint32_t>(edges.size());
+
+    // Units : a free expression or a whole group, stored as [unit_start[u], unit_start[u + 1])
+    std::vector<uint32_t> unit_of(e_size);
+    std::vector<uint32_t> unit_start;
+    for (uint32_t i{}; i < e_size; i++) {
+      const uint32_t len = edges[i].type == OpType::EXP_GROUP ? std::min(edges[i].num_inputs, e_size - i - 1) : 0;
+      for (uint32_t j{}; j <= len; j++) { unit_of[i + j] = static_cast<uint32_t>(unit_start.size()); }
+      unit_start.push_back(i);
+      i += len;
+    }
+    const auto u_size = static_cast<uint32_t>(unit_start.size());
+    unit_start.push_back(e_size);
+
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> succ;
+    std::vector<uint32_t> in_degree;
+    std::vector<uint32_t> units;
+    units.reserve(u_size);
+    dependencyCSR(edges, out_data, unit_of, u_size, offsets, succ, in_degree);
+    if (objective == SortOrder::MEMORY) {
+      std::vector<uint32_t> index_order;
+      if (!kahnOrder(offsets, succ, in_degree, index_order)) {
+        throw std::logic_error("Manifold: expressions have a cyclic dependency");
+      }
+      std::vector<uint32_t> live_offsets;
+      std::vector<uint32_t> live_tensors;
+      std::vector<size_t> live_bytes;
+      liveModel(edges, out_data, unit_start, live_offsets, live_tensors, live_bytes);
+      const LiveModel model{ live_offsets, live_tensors, live_bytes };
+      memoryOrder(offsets, succ, std::move(in_degree), model, index_order, units, stats);
+    } else if (!kahnOrder(offsets, succ, std::move(in_degree), units, objective)) {
+      throw std::logic_error("Manifold: expressions have a cyclic dependency");
+    }
 
-    // Generate ranks
-    std::array<int64_t, ESize> ranks{};
-    for (uint32_t i{}; i < ESize; i++) {
-      if (group_mask[i] < 0) {
-        ranks[i] = group_mask[i];
+    std::vector<ExprEdge> e_cpy;
+    e_cpy.reserve(e_size);
+    std::vector<uint32_t> member_of(e_size, UINT32_MAX);
+    std::vector<uint32_t> members;
+    for (const uint32_t unit : units) {
+      const uint32_t first = unit_start[unit];
+      const uint32_t last  = unit_start[unit + 1];
+      e_cpy.push_back(edges[first]);
+      if (last - first == 1 || edges[first].pinned) {
+        for (uint32_t i = first + 1; i < last; i++) { e_cpy.push_back(edges[i]); }
         continue;
       }
-      computeRanks(e_cpy, t_cpy, ranks, i);
+
+      // Free group, order the members by their dependencies inside the group
+      for (uint32_t i = first + 1; i < last; i++) { member_of[i] = i - first - 1; }
+      members.clear();
+      dependencyCSR(edges, out_data, member_of, last - first - 1, offsets, succ, in_degree);
+      const auto member_order = objective == SortOrder::LOCALITY ? SortOrder::LOCALITY : SortOrder::INDEX;
+      if (!kahnOrder(offsets, succ, std::move(in_degree), members, member_order)) {
+        throw std::logic_error("Manifold: members of a group have a cyclic dependency");
+      }
+      for (const uint32_t member : members) { e_cpy.push_back(edges[first + 1 + member]); }
+      for (uint32_t i = first + 1; i < last; i++) { member_of[i] = UINT32_MAX; }
+    }
+
+    std::ranges::copy(e_cpy, out_edges.begin());
+    linkTensors(EdgeSpan{ out_edges, edges.operands, edges.params }, out_data);
+    groupMask(out_edges, out_mask);
+  }
+
+  //! Sum over every tensor read of the number of expressions run since the previous access (read or write) of
+  //! that tensor, the first read of a graph input is free. Smaller means consumers run closer to their producers.
+  constexpr uint64_t reuseDistance(std::span<const TensorNode> data, EdgeSpan edges) {
+    std::vector<uint32_t> last(data.size(), UINT32_MAX);
+    uint64_t distance{};
+    uint32_t pos{};
+    for (const ExprEdge &edge : edges) {
+      if (edge.type == OpType::EXP_GROUP) { continue; }
+      for (const uint32_t idx : edges.inputs(edge)) {
+        uint32_t &prev = last[idx];
+        if (prev != UINT32_MAX) { distance += pos - prev; }
+        prev = pos;
+      }
+      for (const uint32_t idx : edges.outputs(edge)) { last[idx] = pos; }
+      pos++;
     }
-    // Sort WRT Pinned groups
-    // Group Expression is never sorted nor does pinned expressions ie. any negative ranked
-    topoSortGroup(e_cpy, ranks, 0, ESize);
+    return distance;
+  }
+
+  //! Marks every tensor and expression @param roots (tensor indices) depend on
+  constexpr void markDependencies(std::span<const TensorNode> data,
+    EdgeSpan edges,
+    std::span<const uint32_t> roots,
+    auto &t_visited,
+    auto &e_visited) {
+    std::vector<uint32_t> stack(roots.begin(), roots.end());
+    while (!stack.empty()) {
+      const uint32_t data_idx = stack.back();
+      stack.pop_back();
+      if (t_visited[data_idx]) { continue; }
+      t_visited[data_idx] = true;
+
+      const TensorNode &curr = data[data_idx];
+      if (curr.incoming == UINT32_MAX) { continue; }
+      e_visited[curr.incoming] = true;
+      const auto inputs        = edges.inputs(edges[curr.incoming]);
+      stack.insert(stack.end(), inputs.begin(), inputs.end());
+    }
+  }
+}  // namespace _internal
+
+template<size_t InSize, size_t OutSize>
+struct DagIOIdx {
+  std::array<uint32_t, InSize> in_tensor_idxs;
+  std::array<uint32_t, OutSize> out_tensor_idxs;
+};
+
+//! @tparam OSize, PSize : operand slots and param bytes of the expressions (see _internal::tableSizes), by default
+//! room for ESize of the largest expressions. SymbolContainer::to_dag<Sizes>() gives a DAG with exact tables.
+template<size_t TSize,
+  size_t ESize,
+  size_t OSize = ESize * EXPR_OPERANDS_MAX,
+  size_t PSize = ESize * MANIFOLD_PARAM_BYTES_MAX>
+struct StaticDAG {
+  using OPERAND_TYPE = std::array<uint32_t, OSize>;
+  using PARAM_TYPE   = std::array<std::byte, PSize>;
+
+  std::array<TensorNode, TSize> data;
+  std::array<ExprEdge, ESize> edges;
+  //! operand and param tables of @ref edges, filled from the front
+  OPERAND_TYPE operands;
+  PARAM_TYPE params;
+  std::array<int64_t, ESize> group_mask;
+
+  constexpr StaticDAG(std::array<TensorNode, TSize> &_data,
+    std::array<ExprEdge, ESize> &_edges,
+    const OPERAND_TYPE &_operands,
+    const PARAM_TYPE &_params,
+    std::array<int64_t, ESize> &masks)
+    : data(_data), edges(_edges), operands(_operands), params(_params), group_mask(masks) {}
+
+  constexpr StaticDAG(const std::array<TensorReflection, TSize> &tensors,
+    const std::array<ExpressionReflection, ESize> &exprs)
+    : edges(), data(), operands(), params(), group_mask() {
+    const auto [operand_count, param_count] = _internal::tableSizes(exprs);
+    if (operand_count > OSize || param_count > PSize) {
+      throw std::logic_error("Manifold: expressions don't fit the operand and param tables of the StaticDAG");
+    }
+
+    for (uint32_t i = 0; i < TSize; ++i) { data[i] = TensorNode(tensors[i]); }
+    auto new_exprs = generateMaskWithIdxs(exprs, group_mask);
+    _internal::generateIndices(new_exprs, edges, operands, params, data, _internal::IdIndex(tensors));
+  }
 
-    for (auto &ten : t_cpy) { ten.total_out = 0; }
-    generateIndices(e_cpy, data, e_cpy, t_cpy);
-    auto new_exprs = generateMaskWithIdxs(e_cpy, masks);
-    return StaticDAG{ t_cpy, new_exprs, masks };
+  template<typename T>
+  static inline constexpr auto generateMaskWithIdxs(const std::array<T, ESize> &exprs,
+    _internal::IsStdArray auto &mask) {
+    std::array<T, ESize> exprs_c{};
+    _internal::groupExpressions<T>(exprs, exprs_c, mask);
+    return exprs_c;
   }
 
+  //! The edges with their operand and param tables, what the graph passes work on
+  [[nodiscard]] constexpr EdgeSpan edgeSpan() const noexcept { return { edges, operands, params }; }
+
+  //! Topologically sorts and generates new DAG (Kahn's algorithm, see _internal::topologicalSort). Pinned groups
+  //! keep the order of their members, @param objective picks among the valid orders.
+  //!
+  //! Note : doesn't sort tensors but only the OP/ Expressions.
+  constexpr StaticDAG topologicalSort(SortOrder objective = SortOrder::INDEX) const {
+    std::array<ExprEdge, ESize> e_cpy{};
+    std::array<TensorNode, TSize> t_cpy(data);
+    std::array<int64_t, ESize> masks{};
+
+    _internal::topologicalSort(edgeSpan(), t_cpy, e_cpy, masks, objective);
+    return StaticDAG{ t_cpy, e_cpy, operands, params, masks };
+  }
+
+  //! topologicalSort(SortOrder::MEMORY) together with the peak it reached against the SortOrder::INDEX order
+  //!
+  //!     constexpr auto schedule = dag.memorySchedule();
+  //!     static_assert(schedule.second.peak <= schedule.second.index_peak);
+  //!     constexpr auto meta = manifold::graphMetadata(schedule.first);
+  constexpr std::pair<StaticDAG, ScheduleStats> memorySchedule() const {
+    std::array<ExprEdge, ESize> e_cpy{};
+    std::array<TensorNode, TSize> t_cpy(data);
+    std::array<int64_t, ESize> masks{};
+    ScheduleStats stats{};
+
+    _internal::topologicalSort(edgeSpan(), t_cpy, e_cpy, masks, SortOrder::MEMORY, &stats);
+    return { StaticDAG{ t_cpy, e_cpy, operands, params, masks }, stats };
+  }
+
+  //! See _internal::reuseDistance, the DAG should be topologically sorted
+  [[nodiscard]] constexpr uint64_t reuseDistance() const { return _internal::reuseDistance(data, edgeSpan()); }
+
   [[nodiscard]] constexpr uint32_t tensorIdxFromID(uint32_t iden) const {
     for (uint32_t i{}; i < TSize; i++) {
       if (data.at(i).id == iden) { return i; }
@@ -224,10 +617,48 @@ struct StaticDAG {
   //! Todo: Create actual subgraphs based on subgroups
   [[nodiscard]] constexpr std::string toDot(const std::string &graph_name = "G",
     const std::string &rank_dir                                           = "LR") const {
-    std::string str = std::format("digraph {} {}\n  rankdir=\"{}\"\n", graph_name, "{", rank_dir);
     using namespace std::literals;
-    constexpr auto t_style  = "[shape=box,color=aliceblue,style=\"filled,rounded\"]"sv;
     constexpr auto op_style = "[shape=circle,color=lavender,style=\"filled,rounded\"]"sv;
+    return dotString(graph_name, rank_dir, [&](size_t) { return std::string(op_style); });
+  }
+
+  //! toDot with every op filled by its estimated time (ylorrd9 color scheme, darker is slower) and the ops of the
+  //! critical path drawn in bold, @param cost should come from costModel()
+  [[nodiscard]] constexpr std::string toDot(const CostModel<ESize> &cost,
+    const std::string &graph_name = "G",
+    const std::string &rank_dir   = "LR") const {
+    const double max_ns = cost.maxNs();
+    return dotString(graph_name, rank_dir, [&](size_t i) {
+      const auto shade = max_ns == 0.0 ? 1 : 1 + static_cast<int>(8.0 * cost.ns.at(i) / max_ns);
+      return std::format(
+        "[shape=circle,style=\"filled,rounded\",colorscheme=ylorrd9,fillcolor={},penwidth={},label=\"{}\\n{:.1f}ns\"]",
+        shade,
+        cost.critical.at(i) ? 3 : 1,
+        optypeToString(edges.at(i).type),
+        cost.ns.at(i));
+    });
+  }
+
+  //-------------------------------------------------- Cost model ------------------------------------------------------
+
+  //! Flops, bytes and estimated time of every op plus the critical path on @param machine, see cost_model.hpp
+  //!
+  //! Note: The DAG should be topologically sorted
+  [[nodiscard]] constexpr CostModel<ESize> costModel(const MachineModel &machine = {}) const {
+    CostModel<ESize> cost{};
+    cost.machine = machine;
+    std::array<uint32_t, TSize> last_writer{};
+    _internal::costModel<ESize>(data, edgeSpan(), last_writer, cost);
+    return cost;
+  }
+
+  //! Shared part of the toDot variants, @param op_style gives the attributes of the op at an edge index
+  [[nodiscard]] constexpr std::string dotString(const std::string &graph_name,
+    const std::string &rank_dir,
+    const auto &op_style) const {
+    std::string str = std::format("digraph {} {}\n  rankdir=\"{}\"\n", graph_name, "{", rank_dir);
+    using namespace std::literals;
+    constexpr auto t_style = "[shape=box,color=aliceblue,style=\"filled,rounded\"]"sv;
 
     // Todo: Actually add subgroups
     // constexpr auto colors = std::array{ "grey0"sv, "grey10"sv, "grey20"sv, "grey30"sv, "grey40"sv, "grey50"sv };
@@ -242,18 +673,21 @@ struct StaticDAG {
     }
 
     for (size_t i{}; i < ESize; i++) {
-      const ExpressionReflection &expr = edges.at(i);
+      const ExprEdge &expr = edges.at(i);
       if (expr.type == OpType::EXP_GROUP) { continue; }
       auto mask   = group_mask.at(i);
       auto pinned = mask == int64_t(i) ? ""sv : mask < 0 ? "_t"sv : "_f"sv;
       op_str[i]   = std::format("OP{}_{}_{}{}", expr.id, i, abs(mask), pinned);
-      str += std::format("  {} {};\n", op_str[i], op_style);
+      str += std::format("  {} {};\n", op_str[i], op_style(i));
     }
 
+    std::vector<uint32_t> offsets(TSize + 1);
+    std::vector<uint32_t> consumers;
+    for (const TensorNode &node : data) { consumers.resize(consumers.size() + node.total_out); }
+    _internal::fanOut(edgeSpan(), offsets, consumers);
     for (size_t i{}; i < TSize; i++) {
-      const TensorNode &node = data.at(i);
       str += "  " + t_str.at(i) + " -> { ";
-      for (size_t j{}; j < node.total_out; j++) { str += op_str.at(node.outgoing.at(j)) + " "; }
+      for (size_t j = offsets[i]; j < offsets[i + 1]; j++) { str += op_str.at(consumers[j]) + " "; }
       str += "};\n";
     }
 
@@ -261,7 +695,7 @@ struct StaticDAG {
       const ExprEdge &edg = edges.at(i);
       if (edg.type == OpType::EXP_GROUP) { continue; }
       str += "  " + op_str.at(i) + " -> { ";
-      for (size_t j{}; j < edg.num_outputs; j++) { str += t_str.at(edg.out_idxs.at(j)) + " "; }
+      for (const uint32_t idx : edgeSpan().outputs(edg)) { str += t_str.at(idx) + " "; }
       str += "};\n";
     }
 
@@ -291,21 +725,7 @@ struct StaticDAG {
     const uint32_t max = OutSize) const noexcept {
 
     // Dep search (backtrace)
-    for (uint i{}; i < max; i++) {
-      auto data_idx = arr.at(i);
-      // find deps
-      TensorNode curr = data.at(data_idx);
-      if (t_visited.at(data_idx)) { continue; }
-      t_visited.at(data_idx) = true;
-
-      if (curr.incoming == UINT32_MAX) { continue; }
-      ExprEdge incom              = edges.at(curr.incoming);
-      e_visited.at(curr.incoming) = true;
-      auto [r_t, r_e]             = depSearch(incom.inp_idxs, t_visited, e_visited, incom.num_inputs);
-      // merge the results
-      std::transform(t_visited.begin(), t_visited.end(), r_t.begin(), t_visited.begin(), std::bit_or<>());
-      std::transform(e_visited.begin(), e_visited.end(), r_e.begin(), e_visited.begin(), std::bit_or<>());
-    }
+    _internal::markDependencies(data, edgeSpan(), std::span(arr.data(), max), t_visited, e_visited);
     return { t_visited, e_visited };
   }
 
@@ -336,13 +756,16 @@ struct StaticDAG {
 
   //! You should already know the value of template @param T and @param E this can be done
   //! This can be done by calling subGraphCount
+  //!
+  //! Note: The result is relinked (indices point into the smaller arrays), groups are dropped and their
+  //!       members become free expressions.
   template<uint32_t T, uint32_t E, size_t OutSize>
   [[nodiscard]] constexpr StaticDAG<T, E> subgraphByIdx(const std::array<uint32_t, OutSize> &out) const {
     auto [r_t, r_e] = depSearch(out, {}, {});
 
     // Count and add those to the list of elements
-    std::array<TensorNode, T> tensors{};
-    std::array<ExprEdge, E> exprs{};
+    std::array<TensorReflection, T> tensors{};
+    std::array<ExpressionReflection, E> exprs{};
 
     uint32_t jx = 0;
     for (size_t i = 0; i < TSize; i++) {
@@ -350,9 +773,8 @@ struct StaticDAG {
     }
     jx = 0;
     for (size_t i = 0; i < ESize; i++) {
-      if (r_e.at(i)) { exprs[jx++] = edges.at(i); }
+      if (r_e.at(i)) { exprs[jx++] = _internal::reflectExpression(edgeSpan(), edges.at(i), data); }
     }
-
     return { tensors, exprs };
   }
 
@@ -394,14 +816,20 @@ struct StaticDAG {
 }  // namespace manifold
 
 
-template<size_t TSize, size_t ESize>
-struct std::formatter<manifold::StaticDAG<TSize, ESize>> : std::formatter<std::string> {
+template<size_t TSize, size_t ESize, size_t OSize, size_t PSize>
+struct std::formatter<manifold::StaticDAG<TSize, ESize, OSize, PSize>> : std::formatter<std::string> {
   template<typename FormatContext>
-  constexpr auto format(const manifold::StaticDAG<TSize, ESize> &dag, FormatContext &ctx) const {
+  constexpr auto format(const manifold::StaticDAG<TSize, ESize, OSize, PSize> &dag, FormatContext &ctx) const {
     std::format_to(ctx.out(), "data: [\n");
     for (const manifold::TensorNode &ten : dag.data) { std::format_to(ctx.out(), "{}\n\n", ten); }
     std::format_to(ctx.out(), "]\nedges : [\n");
-    for (const manifold::ExprEdge &expr : dag.edges) { std::format_to(ctx.out(), "{}\n\n", expr); }
+    for (const manifold::ExprEdge &expr : dag.edges) {
+      std::format_to(ctx.out(), "{}\ninput idxs: [ ", expr);
+      for (const uint32_t idx : dag.edgeSpan().inputs(expr)) { std::format_to(ctx.out(), "{} ", idx); }
+      std::format_to(ctx.out(), "]\noutput idxs: [ ");
+      for (const uint32_t idx : dag.edgeSpan().outputs(expr)) { std::format_to(ctx.out(), "{} ", idx); }
+      std::format_to(ctx.out(), "]\n\n");
+    }
     return std::format_to(ctx.out(), "]\n");
   }
 };
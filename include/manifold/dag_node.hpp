@@ -1,41 +1,94 @@
 #pragma once
+#include "manifold/constants.hpp"
 #include "manifold/expression.hpp"
+#include "manifold/macro.hpp"
 #include "manifold/tensor.hpp"
+#include <algorithm>
 #include <cstddef>
 #include <format>
+#include <span>
 
 namespace manifold {
+namespace _internal {
+  //! Elements of @param type that make up MANIFOLD_TENSOR_ALIGN bytes
+  constexpr size_t alignElements(DType type) {
+    const size_t d_size = DTYPE_SIZES.at(static_cast<uint8_t>(type));
+    return MANIFOLD_TENSOR_ALIGN > d_size ? MANIFOLD_TENSOR_ALIGN / d_size : 1;
+  }
+
+  //! Elements a tensor takes once its buffer is padded to MANIFOLD_TENSOR_ALIGN bytes
+  constexpr size_t alignedExtent(const TensorReflection &ten) {
+    const auto align = alignElements(ten.data_type);
+    return (ten.size + align - 1) / align * align;
+  }
+}  // namespace _internal
 
+//! Tensor of a DAG. Only the number of readers is kept here, the readers themselves are derived on demand as a
+//! CSR table (see _internal::fanOut) so fan out is not bounded.
 struct TensorNode : TensorReflection {
   uint32_t total_out{};
-  std::array<uint32_t, MANIFOLD_TENSORNODE_MAX_OUT> outgoing{};
   uint32_t incoming{ UINT32_MAX };
 
   constexpr TensorNode() = default;
 
-  constexpr TensorNode(TensorReflection ten_ref,
-    uint32_t out_num,
-    std::array<uint32_t, MANIFOLD_TENSORNODE_MAX_OUT> out,
-    uint32_t inp = UINT32_MAX)
-    : TensorReflection(ten_ref), total_out(out_num), outgoing(out), incoming(inp) {}
+  constexpr TensorNode(TensorReflection ten_ref, uint32_t out_num, uint32_t inp = UINT32_MAX)
+    : TensorReflection(ten_ref), total_out(out_num), incoming(inp) {}
 
-  constexpr explicit TensorNode(TensorReflection ten_ref) : TensorReflection(ten_ref), outgoing() {}
+  constexpr explicit TensorNode(TensorReflection ten_ref) : TensorReflection(ten_ref) {}
 };
 
-struct ExprEdge : ExpressionReflection {
-  std::array<uint32_t, MANIFOLD_MAX_EXP_INPUT> inp_idxs{};
-  std::array<uint32_t, MANIFOLD_MAX_EXP_OUTPUT> out_idxs{};
+//! Slots an expression takes in the operand table of a DAG at most
+inline constexpr size_t EXPR_OPERANDS_MAX = MANIFOLD_MAX_EXP_INPUT + MANIFOLD_MAX_EXP_OUTPUT;
+
+//! Expression of a DAG. Its tensors and params are stored apart, in the operand and param tables of the DAG (CSR,
+//! see EdgeSpan), the edge only keeps where its rows start so sorting moves small records and leaves the tables
+//! untouched.
+struct ExprEdge {
+  OpType type{};
+  DType data_type{};
+  uint32_t id{};
+  uint32_t num_inputs{};
+  uint32_t num_outputs{};
+  //! first slot in the operand table : the input tensor indices then the output ones. Group expressions list the
+  //! ids of their members instead.
+  uint32_t operands{};
+  //! first byte in the param table, trailing zero bytes of the params are not stored
+  uint32_t params{};
+  uint32_t param_bytes{};
+  //! group expressions only, the members keep their order
+  bool pinned{};
+};
 
-  constexpr ExprEdge() = default;
+//! Expressions of a DAG together with their operand and param tables
+struct EdgeSpan {
+  std::span<const ExprEdge> edges;
+  std::span<const uint32_t> operands;
+  std::span<const std::byte> params;
 
-  constexpr ExprEdge(ExpressionReflection exp_ref,
-    std::array<uint32_t, MANIFOLD_MAX_EXP_INPUT> &input_idxs,
-    std::array<uint32_t, MANIFOLD_MAX_EXP_OUTPUT> &output_idxs)
-    : ExpressionReflection(exp_ref), inp_idxs(input_idxs), out_idxs(output_idxs) {}
+  [[nodiscard]] constexpr size_t size() const noexcept { return edges.size(); }
 
-  constexpr explicit ExprEdge(const ExpressionReflection &exp_ref) : ExpressionReflection(exp_ref), inp_idxs(), out_idxs() {}
-};
+  [[nodiscard]] constexpr const ExprEdge &operator[](size_t idx) const { return edges[idx]; }
 
+  [[nodiscard]] constexpr auto begin() const noexcept { return edges.begin(); }
+
+  [[nodiscard]] constexpr auto end() const noexcept { return edges.end(); }
+
+  //! Input tensor indices of @param edge (member ids for a group)
+  [[nodiscard]] constexpr std::span<const uint32_t> inputs(const ExprEdge &edge) const {
+    return operands.subspan(edge.operands, edge.num_inputs);
+  }
+
+  [[nodiscard]] constexpr std::span<const uint32_t> outputs(const ExprEdge &edge) const {
+    return operands.subspan(edge.operands + edge.num_inputs, edge.num_outputs);
+  }
+
+  //! Params of @param edge as the expression was given them
+  [[nodiscard]] constexpr ExpressionReflection::PARAM_TYPE paramsOf(const ExprEdge &edge) const {
+    ExpressionReflection::PARAM_TYPE bytes{};
+    std::ranges::copy(params.subspan(edge.params, edge.param_bytes), bytes.begin());
+    return bytes;
+  }
+};
 
 }  // namespace manifold
 
@@ -45,25 +98,24 @@ struct std::formatter<manifold::TensorNode> : std::formatter<manifold::TensorRef
   template<typename FormatContext>
   constexpr auto format(const manifold::TensorNode &ten, FormatContext &ctx) const {
     std::format_to(ctx.out(), "{}\n", static_cast<manifold::TensorReflection>(ten));
-    std::format_to(ctx.out(), "incoming idx: {}\ntotal out: {}\n outgoing: [ ", ten.incoming, ten.total_out);
-
-    for (size_t i{}; i < ten.total_out; i++) { std::format_to(ctx.out(), "{} ", ten.outgoing.at(i)); }
-    return std::format_to(ctx.out(), "]");
+    return std::format_to(ctx.out(), "incoming idx: {}\ntotal out: {}", ten.incoming, ten.total_out);
   }
 };
 
 
 template<>
-struct std::formatter<manifold::ExprEdge> : std::formatter<manifold::ExpressionReflection> {
+struct std::formatter<manifold::ExprEdge> {
+  constexpr auto parse(format_parse_context &ctx) { return ctx.begin(); }
+
   template<typename FormatContext>
   constexpr auto format(const manifold::ExprEdge &expr, FormatContext &ctx) const {
-    std::format_to(ctx.out(), "{}\n", static_cast<manifold::ExpressionReflection>(expr));
-    std::format_to(ctx.out(), "input idxs: [ ");
-
-    for (size_t i{}; i < expr.num_inputs; i++) { std::format_to(ctx.out(), "{} ", expr.inp_idxs.at(i)); }
-    std::format_to(ctx.out(), "]\noutput idxs: [ ");
-
-    for (size_t i{}; i < expr.num_outputs; i++) { std::format_to(ctx.out(), "{} ", expr.out_idxs.at(i)); }
-    return std::format_to(ctx.out(), " ]");
+    std::format_to(ctx.out(),
+      "{}:\nid: {}\nnum_inputs: {}\nnum_outputs: {}\n",
+      manifold::optypeToString(expr.type),
+      expr.id,
+      expr.num_inputs,
+      expr.num_outputs);
+    return std::format_to(
+      ctx.out(), "operands at: {}\nparams at: {} ({} bytes)", expr.operands, expr.params, expr.param_bytes);
   }
 };
@@ -0,0 +1,268 @@
+#pragma once
+#include "manifold/runtime_graph.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+
+//! Graph files : a planned CompactRuntimeGraph (sorted expressions, tensor metadata, arena offsets and pool layout)
+//! stored so it can be loaded and run without redoing to_dag / topologicalSort / compact.
+//!
+//!     manifold::saveGraph("model.mfg", compact(builder.toDag().topologicalSort()));
+//!     scions::cpu::RuntimeCpuGraph graph(manifold::loadGraph("model.mfg"));
+//!
+//! Layout (native byte order) : a GraphFileHeader then the tensor, expression and offset tables, each at a
+//! GRAPH_FILE_ALIGN aligned position given by the header. Nothing in the file is an address, tensors are referred to
+//! by index and buffers by their offset in the pool of their dtype. Expressions keep their OpType, dtype and input
+//! count, everything a backend needs to pick the kernel of an op.
+//!
+//! Note: Records are stored with their in memory layout, padding written as zeroes so a graph always gives the same
+//!       file. The header holds the record sizes, the MANIFOLD_* limits they depend on and the tensor alignment the
+//!       offsets were planned with, a file written by a build with other limits, another alignment or another
+//!       OpType / DType list is rejected.
+
+namespace manifold {
+inline constexpr size_t GRAPH_FILE_ALIGN      = 64;
+inline constexpr uint32_t GRAPH_FILE_VERSION = 2;
+inline constexpr std::array<char, 4> GRAPH_FILE_MAGIC{ 'M', 'F', 'G', 'F' };
+
+struct GraphFileHeader {
+  std::array<char, 4> magic;
+  uint32_t version;
+  //! layout of the build that wrote the file
+  uint16_t max_in;
+  uint16_t max_out;
+  uint16_t max_rank;
+  uint16_t param_bytes;
+  uint16_t tensor_bytes;
+  uint16_t expression_bytes;
+  uint8_t op_types;
+  uint8_t dtypes;
+  //! MANIFOLD_TENSOR_ALIGN, the planned offsets are multiples of it
+  uint16_t tensor_align;
+  uint64_t data_size;
+  uint64_t op_size;
+  //! positions of the tables from the start of the file
+  uint64_t data_offset;
+  uint64_t expr_offset;
+  uint64_t offsets_offset;
+  uint64_t file_bytes;
+  GraphMetadata meta;
+};
+
+namespace _internal {
+  //! Header describing this build, the counts and table positions left to fill
+  inline GraphFileHeader graphFileLayout() {
+    GraphFileHeader header{};
+    header.magic            = GRAPH_FILE_MAGIC;
+    header.version          = GRAPH_FILE_VERSION;
+    header.max_in           = MANIFOLD_MAX_EXP_INPUT;
+    header.max_out          = MANIFOLD_MAX_EXP_OUTPUT;
+    header.max_rank         = MANIFOLD_MAX_RANK;
+    header.param_bytes      = MANIFOLD_PARAM_BYTES_MAX;
+    header.tensor_bytes     = sizeof(TensorReflection);
+    header.expression_bytes = sizeof(RuntimeExpression);
+    header.op_types         = static_cast<uint8_t>(OpType::BRUH) + 1;
+    header.dtypes           = NUM_DTYPE;
+    header.tensor_align     = MANIFOLD_TENSOR_ALIGN;
+    return header;
+  }
+
+  inline void packRecord(std::byte *out, const ShapeReflection &rec);
+  inline void packRecord(std::byte *out, const TensorReflection &rec);
+  inline void packRecord(std::byte *out, const RuntimeExpression &rec);
+  inline void packRecord(std::byte *out, const GraphMetadata &rec);
+  inline void packRecord(std::byte *out, const GraphFileHeader &rec);
+
+  //! Copies @param members of @param rec to their offset in @param out, sizeof(T) zeroed bytes. Padding isn't
+  //! copied, a raw copy of a record holds whatever its padding bytes were.
+  template<typename T, typename... M>
+  void packFields(std::byte *out, const T &rec, M T::*...members) {
+    const auto pack = [&]<typename F>(const F &field) {
+      std::byte *dst = out + (reinterpret_cast<const std::byte *>(&field) - reinterpret_cast<const std::byte *>(&rec));
+      if constexpr (std::has_unique_object_representations_v<F>) {
+        std::memcpy(dst, &field, sizeof(F));
+      } else {
+        packRecord(dst, field);
+      }
+    };
+    (pack(rec.*members), ...);
+  }
+
+  inline void packRecord(std::byte *out, const ShapeReflection &rec) {
+    packFields(out, rec, &ShapeReflection::rank, &ShapeReflection::shape);
+  }
+
+  inline void packRecord(std::byte *out, const TensorReflection &rec) {
+    using T = TensorReflection;
+    packFields(out, rec, &T::data_type, &T::size, &T::id, &T::shape, &T::storage_layout, &T::storage_type);
+  }
+
+  inline void packRecord(std::byte *out, const RuntimeExpression &rec) {
+    using E = RuntimeExpression;
+    packFields(out, rec, &E::type, &E::data_type, &E::id, &E::inp_size, &E::out_size, &E::input_indices);
+    packFields(out, rec, &E::output_indices, &E::params, &E::in_place, &E::group, &E::pinned);
+  }
+
+  inline void packRecord(std::byte *out, const GraphMetadata &rec) {
+    using G = GraphMetadata;
+    packFields(out, rec, &G::max_in, &G::max_out, &G::graph_op_size, &G::graph_data_size, &G::total);
+    packFields(out, rec, &G::unplanned, &G::tensors, &G::sizes);
+  }
+
+  inline void packRecord(std::byte *out, const GraphFileHeader &rec) {
+    using H = GraphFileHeader;
+    packFields(out, rec, &H::magic, &H::version, &H::max_in, &H::max_out, &H::max_rank, &H::param_bytes);
+    packFields(out, rec, &H::tensor_bytes, &H::expression_bytes, &H::op_types, &H::dtypes, &H::tensor_align);
+    packFields(out, rec, &H::data_size, &H::op_size, &H::data_offset, &H::expr_offset, &H::offsets_offset);
+    packFields(out, rec, &H::file_bytes, &H::meta);
+  }
+
+  //! Bytes of @param records as written to a graph file
+  template<typename T>
+  std::vector<std::byte> packTable(std::span<const T> records) {
+    std::vector<std::byte> bytes(records.size() * sizeof(T));
+    for (size_t i{}; i < records.size(); i++) { packRecord(bytes.data() + i * sizeof(T), records[i]); }
+    return bytes;
+  }
+
+  constexpr uint64_t alignFilePos(const uint64_t pos) {
+    return (pos + GRAPH_FILE_ALIGN - 1) / GRAPH_FILE_ALIGN * GRAPH_FILE_ALIGN;
+  }
+
+  //! Throws unless every index, dtype, op and offset of @param graph is in range and the operands of every expression
+  //! match its output (see operandsMatch), a loaded graph is then as safe to lower as one just compacted
+  inline void validateGraph(const CompactRuntimeGraph &graph, const std::string &source) {
+    const auto fail = [&](const std::string &what) {
+      throw std::runtime_error(std::format("Manifold: graph file {} is corrupted, {}", source, what));
+    };
+    const auto &meta = graph.meta;
+    if (meta.graph_data_size != graph.data.size() || meta.graph_op_size != graph.expressions.size()) {
+      fail("metadata doesn't match the tables");
+    }
+    size_t pools{};
+    for (uint8_t i{}; i < NUM_DTYPE; i++) {
+      const size_t bytes = meta.poolBytes(static_cast<DType>(i));
+      if (bytes / DTYPE_SIZES[i] != meta.sizes[i] || bytes > meta.total - std::min(pools, meta.total)) {
+        fail("pools don't fit the arena");
+      }
+      pools += bytes;
+    }
+
+    for (size_t i{}; i < graph.data.size(); i++) {
+      const TensorReflection &ten = graph.data[i];
+      if (static_cast<uint8_t>(ten.data_type) >= NUM_DTYPE || ten.shape.rank > MANIFOLD_MAX_RANK) {
+        fail(std::format("tensor {} has an unknown dtype or rank", i));
+      }
+      const size_t pool = meta.poolSize(ten.data_type);
+      if (graph.offsets[i] > pool || ten.size > pool - graph.offsets[i]) {
+        fail(std::format("tensor {} ends past its pool", i));
+      }
+      if (graph.offsets[i] % alignElements(ten.data_type) != 0) {
+        fail(std::format("tensor {} isn't aligned to {} bytes", i, MANIFOLD_TENSOR_ALIGN));
+      }
+    }
+
+    for (size_t i{}; i < graph.expressions.size(); i++) {
+      const RuntimeExpression &exp = graph.expressions[i];
+      const bool known = static_cast<uint8_t>(exp.type) <= static_cast<uint8_t>(OpType::BRUH)
+                         && static_cast<uint8_t>(exp.data_type) < NUM_DTYPE;
+      if (!known || exp.inp_size > MANIFOLD_MAX_EXP_INPUT || exp.out_size == 0
+          || exp.out_size > MANIFOLD_MAX_EXP_OUTPUT || (exp.isInPlace() && exp.in_place >= exp.inp_size)) {
+        fail(std::format("expression {} is malformed", i));
+      }
+      const auto in_range = [&](const uint32_t idx) { return idx < graph.data.size(); };
+      if (!std::all_of(exp.input_indices.begin(), exp.input_indices.begin() + exp.inp_size, in_range)
+          || !std::all_of(exp.output_indices.begin(), exp.output_indices.begin() + exp.out_size, in_range)) {
+        fail(std::format("expression {} uses a tensor out of the {} of the graph", i, graph.data.size()));
+      }
+      if (!operandsMatch(exp, std::span<const TensorReflection>(graph.data))) {
+        fail(std::format("expression {} has an operand of another size or dtype than its output", i));
+      }
+    }
+  }
+}  // namespace _internal
+
+//! Writes the planned @param graph to @param path
+inline void saveGraph(const std::filesystem::path &path, const CompactRuntimeGraph &graph) {
+  if (graph.offsets.size() != graph.data.size()) {
+    throw std::invalid_argument("Manifold: graph with an offset count not matching its tensor count");
+  }
+
+  GraphFileHeader header = _internal::graphFileLayout();
+  header.data_size       = graph.data.size();
+  header.op_size         = graph.expressions.size();
+  header.data_offset     = _internal::alignFilePos(sizeof(GraphFileHeader));
+  header.expr_offset     = _internal::alignFilePos(header.data_offset + header.data_size * sizeof(TensorReflection));
+  header.offsets_offset  = _internal::alignFilePos(header.expr_offset + header.op_size * sizeof(RuntimeExpression));
+  header.file_bytes      = header.offsets_offset + header.data_size * sizeof(uint64_t);
+  header.meta            = graph.meta;
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  const auto put = [&](const uint64_t pos, const std::span<const std::byte> bytes) {
+    const std::vector<char> padding(pos - static_cast<uint64_t>(file.tellp()));
+    file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+    file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+  };
+  std::array<std::byte, sizeof(GraphFileHeader)> header_bytes{};
+  _internal::packRecord(header_bytes.data(), header);
+  put(0, header_bytes);
+  put(header.data_offset, _internal::packTable(std::span(graph.data)));
+  put(header.expr_offset, _internal::packTable(std::span(graph.expressions)));
+  const std::vector<uint64_t> offsets(graph.offsets.begin(), graph.offsets.end());
+  put(header.offsets_offset, std::as_bytes(std::span(offsets)));
+  if (!file) { throw std::runtime_error(std::format("Manifold: couldn't write the graph file {}", path.string())); }
+}
+
+//! Reads back a graph written by saveGraph, the tables are read straight into the vectors of the graph.
+//! Throws std::runtime_error if @param path isn't a graph file of this build or is corrupted.
+[[nodiscard]] inline CompactRuntimeGraph loadGraph(const std::filesystem::path &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) { throw std::runtime_error(std::format("Manifold: couldn't open the graph file {}", path.string())); }
+
+  GraphFileHeader header{};
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  GraphFileHeader expected = _internal::graphFileLayout();
+  expected.version         = header.version;
+  const bool same_layout   = std::tie(header.max_in, header.max_out, header.max_rank, header.param_bytes)
+                             == std::tie(expected.max_in, expected.max_out, expected.max_rank, expected.param_bytes)
+                           && std::tie(header.tensor_bytes, header.expression_bytes, header.op_types, header.dtypes)
+                                == std::tie(expected.tensor_bytes,
+                                  expected.expression_bytes,
+                                  expected.op_types,
+                                  expected.dtypes)
+                           && header.tensor_align == expected.tensor_align;
+  if (!file || header.magic != GRAPH_FILE_MAGIC || header.version != GRAPH_FILE_VERSION || !same_layout) {
+    throw std::runtime_error(std::format(
+      "Manifold: {} is not a version {} graph file of this build", path.string(), GRAPH_FILE_VERSION));
+  }
+
+  const uint64_t file_bytes = std::filesystem::file_size(path);
+  const auto table_ends = [&](const uint64_t pos, const uint64_t count, const size_t record) {
+    return pos <= file_bytes && count <= (file_bytes - pos) / record;
+  };
+  if (header.file_bytes != file_bytes || !table_ends(header.data_offset, header.data_size, sizeof(TensorReflection))
+      || !table_ends(header.expr_offset, header.op_size, sizeof(RuntimeExpression))
+      || !table_ends(header.offsets_offset, header.data_size, sizeof(uint64_t))) {
+    throw std::runtime_error(std::format("Manifold: graph file {} is truncated", path.string()));
+  }
+
+  CompactRuntimeGraph graph;
+  graph.meta = header.meta;
+  graph.data.resize(header.data_size);
+  graph.expressions.resize(header.op_size);
+  std::vector<uint64_t> offsets(header.data_size);
+  const auto get = [&](const uint64_t pos, void *bytes, const size_t size) {
+    file.seekg(static_cast<std::streamoff>(pos));
+    file.read(static_cast<char *>(bytes), static_cast<std::streamsize>(size));
+  };
+  get(header.data_offset, graph.data.data(), graph.data.size() * sizeof(TensorReflection));
+  get(header.expr_offset, graph.expressions.data(), graph.expressions.size() * sizeof(RuntimeExpression));
+  get(header.offsets_offset, offsets.data(), offsets.size() * sizeof(uint64_t));
+  if (!file) { throw std::runtime_error(std::format("Manifold: couldn't read the graph file {}", path.string())); }
+  graph.offsets.assign(offsets.begin(), offsets.end());
+
+  _internal::validateGraph(graph, path.string());
+  return graph;
+}
+}  // namespace manifold
@@ -19,12 +19,32 @@
 #endif
 
 
-#ifndef MANIFOLD_TENSORNODE_MAX_OUT
-#define MANIFOLD_TENSORNODE_MAX_OUT 10
-#endif
-
 // used for compile time pararmeters
 #ifndef MANIFOLD_PARAM_BYTES_MAX
 #define MANIFOLD_PARAM_BYTES_MAX 32
 #endif
+
+// alignment (bytes) of every planned tensor buffer
+#ifndef MANIFOLD_TENSOR_ALIGN
+#define MANIFOLD_TENSOR_ALIGN 64
+#endif
+
+// peak DRAM bandwidth (GB/s) and arithmetic throughput (GFLOP/s) of the default MachineModel, see cost_model.hpp
+#ifndef MANIFOLD_PEAK_GBPS
+#define MANIFOLD_PEAK_GBPS 20.0
+#endif
+
+#ifndef MANIFOLD_PEAK_GFLOPS
+#define MANIFOLD_PEAK_GFLOPS 100.0
+#endif
+
+// SortOrder::MEMORY searches every order exhaustively up to this many units (groups or free expressions) ...
+#ifndef MANIFOLD_SCHEDULE_EXACT_MAX
+#define MANIFOLD_SCHEDULE_EXACT_MAX 24
+#endif
+
+// ... visiting at most this many partial orders, the best order found so far is kept when it runs out
+#ifndef MANIFOLD_SCHEDULE_SEARCH_BUDGET
+#define MANIFOLD_SCHEDULE_SEARCH_BUDGET 20000
+#endif
 // NOLINTEND
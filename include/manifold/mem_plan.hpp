@@ -0,0 +1,173 @@
+#pragma once
+
+#include "manifold/constants.hpp"
+#include "manifold/dag.hpp"
+#include "manifold/dag_node.hpp"
+#include "manifold/macro.hpp"
+#include "manifold/op_type.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace manifold {
+
+//! Positions (in the expression array) of the first and last expression touching a tensor.
+//! Graph inputs and outputs are pinned for the whole execution, ie. [0, UINT32_MAX].
+struct LiveRange {
+  uint32_t first{ UINT32_MAX };
+  uint32_t last{};
+
+  [[nodiscard]] constexpr bool pinned() const noexcept { return last == UINT32_MAX; }
+};
+
+//! Result of the memory planning of a sorted graph.
+//!
+//! Offsets are in **elements** of the tensor's own dtype pool, every dtype gets its own pool so a
+//! backend can keep typed containers. Buffers are reused as soon as the last reader of a tensor ran.
+template<size_t TSize, size_t ESize>
+struct MemoryPlan {
+  std::array<size_t, TSize> offsets{};
+  std::array<LiveRange, TSize> ranges{};
+  //! Input slot of the expression whose buffer is reused by output 0, UINT32_MAX if not in place
+  std::array<uint32_t, ESize> in_place{};
+  //! Planned (peak) number of elements for each dtype pool
+  std::array<size_t, NUM_DTYPE> pool_sizes{};
+};
+
+namespace _internal {
+  constexpr void computeLiveRanges(std::span<const TensorNode> data,
+    EdgeSpan edges,
+    std::span<LiveRange> ranges) {
+    for (uint32_t i{}; i < edges.size(); i++) {
+      const ExprEdge &edge = edges[i];
+      if (edge.type == OpType::EXP_GROUP) { continue; }
+
+      auto touch = [&ranges, i](uint32_t idx) {
+        LiveRange &range = ranges[idx];
+        range.first      = std::min(range.first, i);
+        range.last       = std::max(range.last, i);
+      };
+      for (const uint32_t idx : edges.inputs(edge)) { touch(idx); }
+      for (const uint32_t idx : edges.outputs(edge)) { touch(idx); }
+    }
+
+    // Inputs are filled by the user and outputs are read back after execution, none of them can be shared
+    for (uint32_t i{}; i < data.size(); i++) {
+      const TensorNode &ten = data[i];
+      if (ten.incoming == UINT32_MAX || ten.total_out == 0) { ranges[i] = LiveRange{ 0, UINT32_MAX }; }
+    }
+  }
+
+  //! Finds an input slot of @param edge whose buffer output 0 can take over. Only element wise ops are
+  //! eligible and the input must die at this very expression with nobody else holding its buffer.
+  constexpr uint32_t inPlaceCandidate(std::span<const TensorNode> data,
+    std::span<const LiveRange> ranges,
+    EdgeSpan edges,
+    const ExprEdge &edge,
+    uint32_t pos,
+    std::span<const uint32_t> block_of,
+    std::span<const uint32_t> busy_until) {
+    if (!isElementWise(edge.type) || edge.num_outputs != 1) { return UINT32_MAX; }
+    const uint32_t out         = edges.outputs(edge)[0];
+    const TensorNode &out_node = data[out];
+    const auto inputs          = edges.inputs(edge);
+
+    for (uint32_t j{}; j < inputs.size(); j++) {
+      const uint32_t inp = inputs[j];
+      if (inp == out || ranges[inp].pinned() || ranges[inp].last != pos) { continue; }
+
+      const TensorNode &inp_node = data[inp];
+      if (inp_node.data_type != out_node.data_type || inp_node.size != out_node.size) { continue; }
+      if (block_of[inp] == UINT32_MAX || busy_until[block_of[inp]] != pos) { continue; }
+      return j;
+    }
+    return UINT32_MAX;
+  }
+
+  //! Greedy liveness based planner. Walks the expressions in order and places every output either
+  //! on top of a dying input (in place), in the smallest free block that fits, or at the end of its pool.
+  //!
+  //! @param offsets  : element offset of every tensor inside its dtype pool
+  //! @param in_place : aliased input slot per expression or UINT32_MAX
+  constexpr void planMemory(std::span<const TensorNode> data,
+    EdgeSpan edges,
+    std::span<LiveRange> ranges,
+    std::span<size_t> offsets,
+    std::span<uint32_t> in_place,
+    std::array<size_t, NUM_DTYPE> &pool_sizes) {
+    computeLiveRanges(data, edges, ranges);
+
+    // Blocks are never split or merged, tensors in a graph tend to repeat the same few sizes
+    std::vector<DType> block_type;
+    std::vector<size_t> block_offset;
+    std::vector<size_t> block_extent;
+    std::vector<uint32_t> busy_until;
+    std::vector<uint32_t> block_of(data.size(), UINT32_MAX);
+
+    auto place = [&](uint32_t idx, uint32_t from) {
+      const TensorNode &ten = data[idx];
+      const size_t extent   = alignedExtent(ten);
+
+      uint32_t best = UINT32_MAX;
+      for (uint32_t b{}; b < block_type.size(); b++) {
+        if (block_type[b] != ten.data_type || busy_until[b] >= from || block_extent[b] < extent) { continue; }
+        if (best == UINT32_MAX || block_extent[b] < block_extent[best]) { best = b; }
+      }
+
+      if (best == UINT32_MAX) {
+        auto &pool = pool_sizes.at(static_cast<uint8_t>(ten.data_type));
+        best       = static_cast<uint32_t>(block_type.size());
+        block_type.push_back(ten.data_type);
+        block_offset.push_back(pool);
+        block_extent.push_back(extent);
+        busy_until.push_back(0);
+        pool += extent;
+      }
+      busy_until[best] = ranges[idx].last;
+      block_of[idx]    = best;
+      offsets[idx]     = block_offset[best];
+    };
+
+    for (uint32_t i{}; i < data.size(); i++) {
+      if (ranges[i].first == UINT32_MAX || data[i].incoming == UINT32_MAX) { place(i, 0); }
+    }
+
+    for (uint32_t i{}; i < edges.size(); i++) {
+      const ExprEdge &edge = edges[i];
+      in_place[i]          = UINT32_MAX;
+      if (edge.type == OpType::EXP_GROUP) { continue; }
+
+      const auto slot    = inPlaceCandidate(data, ranges, edges, edge, i, block_of, busy_until);
+      const auto outputs = edges.outputs(edge);
+      for (uint32_t j{}; j < outputs.size(); j++) {
+        const uint32_t out = outputs[j];
+        // Already written by an earlier expression (or read-modify-write), keep its buffer
+        if (block_of[out] != UINT32_MAX) { continue; }
+
+        if (j == 0 && slot != UINT32_MAX) {
+          const uint32_t block = block_of[edges.inputs(edge)[slot]];
+          busy_until[block]    = ranges[out].last;
+          block_of[out]        = block;
+          offsets[out]         = block_offset[block];
+          in_place[i]          = slot;
+          continue;
+        }
+        place(out, i);
+      }
+    }
+  }
+}  // namespace _internal
+
+//! Plans the memory of an already (topologically) sorted DAG.
+//!
+//! Note: The expression order of @param dag is the execution order, so call this on the result of
+//!       StaticDAG::topologicalSort
+template<size_t TSize, size_t ESize, size_t OSize, size_t PSize>
+[[nodiscard]] constexpr MemoryPlan<TSize, ESize> planMemory(const StaticDAG<TSize, ESize, OSize, PSize> &dag) {
+  MemoryPlan<TSize, ESize> plan{};
+  _internal::planMemory(dag.data, dag.edgeSpan(), plan.ranges, plan.offsets, plan.in_place, plan.pool_sizes);
+  return plan;
+}
+}  // namespace manifold
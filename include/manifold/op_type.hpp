@@ -65,6 +65,25 @@ constexpr inline uint16_t GetParamSize(OpType op, DType type) {
   }
 }
 
+//! Ops whose i-th output element only depends on the i-th element of the inputs, these
+//! can safely write into one of their (equally sized) input buffers. Only ops the CPU EP has a kernel for are listed,
+//! SIN, COS and ABS join once they get one.
+constexpr inline bool isElementWise(OpType op) {
+  switch (op) {
+  case OpType::ELM_ADD:
+  case OpType::ELM_SUB:
+  case OpType::ELM_MUL:
+  case OpType::ELM_DIV:
+  case OpType::COPY:
+  case OpType::EXPONENTIAL:
+  case OpType::SCL_ELM_ADD:
+  case OpType::SCL_ELM_SUB:
+  case OpType::SCL_ELM_MUL:
+  case OpType::SCL_ELM_DIV: return true;
+  default: return false;
+  }
+}
+
 constexpr inline std::string_view optypeToString(OpType e) {
   switch (e) {
   case OpType::ELM_ADD: return "ELM_ADD";
@@ -74,6 +93,14 @@ constexpr inline std::string_view optypeToString(OpType e) {
   case OpType::ELM_RANDOM: return "RANDOM_ELM";
   case OpType::ELM_FILL: return "FILL_ELM";
   case OpType::COPY: return "COPY";
+  case OpType::EXPONENTIAL: return "EXPONENTIAL";
+  case OpType::SIN: return "SIN";
+  case OpType::COS: return "COS";
+  case OpType::ABS: return "ABS";
+  case OpType::SCL_ELM_ADD: return "SCL_ELM_ADD";
+  case OpType::SCL_ELM_SUB: return "SCL_ELM_SUB";
+  case OpType::SCL_ELM_MUL: return "SCL_ELM_MUL";
+  case OpType::SCL_ELM_DIV: return "SCL_ELM_DIV";
   case OpType::ARRAY_AXPY: return "ARRAY_AXPY";
   case OpType::ARRAY_SUM: return "ARRAY_SUM";
   case OpType::ARRAY_MEAN: return "ARRAY_MEAN";
@@ -84,6 +111,7 @@ constexpr inline std::string_view optypeToString(OpType e) {
   case OpType::MAT_INV: return "MAT_INV";
   case OpType::MAT_ARR_MUL: return "MAT_ARR_MUL";
   case OpType::MAT_ARR_ADD: return "MAT_ARR_ADD";
+  case OpType::EXP_GROUP: return "EXP_GROUP";
   default: return "UNKNOWN";
   }
 }
@@ -5,7 +5,9 @@
 #include "../op_type.hpp"
 #include "manifold/constants.hpp"
 #include "manifold/macro.hpp"
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <type_traits>
@@ -36,6 +38,23 @@ constexpr std::array<std::byte, MANIFOLD_PARAM_BYTES_MAX> copyStructToByteArray(
   return result;
 }
 
+//! Reads back a @tparam PARAM written by copyStructToByteArray from the front of @param bytes, the params of an
+//! expression or a copy of their first bytes
+template<typename PARAM>
+constexpr PARAM copyStructFromByteArray(const auto &bytes)
+  requires std::is_trivially_copyable_v<PARAM>
+{
+  std::array<std::byte, sizeof(PARAM)> byteArray{};
+  std::copy_n(bytes.begin(), sizeof(PARAM), byteArray.begin());
+  return std::bit_cast<PARAM>(byteArray);
+}
+
+//! Value of the OneValue params of scalar and fill ops (OpType::SCL_ELM_*, OpType::ELM_FILL)
+template<typename T>
+constexpr T oneValue(const auto &bytes) {
+  return copyStructFromByteArray<OneValue<T>>(bytes).value;
+}
+
 // ------------------------------------------------ Base functions --------------------------------------------------
 template<typename T, std::size_t N>
 constexpr ExpressionReflection array_elm_op(uint32_t id, const OpType type, const T &out, const std::array<T, N> &inp)
@@ -0,0 +1,145 @@
+#pragma once
+#include "manifold/graph_file.hpp"
+#include <random>
+
+//! On disk cache of planned runtime graphs. The unsorted RuntimeDAG is hashed (tensor dtypes, shapes and ids,
+//! expression ops, operands and params, plus the sort objective and tensor alignment), a graph seen before, by this
+//! process or an earlier one, is loaded from its graph file instead of being sorted and planned again.
+//!
+//!     manifold::PlanCache cache("/var/cache/model");
+//!     scions::cpu::RuntimeCpuGraph graph(cache.plan(builder.toDag()));
+//!
+//! Plans are written to a temporary file renamed over the final one, concurrent processes sharing a directory only
+//! ever see complete graph files. The cache is best effort : an entry that can't be read (corrupted, written by
+//! another build) is planned again and replaced, a directory that can't be written only costs the saved planning.
+
+namespace manifold {
+namespace _internal {
+  //! 64 bit FNV-1a
+  class Fnv1a {
+  public:
+    void add(std::span<const std::byte> bytes) noexcept {
+      for (const std::byte byte : bytes) {
+        state ^= static_cast<uint64_t>(byte);
+        state *= 0x100000001b3ULL;
+      }
+    }
+
+    template<typename T>
+      requires std::is_trivially_copyable_v<T> && std::has_unique_object_representations_v<T>
+    void add(const T &value) noexcept {
+      add(std::as_bytes(std::span(&value, 1)));
+    }
+
+    [[nodiscard]] uint64_t value() const noexcept { return state; }
+
+  private:
+    uint64_t state = 0xcbf29ce484222325ULL;
+  };
+}  // namespace _internal
+
+//! Hash of everything planning @param dag with @param objective depends on, members are hashed one by one so
+//! padding never makes equal graphs differ
+[[nodiscard]] inline uint64_t graphHash(const RuntimeDAG &dag, SortOrder objective = SortOrder::INDEX) {
+  _internal::Fnv1a hash;
+  hash.add(GRAPH_FILE_VERSION);
+  // the planned offsets depend on it
+  hash.add(size_t{ MANIFOLD_TENSOR_ALIGN });
+  hash.add(objective);
+  hash.add(dag.data.size());
+  for (const TensorNode &ten : dag.data) {
+    hash.add(ten.data_type);
+    hash.add(ten.size);
+    hash.add(ten.id);
+    hash.add(ten.shape.rank);
+    hash.add(ten.shape.shape);
+    hash.add(ten.storage_layout);
+    hash.add(ten.storage_type);
+  }
+  hash.add(dag.edges.size());
+  for (const ExprEdge &exp : dag.edges) {
+    hash.add(exp.type);
+    hash.add(exp.data_type);
+    hash.add(exp.id);
+    hash.add(exp.num_inputs);
+    hash.add(exp.num_outputs);
+    hash.add(exp.pinned);
+    // tensors by id, their indices depend on the order they were added in
+    for (const uint32_t idx : dag.edgeSpan().inputs(exp)) {
+      hash.add(exp.type == OpType::EXP_GROUP ? idx : dag.data[idx].id);
+    }
+    for (const uint32_t idx : dag.edgeSpan().outputs(exp)) { hash.add(dag.data[idx].id); }
+    hash.add(dag.edgeSpan().paramsOf(exp));
+  }
+  return hash.value();
+}
+
+class PlanCache {
+public:
+  //! Creates @param directory if needed
+  [[nodiscard]] explicit PlanCache(std::filesystem::path directory) : dir(std::move(directory)) {
+    std::filesystem::create_directories(dir);
+  }
+
+  //! Planned @param dag (unsorted, as given by GraphBuilder::toDag) : loaded from the cache, or sorted with
+  //! @param objective, compacted and stored
+  [[nodiscard]] CompactRuntimeGraph plan(const RuntimeDAG &dag, SortOrder objective = SortOrder::INDEX) {
+    const std::filesystem::path path = planPath(graphHash(dag, objective));
+    std::error_code error;
+    if (std::filesystem::exists(path, error)) {
+      try {
+        CompactRuntimeGraph graph = loadGraph(path);
+        if (sameTensors(graph, dag)) {
+          hit_count++;
+          return graph;
+        }
+      } catch (const std::runtime_error &) {
+        // unreadable entry, planned again below and replaced
+      }
+    }
+
+    miss_count++;
+    CompactRuntimeGraph graph = compact(dag.topologicalSort(objective));
+    store(path, graph);
+    return graph;
+  }
+
+  //! Graph file of the plan with hash @param key
+  [[nodiscard]] std::filesystem::path planPath(uint64_t key) const { return dir / std::format("{:016x}.mfg", key); }
+
+  [[nodiscard]] const std::filesystem::path &directory() const noexcept { return dir; }
+
+  [[nodiscard]] size_t hits() const noexcept { return hit_count; }
+
+  [[nodiscard]] size_t misses() const noexcept { return miss_count; }
+
+private:
+  //! Guards against hash collisions, the plan has to be over the very tensors of @param dag
+  static bool sameTensors(const CompactRuntimeGraph &graph, const RuntimeDAG &dag) {
+    size_t ops{};
+    for (const ExprEdge &exp : dag.edges) { ops += exp.type != OpType::EXP_GROUP; }
+    return graph.expressions.size() == ops
+           && std::ranges::equal(graph.data, dag.data, [](const TensorReflection &a, const TensorNode &b) {
+                return a.id == b.id && a.data_type == b.data_type && a.size == b.size && a.shape.rank == b.shape.rank
+                       && a.shape.shape == b.shape.shape;
+              });
+  }
+
+  //! Writes @param graph next to @param path and renames it over @param path
+  void store(const std::filesystem::path &path, const CompactRuntimeGraph &graph) {
+    thread_local std::mt19937_64 engine{ std::random_device{}() };
+    const std::filesystem::path tmp = path.string() + std::format(".{:016x}.tmp", engine());
+    try {
+      saveGraph(tmp, graph);
+      std::filesystem::rename(tmp, path);
+    } catch (const std::exception &) {
+      std::error_code error;
+      std::filesystem::remove(tmp, error);
+    }
+  }
+
+  std::filesystem::path dir;
+  size_t hit_count{};
+  size_t miss_count{};
+};
+}  // namespace manifold
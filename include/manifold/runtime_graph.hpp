@@ -0,0 +1,303 @@
+#pragma once
+
+#include "manifold/dag.hpp"
+#include "manifold/mem_plan.hpp"
+#include "manifold/ops/element_wise_ops.hpp"
+#include "manifold/static_graph.hpp"
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+//! Runtime counterparts of SymbolContainer / StaticDAG / CompactStaticGraph. Graphs with thousands of ops are
+//! too expensive for constexpr evaluation, these keep the same node and edge types in flat vectors and run the
+//! very same passes (see _internal in dag.hpp and mem_plan.hpp) at runtime.
+
+namespace manifold {
+//! DAG built at runtime, same layout and semantics as StaticDAG. Its operand and param tables are sized exactly.
+struct RuntimeDAG {
+  std::vector<TensorNode> data;
+  std::vector<ExprEdge> edges;
+  std::vector<uint32_t> operands;
+  std::vector<std::byte> params;
+  std::vector<int64_t> group_mask;
+
+  //! DAG of @param tensors and @param exprs, groups are moved in front of their members like SymbolContainer::to_dag
+  [[nodiscard]] static RuntimeDAG fromReflections(std::span<const TensorReflection> tensors,
+    std::span<const ExpressionReflection> exprs) {
+    const auto [operand_count, param_count] = _internal::tableSizes(exprs);
+    RuntimeDAG dag{ std::vector<TensorNode>(tensors.begin(), tensors.end()),
+      std::vector<ExprEdge>(exprs.size()),
+      std::vector<uint32_t>(operand_count),
+      std::vector<std::byte>(param_count),
+      std::vector<int64_t>(exprs.size()) };
+
+    std::vector<ExpressionReflection> exprs_c(exprs.size());
+    _internal::groupExpressions<ExpressionReflection>(exprs, exprs_c, dag.group_mask);
+    _internal::generateIndices(
+      exprs_c, dag.edges, dag.operands, dag.params, dag.data, _internal::IdIndex(dag.data));
+    return dag;
+  }
+
+  //! The edges with their operand and param tables, what the graph passes work on
+  [[nodiscard]] EdgeSpan edgeSpan() const noexcept { return { edges, operands, params }; }
+
+  //! Topologically sorts and generates new DAG, see StaticDAG::topologicalSort
+  [[nodiscard]] RuntimeDAG topologicalSort(SortOrder objective = SortOrder::INDEX) const {
+    RuntimeDAG sorted{
+      data, std::vector<ExprEdge>(edges.size()), operands, params, std::vector<int64_t>(edges.size())
+    };
+    _internal::topologicalSort(edgeSpan(), sorted.data, sorted.edges, sorted.group_mask, objective);
+    return sorted;
+  }
+
+  //! See StaticDAG::memorySchedule
+  [[nodiscard]] std::pair<RuntimeDAG, ScheduleStats> memorySchedule() const {
+    RuntimeDAG sorted{
+      data, std::vector<ExprEdge>(edges.size()), operands, params, std::vector<int64_t>(edges.size())
+    };
+    ScheduleStats stats{};
+    _internal::topologicalSort(edgeSpan(), sorted.data, sorted.edges, sorted.group_mask, SortOrder::MEMORY, &stats);
+    return { std::move(sorted), stats };
+  }
+
+  //! See _internal::reuseDistance, the DAG should be topologically sorted
+  [[nodiscard]] uint64_t reuseDistance() const { return _internal::reuseDistance(data, edgeSpan()); }
+
+  [[nodiscard]] uint32_t tensorIdxFromID(uint32_t iden) const {
+    const auto iterator = std::ranges::find_if(data, [iden](const TensorNode &ten) { return ten.id == iden; });
+    return iterator == data.end() ? UINT32_MAX : static_cast<uint32_t>(std::ranges::distance(data.begin(), iterator));
+  }
+
+  [[nodiscard]] std::pair<uint32_t, uint32_t> ioCount() const noexcept {
+    uint32_t in{};
+    uint32_t out{};
+    for (const TensorNode &dat : data) {
+      if (dat.incoming == UINT32_MAX) { in++; }
+      if (dat.total_out == 0) { out++; }
+    }
+    return { in, out };
+  }
+
+  //! Prunes everything the tensors with ids @param out don't depend on. Unlike StaticDAG::subgraph the result is
+  //! relinked, so its indices point into the new (smaller) storage. Groups are dropped, members become free.
+  [[nodiscard]] RuntimeDAG subgraph(std::span<const uint32_t> out) const {
+    const _internal::IdIndex idx_of(data);
+    std::vector<uint32_t> roots(out.size());
+    for (size_t i{}; i < out.size(); i++) {
+      roots[i] = idx_of(out[i]);
+      if (roots[i] == UINT32_MAX) {
+        throw std::logic_error(std::format("Manifold: no tensor with id {} in the graph", out[i]));
+      }
+    }
+
+    std::vector<uint8_t> t_visited(data.size());
+    std::vector<uint8_t> e_visited(edges.size());
+    _internal::markDependencies(data, edgeSpan(), roots, t_visited, e_visited);
+
+    std::vector<TensorReflection> tensors;
+    std::vector<ExpressionReflection> exprs;
+    for (size_t i{}; i < data.size(); i++) {
+      if (t_visited[i]) { tensors.emplace_back(data[i]); }
+    }
+    for (size_t i{}; i < edges.size(); i++) {
+      if (e_visited[i]) { exprs.push_back(_internal::reflectExpression(edgeSpan(), edges[i], data)); }
+    }
+    return fromReflections(tensors, exprs);
+  }
+};
+
+//! Runtime SymbolContainer. Tensors and expressions get ids from a single counter unless they are added as
+//! reflections, in which case their own id is kept.
+//!
+//!     manifold::GraphBuilder builder;
+//!     const auto a = builder.tensor(DType::F32, std::array{ 1024U });
+//!     const auto b = builder.tensor(DType::F32, std::array{ 1024U });
+//!     builder.elementWise(OpType::EXPONENTIAL, b, std::array{ a });
+//!     const auto dag = builder.toDag().topologicalSort();
+class GraphBuilder {
+public:
+  void reserve(size_t num_tensors, size_t num_exprs) {
+    tensors.reserve(num_tensors);
+    exprs.reserve(num_exprs);
+    tensor_idx.reserve(num_tensors);
+  }
+
+  //! Adds a tensor keeping the id of @param ten
+  uint32_t tensor(const TensorReflection &ten) {
+    if (!tensor_idx.emplace(ten.id, static_cast<uint32_t>(tensors.size())).second) {
+      throw std::logic_error(std::format("Manifold: tensor id {} is used more than once", ten.id));
+    }
+    tensors.push_back(ten);
+    next_id = std::max(next_id, ten.id + 1);
+    return ten.id;
+  }
+
+  uint32_t tensor(DType type,
+    std::span<const uint32_t> shape,
+    Store storage          = Store::HOST,
+    layout storage_layout = layout::ROW_MAJOR) {
+    if (shape.empty() || shape.size() > MANIFOLD_MAX_RANK) {
+      throw std::logic_error("Manifold: tensor rank should be in [1, MANIFOLD_MAX_RANK]");
+    }
+    std::array<uint32_t, MANIFOLD_MAX_RANK> shape_arr{};
+    std::ranges::copy(shape, shape_arr.begin());
+
+    size_t size = 1;
+    for (const uint32_t dim : shape) { size *= dim; }
+    return tensor(TensorReflection(type,
+      size,
+      next_id,
+      ShapeReflection(static_cast<uint32_t>(shape.size()), shape_arr),
+      storage_layout,
+      storage));
+  }
+
+  //! Adds an expression keeping the id of @param exp, its tensors have to be added beforehand
+  uint32_t expression(const ExpressionReflection &exp) {
+    exprs.push_back(exp);
+    next_id = std::max(next_id, exp.id + 1);
+    return exp.id;
+  }
+
+  //! Many to one element wise op (or single input math op like OpType::EXPONENTIAL)
+  uint32_t elementWise(OpType type, uint32_t out, std::span<const uint32_t> inputs) {
+    if (inputs.empty() || inputs.size() > MANIFOLD_MAX_EXP_INPUT) {
+      throw std::logic_error("Manifold: Input count should be in [1, MANIFOLD_MAX_EXP_INPUT]");
+    }
+    ExpressionReflection::INP_TYPE inp{};
+    ExpressionReflection::OUT_TYPE outp{};
+    ExpressionReflection::PARAM_TYPE params{};
+    for (const uint32_t input : inputs) { checkOperand(input, out); }
+    std::ranges::copy(inputs, inp.begin());
+    outp[0] = out;
+    return expression(ExpressionReflection(
+      next_id, type, tensorAt(out).data_type, static_cast<uint32_t>(inputs.size()), inp, 1, outp, params));
+  }
+
+  //! In place array scalar op, @param type is one of the OpType::SCL_ELM_*
+  template<typename T>
+  uint32_t scalarOp(OpType type, uint32_t out, T value) {
+    ExpressionReflection::INP_TYPE inp{};
+    ExpressionReflection::OUT_TYPE outp{};
+    auto params = op::copyStructToByteArray(op::OneValue<T>{ value });
+    outp[0]     = out;
+    return expression(ExpressionReflection(next_id, type, tensorAt(out).data_type, 0, inp, 1, outp, params));
+  }
+
+  template<typename T>
+  uint32_t fill(std::span<const uint32_t> outputs, T value) {
+    if (outputs.empty() || outputs.size() > MANIFOLD_MAX_EXP_OUTPUT) {
+      throw std::logic_error("Manifold: Output count should be in [1, MANIFOLD_MAX_EXP_OUTPUT]");
+    }
+    ExpressionReflection::INP_TYPE inp{};
+    ExpressionReflection::OUT_TYPE outp{};
+    auto params = op::copyStructToByteArray(op::OneValue<T>{ value });
+    for (const uint32_t output : outputs.subspan(1)) { checkOperand(output, outputs[0]); }
+    std::ranges::copy(outputs, outp.begin());
+    return expression(ExpressionReflection(next_id,
+      OpType::ELM_FILL,
+      tensorAt(outputs[0]).data_type,
+      0,
+      inp,
+      static_cast<uint32_t>(outputs.size()),
+      outp,
+      params));
+  }
+
+  uint32_t copy(uint32_t out, uint32_t in) { return elementWise(OpType::COPY, out, std::array{ in }); }
+
+  //! Runtime op::exp_group over already added expressions, the group is placed right before its first member.
+  //! Pinned groups keep the order of their members, this is how read-modify-write ops (OpType::SCL_ELM_*) are
+  //! ordered after the op producing their tensor.
+  uint32_t group(std::span<const uint32_t> members, bool pin = false) {
+    if (members.size() < 2 || members.size() > MANIFOLD_MAX_EXP_INPUT) {
+      throw std::logic_error("Manifold: A group should have [2, MANIFOLD_MAX_EXP_INPUT] expressions");
+    }
+    ExpressionReflection::INP_TYPE inp{};
+    ExpressionReflection::OUT_TYPE outp{};
+    ExpressionReflection::PARAM_TYPE params{};
+    std::ranges::copy(members, inp.begin());
+    outp[0] = pin;
+
+    // members are usually the last expressions added, search from the back
+    auto first = exprs.end();
+    for (const uint32_t member : members) {
+      const auto iterator = std::ranges::find_if(
+        exprs.rbegin(), exprs.rend(), [member](const ExpressionReflection &exp) { return exp.id == member; });
+      if (iterator == exprs.rend()) {
+        throw std::logic_error(std::format("Manifold: group member {} has not been added", member));
+      }
+      first = std::min(first, std::prev(iterator.base()));
+    }
+    const uint32_t iden = next_id++;
+    exprs.insert(first,
+      ExpressionReflection(iden, OpType::EXP_GROUP, {}, static_cast<uint32_t>(members.size()), inp, 0, outp, params));
+    return iden;
+  }
+
+  [[nodiscard]] RuntimeDAG toDag() const { return RuntimeDAG::fromReflections(tensors, exprs); }
+
+  [[nodiscard]] const TensorReflection &tensorAt(uint32_t iden) const {
+    const auto iterator = tensor_idx.find(iden);
+    if (iterator == tensor_idx.end()) {
+      throw std::logic_error(std::format("Manifold: no tensor with id {} in the builder", iden));
+    }
+    return tensors[iterator->second];
+  }
+
+  [[nodiscard]] size_t tensorCount() const noexcept { return tensors.size(); }
+
+  [[nodiscard]] size_t expressionCount() const noexcept { return exprs.size(); }
+
+private:
+  //! Element wise ops run every operand over the size of their output, @param operand must match @param out
+  void checkOperand(uint32_t operand, uint32_t out) const {
+    const TensorReflection &ten = tensorAt(operand);
+    const TensorReflection &res = tensorAt(out);
+    if (ten.size != res.size || ten.data_type != res.data_type) {
+      throw std::logic_error(std::format("Manifold: tensor {} ({} {}) can't be an operand of tensor {} ({} {})",
+        operand,
+        ten.size,
+        dtypeToString(ten.data_type),
+        out,
+        res.size,
+        dtypeToString(res.data_type)));
+    }
+  }
+
+  std::vector<TensorReflection> tensors;
+  std::vector<ExpressionReflection> exprs;
+  std::unordered_map<uint32_t, uint32_t> tensor_idx;
+  uint32_t next_id{};
+};
+
+using RuntimeExpression = CompactExpression<MANIFOLD_MAX_EXP_INPUT, MANIFOLD_MAX_EXP_OUTPUT>;
+
+//! Executable form of a RuntimeDAG, see CompactStaticGraph. @ref meta carries the pool layout so a backend can
+//! allocate a single arena exactly as it does for static graphs.
+struct CompactRuntimeGraph {
+  std::vector<TensorReflection> data;
+  std::vector<RuntimeExpression> expressions;
+  std::vector<size_t> offsets;
+  GraphMetadata meta;
+};
+
+//! Plans the memory of an already (topologically) sorted @param dag and lowers it to its executable form
+[[nodiscard]] inline CompactRuntimeGraph compact(const RuntimeDAG &dag) {
+  std::vector<LiveRange> ranges(dag.data.size());
+  std::vector<size_t> offsets(dag.data.size());
+  std::vector<uint32_t> in_place(dag.edges.size());
+  std::array<size_t, NUM_DTYPE> pool_sizes{};
+  _internal::planMemory(dag.data, dag.edgeSpan(), ranges, offsets, in_place, pool_sizes);
+
+  CompactRuntimeGraph graph{ std::vector<TensorReflection>(dag.data.begin(), dag.data.end()),
+    {},
+    std::move(offsets),
+    _internal::graphMetadata(dag.data, dag.edges, pool_sizes) };
+  graph.expressions.resize(graph.meta.graph_op_size);
+  _internal::compactExpressions<MANIFOLD_MAX_EXP_INPUT, MANIFOLD_MAX_EXP_OUTPUT>(
+    dag.edgeSpan(), in_place, dag.group_mask, graph.expressions);
+  return graph;
+}
+}  // namespace manifold
@@ -0,0 +1,225 @@
+#pragma once
+#include "manifold/macro.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+//! Peak memory driven scheduling (SortOrder::MEMORY). The order of independent branches decides how many
+//! intermediate tensors are alive at once, this picks the topological order with the smallest peak of live bytes.
+//! Small graphs are searched exhaustively (branch and bound, see MANIFOLD_SCHEDULE_EXACT_MAX and
+//! MANIFOLD_SCHEDULE_SEARCH_BUDGET), larger ones greedily run the ready unit that grows the live set the least.
+//!
+//!     const auto [dag, stats] = graph.memorySchedule();
+//!     std::print("{} -> {} bytes", stats.index_peak, stats.peak);
+
+namespace manifold {
+//! Outcome of SortOrder::MEMORY, peaks are bytes of intermediate tensors alive at once (graph inputs and outputs
+//! always are and aren't counted). The planner may need more than the peak as it never splits buffers.
+struct ScheduleStats {
+  //! peak of the SortOrder::INDEX order
+  size_t index_peak;
+  //! peak of the order picked
+  size_t peak;
+  //! the search went through every order, @ref peak is the smallest possible
+  bool exhaustive;
+  //! partial orders visited by the exhaustive search
+  uint64_t visited;
+};
+
+namespace _internal {
+  //! Tensors every unit touches and the bytes of every tensor, both as seen by the scheduler
+  struct LiveModel {
+    //! tensors of unit u are tensors[offsets[u] .. offsets[u + 1]], each listed once
+    std::span<const uint32_t> offsets;
+    std::span<const uint32_t> tensors;
+    //! aligned bytes of every tensor, 0 for the graph inputs and outputs
+    std::span<const size_t> bytes;
+  };
+
+  //! Live bytes as units run : a tensor is allocated by the first unit touching it and freed after the last one
+  class LiveSet {
+  public:
+    constexpr explicit LiveSet(const LiveModel &live_model)
+      : model(live_model), remaining(model.bytes.size()), alive(model.bytes.size()) {
+      for (const uint32_t ten : model.tensors) { remaining[ten]++; }
+      touches = remaining;
+    }
+
+    //! Runs @param unit, @return the live bytes while it runs
+    constexpr size_t apply(uint32_t unit) {
+      for (uint32_t k = model.offsets[unit]; k < model.offsets[unit + 1]; k++) {
+        const uint32_t ten = model.tensors[k];
+        if (!alive[ten] && remaining[ten] == touches[ten]) {
+          alive[ten] = 1;
+          live += model.bytes[ten];
+        }
+      }
+      const size_t peak = live;
+      for (uint32_t k = model.offsets[unit]; k < model.offsets[unit + 1]; k++) {
+        const uint32_t ten = model.tensors[k];
+        if (--remaining[ten] == 0) {
+          alive[ten] = 0;
+          live -= model.bytes[ten];
+        }
+      }
+      return peak;
+    }
+
+    //! Reverts apply(@param unit), units have to be undone in reverse order
+    constexpr void undo(uint32_t unit) {
+      for (uint32_t k = model.offsets[unit]; k < model.offsets[unit + 1]; k++) {
+        const uint32_t ten = model.tensors[k];
+        if (remaining[ten]++ == 0) {
+          alive[ten] = 1;
+          live += model.bytes[ten];
+        }
+      }
+      for (uint32_t k = model.offsets[unit]; k < model.offsets[unit + 1]; k++) {
+        const uint32_t ten = model.tensors[k];
+        if (alive[ten] != 0 && remaining[ten] == touches[ten]) {
+          alive[ten] = 0;
+          live -= model.bytes[ten];
+        }
+      }
+    }
+
+    [[nodiscard]] constexpr size_t liveBytes() const noexcept { return live; }
+
+  private:
+    LiveModel model;
+    std::vector<uint32_t> remaining;
+    std::vector<uint32_t> touches;
+    std::vector<uint8_t> alive;
+    size_t live{};
+  };
+
+  //! Peak live bytes of running the units in @param order
+  constexpr size_t orderPeak(const LiveModel &model, std::span<const uint32_t> order) {
+    LiveSet set(model);
+    size_t peak{};
+    for (const uint32_t unit : order) { peak = std::max(peak, set.apply(unit)); }
+    return peak;
+  }
+
+  //! Branch and bound over every topological order, an order only replaces @param best_order when its peak is below
+  //! @param start_peak (the peak of best_order) and the peak of every order found since
+  class ExhaustiveSchedule {
+  public:
+    constexpr ExhaustiveSchedule(std::span<const uint32_t> csr_offsets,
+      std::span<const uint32_t> csr_succ,
+      std::vector<uint32_t> degrees,
+      const LiveModel &model,
+      std::vector<uint32_t> &best_order,
+      size_t start_peak)
+      : offsets(csr_offsets), succ(csr_succ), in_degree(std::move(degrees)), set(model),
+        scheduled(in_degree.size()), best(best_order), best_peak(start_peak) {}
+
+    //! @return true if every order was visited within the budget
+    constexpr bool run() {
+      search(0);
+      return visited <= MANIFOLD_SCHEDULE_SEARCH_BUDGET;
+    }
+
+    [[nodiscard]] constexpr size_t peak() const noexcept { return best_peak; }
+
+    [[nodiscard]] constexpr uint64_t visitedCount() const noexcept { return visited; }
+
+  private:
+    constexpr void search(size_t peak) {
+      if (++visited > MANIFOLD_SCHEDULE_SEARCH_BUDGET) { return; }
+      if (order.size() == in_degree.size()) {
+        best_peak = peak;
+        best      = order;
+        return;
+      }
+
+      for (uint32_t unit{}; unit < in_degree.size(); unit++) {
+        if (scheduled[unit] != 0 || in_degree[unit] != 0) { continue; }
+        const size_t step = std::max(peak, set.apply(unit));
+        if (step < best_peak) {
+          scheduled[unit] = 1;
+          order.push_back(unit);
+          for (uint32_t k = offsets[unit]; k < offsets[unit + 1]; k++) { in_degree[succ[k]]--; }
+          search(step);
+          for (uint32_t k = offsets[unit]; k < offsets[unit + 1]; k++) { in_degree[succ[k]]++; }
+          order.pop_back();
+          scheduled[unit] = 0;
+        }
+        set.undo(unit);
+        if (visited > MANIFOLD_SCHEDULE_SEARCH_BUDGET) { return; }
+      }
+    }
+
+    std::span<const uint32_t> offsets;
+    std::span<const uint32_t> succ;
+    std::vector<uint32_t> in_degree;
+    LiveSet set;
+    std::vector<uint8_t> scheduled;
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> &best;
+    size_t best_peak;
+    uint64_t visited{};
+  };
+
+  //! Order of the units (CSR dependencies @param offsets / @param succ) with the smallest peak of live bytes.
+  //! @param order receives the order, @param stats (optional) its peak against @param index_order.
+  constexpr void memoryOrder(std::span<const uint32_t> offsets,
+    std::span<const uint32_t> succ,
+    std::vector<uint32_t> in_degree,
+    const LiveModel &model,
+    std::span<const uint32_t> index_order,
+    std::vector<uint32_t> &order,
+    ScheduleStats *stats = nullptr) {
+    const auto u_size = static_cast<uint32_t>(in_degree.size());
+
+    // Greedy : the ready unit with the smallest live bytes while it runs, then after it ran
+    LiveSet set(model);
+    std::vector<uint32_t> degrees(in_degree);
+    std::vector<uint32_t> ready;
+    for (uint32_t i{}; i < u_size; i++) {
+      if (degrees[i] == 0) { ready.push_back(i); }
+    }
+    size_t peak{};
+    while (!ready.empty()) {
+      size_t pick{};
+      size_t pick_step{ SIZE_MAX };
+      size_t pick_after{ SIZE_MAX };
+      for (size_t r{}; r < ready.size(); r++) {
+        const size_t step  = set.apply(ready[r]);
+        const size_t after = set.liveBytes();
+        set.undo(ready[r]);
+        if (step < pick_step || (step == pick_step && after < pick_after)) {
+          pick       = r;
+          pick_step  = step;
+          pick_after = after;
+        }
+      }
+      const uint32_t unit = ready[pick];
+      ready.erase(ready.begin() + static_cast<std::ptrdiff_t>(pick));
+      peak = std::max(peak, set.apply(unit));
+      order.push_back(unit);
+      for (uint32_t k = offsets[unit]; k < offsets[unit + 1]; k++) {
+        if (--degrees[succ[k]] == 0) { ready.insert(std::ranges::upper_bound(ready, succ[k]), succ[k]); }
+      }
+    }
+
+    const size_t index_peak = orderPeak(model, index_order);
+    if (index_peak < peak) {
+      order.assign(index_order.begin(), index_order.end());
+      peak = index_peak;
+    }
+
+    bool exhaustive{};
+    uint64_t visited{};
+    if (u_size <= MANIFOLD_SCHEDULE_EXACT_MAX) {
+      ExhaustiveSchedule search(offsets, succ, std::move(in_degree), model, order, peak);
+      exhaustive = search.run();
+      peak       = search.peak();
+      visited    = search.visitedCount();
+    }
+    if (stats != nullptr) { *stats = ScheduleStats{ index_peak, peak, exhaustive, visited }; }
+  }
+}  // namespace _internal
+}  // namespace manifold
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "manifold/dag.hpp"
+#include "manifold/mem_plan.hpp"
 
 namespace manifold {
 
@@ -9,8 +10,183 @@ struct SymbolContainer {
   std::array<TensorReflection, TSize> tensors;
   std::array<ExpressionReflection, ExpSize> exprs;
 
+  //! DAG with operand and param tables sized for the largest expressions, usable where the container isn't a
+  //! constant (inside a consteval function)
   [[nodiscard]] constexpr StaticDAG<TSize, ExpSize> to_dag() const { return StaticDAG<TSize, ExpSize>(tensors, exprs); }
+
+  //! Operand slots and param bytes the expressions take, see to_dag<Sizes>()
+  [[nodiscard]] constexpr std::pair<size_t, size_t> tableSizes() const { return _internal::tableSizes(exprs); }
+
+  //! DAG with exact operand and param tables, @tparam Sizes should come from tableSizes()
+  //!
+  //!     static constexpr auto container = makeContainer();
+  //!     static constexpr auto dag       = container.to_dag<container.tableSizes()>().topologicalSort();
+  template<std::pair<size_t, size_t> Sizes>
+  [[nodiscard]] constexpr StaticDAG<TSize, ExpSize, Sizes.first, Sizes.second> to_dag() const {
+    return StaticDAG<TSize, ExpSize, Sizes.first, Sizes.second>(tensors, exprs);
+  }
+};
+
+//! Everything an execution provider needs to size its containers at compile time, generated from the
+//! memory plan of a sorted DAG. Sizes are in elements of the respective dtype.
+struct GraphMetadata {
+  size_t max_in;
+  size_t max_out;
+  size_t graph_op_size;
+  size_t graph_data_size;
+  //! total bytes of all the (aligned) pools, ie. the planned peak memory of the graph
+  size_t total;
+  //! bytes every tensor would take with a buffer of its own, @ref total is what is left after reuse
+  size_t unplanned;
+
+  std::array<uint16_t, NUM_DTYPE> tensors;
+  std::array<size_t, NUM_DTYPE> sizes;
+
+  [[nodiscard]] constexpr size_t poolSize(DType type) const { return sizes.at(static_cast<uint8_t>(type)); }
+
+  [[nodiscard]] constexpr size_t poolBytes(DType type) const {
+    return poolSize(type) * DTYPE_SIZES.at(static_cast<uint8_t>(type));
+  }
+
+  //! Planned peak bytes of every tensor of @param type, buffer reuse and alignment included
+  [[nodiscard]] constexpr size_t peakBytes(DType type) const { return poolBytes(type); }
+
+  //! Planned peak bytes of the whole graph, the size of the single arena backends allocate
+  [[nodiscard]] constexpr size_t peakBytes() const noexcept { return total; }
+
+  [[nodiscard]] constexpr bool fitsIn(size_t budget) const noexcept { return total <= budget; }
+
+  [[nodiscard]] constexpr bool fitsIn(DType type, size_t budget) const { return peakBytes(type) <= budget; }
+
+  //! Byte offset of the pool of @param type inside a single arena of @ref total bytes
+  [[nodiscard]] constexpr size_t poolByteOffset(DType type) const {
+    size_t offset{};
+    for (uint8_t i{}; i < static_cast<uint8_t>(type); i++) { offset += poolBytes(static_cast<DType>(i)); }
+    return offset;
+  }
+};
+
+//! Expression of a CompactStaticGraph, group expressions are dropped and indices point into
+//! CompactStaticGraph::data
+template<size_t MaxIn, size_t MaxOut>
+struct CompactExpression {
+  OpType type;
+  DType data_type;
+  uint32_t id;
+  uint32_t inp_size;
+  uint32_t out_size;
+  std::array<uint32_t, MaxIn> input_indices;
+  std::array<uint32_t, MaxOut> output_indices;
+  ExpressionReflection::PARAM_TYPE params;
+  //! input slot whose buffer is reused by output 0, UINT32_MAX when the op is not in place
+  uint32_t in_place;
+  //! position of the group expression this one is a member of in the sorted DAG, UINT32_MAX when it is free
+  uint32_t group;
+  //! member of a pinned group : the group runs back to back, in order, on a single worker
+  bool pinned;
+
+  [[nodiscard]] constexpr bool isInPlace() const noexcept { return in_place != UINT32_MAX; }
 };
+
+//! Executable form of a StaticDAG : only real ops in execution order plus the planned offset of every tensor
+template<size_t DataSize, size_t OpSize, size_t MaxIn, size_t MaxOut>
+struct CompactStaticGraph {
+  std::array<TensorReflection, DataSize> data;
+  std::array<CompactExpression<MaxIn, MaxOut>, OpSize> expressions;
+  std::array<size_t, DataSize> offsets;
+};
+
+namespace _internal {
+  //! Whether every operand of @param exp has the size and dtype of its output 0. Element wise kernels run all the
+  //! operands over the size of output 0, a smaller or narrower one would be accessed past its end.
+  template<typename Exp>
+  constexpr bool operandsMatch(const Exp &exp, std::span<const TensorReflection> data) {
+    const TensorReflection &out = data[exp.output_indices[0]];
+    const auto same             = [&](const uint32_t idx) {
+      return data[idx].size == out.size && data[idx].data_type == out.data_type;
+    };
+    return std::all_of(exp.input_indices.begin(), exp.input_indices.begin() + exp.inp_size, same)
+           && std::all_of(exp.output_indices.begin() + 1, exp.output_indices.begin() + exp.out_size, same);
+  }
+
+  constexpr GraphMetadata graphMetadata(std::span<const TensorNode> data,
+    std::span<const ExprEdge> edges,
+    const std::array<size_t, NUM_DTYPE> &pool_sizes) {
+    GraphMetadata meta{};
+    meta.graph_data_size = data.size();
+    meta.sizes           = pool_sizes;
+
+    for (const ExprEdge &edge : edges) {
+      if (edge.type == OpType::EXP_GROUP) { continue; }
+      meta.graph_op_size++;
+      meta.max_in  = std::max<size_t>(meta.max_in, edge.num_inputs);
+      meta.max_out = std::max<size_t>(meta.max_out, edge.num_outputs);
+    }
+    for (const TensorNode &ten : data) {
+      meta.tensors.at(static_cast<uint8_t>(ten.data_type))++;
+      meta.unplanned += alignedExtent(ten) * DTYPE_SIZES.at(static_cast<uint8_t>(ten.data_type));
+    }
+    for (uint8_t i{}; i < NUM_DTYPE; i++) { meta.total += meta.poolBytes(static_cast<DType>(i)); }
+    return meta;
+  }
+
+  //! Writes the real (non group) expressions of @param edges to @param expressions in order, the group each one
+  //! belongs to comes from @param group_mask (see groupExpressions)
+  template<size_t MaxIn, size_t MaxOut>
+  constexpr void compactExpressions(EdgeSpan edges,
+    std::span<const uint32_t> in_place,
+    std::span<const int64_t> group_mask,
+    std::span<CompactExpression<MaxIn, MaxOut>> expressions) {
+    for (uint32_t i{}, jx{}; i < edges.size(); i++) {
+      const ExprEdge &edge = edges[i];
+      if (edge.type == OpType::EXP_GROUP) { continue; }
+
+      auto &exp     = expressions[jx++];
+      exp.type      = edge.type;
+      exp.data_type = edge.data_type;
+      exp.id        = edge.id;
+      exp.inp_size  = edge.num_inputs;
+      exp.out_size  = edge.num_outputs;
+      exp.params    = edges.paramsOf(edge);
+      exp.in_place  = in_place[i];
+      // the mask of a group at position 0 is 0 either way, whether it is pinned is read from the group itself
+      const auto group = static_cast<uint32_t>(group_mask[i] < 0 ? -group_mask[i] : group_mask[i]);
+      exp.group        = group == i ? UINT32_MAX : group;
+      exp.pinned       = exp.group != UINT32_MAX && edges[group].pinned;
+      std::ranges::copy(edges.inputs(edge), exp.input_indices.begin());
+      std::ranges::copy(edges.outputs(edge), exp.output_indices.begin());
+    }
+  }
+}  // namespace _internal
+
+template<size_t TSize, size_t ESize, size_t OSize, size_t PSize>
+[[nodiscard]] constexpr GraphMetadata graphMetadata(const StaticDAG<TSize, ESize, OSize, PSize> &dag) {
+  return _internal::graphMetadata(dag.data, dag.edges, planMemory(dag).pool_sizes);
+}
+
+//! Fails constant evaluation (so the build) with a readable error when the planned peak memory of @param meta is
+//! over @param budget bytes
+//!
+//!     static constexpr auto meta = manifold::graphMetadata(graph);
+//!     static_assert(manifold::checkMemoryBudget(meta, 256 * 1024));
+[[nodiscard]] consteval bool checkMemoryBudget(const GraphMetadata &meta, const size_t budget) {
+  if (!meta.fitsIn(budget)) { throw std::logic_error("Manifold: planned peak memory of the graph is over budget"); }
+  return true;
+}
+
+//! Lowers a sorted @param dag to its executable form, @tparam G should come from graphMetadata(dag)
+template<GraphMetadata G, size_t TSize, size_t ESize, size_t OSize, size_t PSize>
+[[nodiscard]] constexpr CompactStaticGraph<G.graph_data_size, G.graph_op_size, G.max_in, G.max_out> compact(
+  const StaticDAG<TSize, ESize, OSize, PSize> &dag) {
+  static_assert(G.graph_data_size == TSize, "Manifold: GraphMetadata was not generated from this DAG");
+  const auto plan = planMemory(dag);
+
+  CompactStaticGraph<G.graph_data_size, G.graph_op_size, G.max_in, G.max_out> graph{};
+  for (size_t i{}; i < TSize; i++) { graph.data[i] = dag.data[i]; }
+  graph.offsets = plan.offsets;
+  _internal::compactExpressions<G.max_in, G.max_out>(dag.edgeSpan(), plan.in_place, dag.group_mask, graph.expressions);
+  return graph;
+}
 }  // namespace manifold
 
 template<size_t A, size_t B>
@@ -26,36 +202,3 @@ struct std::formatter<manifold::SymbolContainer<A, B>> : std::formatter<std::str
     return std::format_to(ctx.out(), "\n\n");
   }
 };
-// Todo : might need this when implementing mem stores
-// struct GraphMetadata {
-//   size_t max_in;
-//   size_t max_out;
-//   // size_t max_params;
-//   size_t graph_op_size;
-//   size_t graph_data_size;
-//   size_t total;
-
-//   uint16_t u8_tensors;
-//   uint16_t u16_tensors;
-//   uint16_t u32_tensors;
-//   uint16_t u64_tensors;
-//   uint16_t i8_tensors;
-//   uint16_t i16_tensors;
-//   uint16_t i32_tensors;
-//   uint16_t i64_tensors;
-//   uint16_t f32_tensors;
-//   uint16_t f64_tensors;
-
-//   size_t u8_size;
-//   size_t u16_size;
-//   size_t u32_size;
-//   size_t u64_size;
-
-//   size_t i8_size;
-//   size_t i16_size;
-//   size_t i32_size;
-//   size_t i64_size;
-
-//   size_t f32_size;
-//   size_t f64_size;
-// };
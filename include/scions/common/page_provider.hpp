@@ -0,0 +1,205 @@
+#pragma once
+#include "manifold/macro.hpp"
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+//! Page providers : where the memory of a store comes from. HugePages tries, in order, explicit huge pages
+//! (MAP_HUGETLB, 1 GiB then 2 MiB, they need pages reserved in /proc/sys/vm/nr_hugepages), transparent huge pages
+//! (madvise(MADV_HUGEPAGE) over a 2 MiB aligned mapping, when THP is enabled) and finally normal pages. Every store
+//! reports the kind of pages it got, large tensors walked through 4 KiB pages spend a lot of time in dTLB misses.
+//!
+//!     scions::cpu::CpuMemStore<META> store(GRAPH);
+//!     store.initializeMemory();                       // HugePages{}
+//!     std::println("{}", scions::mem::pageKindToString(store.pageKind()));
+//!
+//! Note: Only depends on the standard library and the OS, shared by the CPU EP (re-exported in scions::cpu by
+//!       scions/ep/cpu/page_provider.hpp) and the v1 memory managers (in scions::ep::cpu). Mapped pages come zeroed,
+//!       heap ones don't. No page is written here, NUMA first touch (see numa.hpp) still applies.
+
+namespace scions::mem {
+enum class PageKind : uint8_t {
+  //! 4 KiB pages, never backed by transparent huge pages
+  NORMAL,
+  //! anonymous mapping advised to the kernel for transparent huge pages (THP in "always" or "madvise" mode). The
+  //! kernel backs it with 2 MiB pages when it has free ones at fault time, AnonHugePages in /proc/self/smaps tells
+  //! how much it really got.
+  THP_ADVISED,
+  HUGETLB_2M,
+  HUGETLB_1G,
+};
+
+constexpr std::string_view pageKindToString(const PageKind kind) {
+  switch (kind) {
+  case PageKind::NORMAL: return "normal";
+  case PageKind::THP_ADVISED: return "transparent huge (advised)";
+  case PageKind::HUGETLB_2M: return "hugetlb 2 MiB";
+  case PageKind::HUGETLB_1G: return "hugetlb 1 GiB";
+  }
+  return "unknown";
+}
+
+//! Memory of an arena, given back by the provider that made it once the buffer is destroyed
+class PageBuffer {
+public:
+  using Release = void (*)(std::byte *, size_t);
+
+  PageBuffer() = default;
+
+  //! @param bytes : size of the allocation, at least the requested size
+  [[nodiscard]] PageBuffer(std::byte *data, size_t bytes, PageKind kind, Release release) noexcept
+    : ptr(data), length(bytes), page_kind(kind), release_fn(release) {}
+
+  PageBuffer(PageBuffer &&other) noexcept
+    : ptr(std::exchange(other.ptr, nullptr)), length(std::exchange(other.length, 0)), page_kind(other.page_kind),
+      release_fn(other.release_fn) {}
+
+  PageBuffer &operator=(PageBuffer &&other) noexcept {
+    if (this != &other) {
+      reset();
+      ptr        = std::exchange(other.ptr, nullptr);
+      length     = std::exchange(other.length, 0);
+      page_kind  = other.page_kind;
+      release_fn = other.release_fn;
+    }
+    return *this;
+  }
+
+  PageBuffer(const PageBuffer &)            = delete;
+  PageBuffer &operator=(const PageBuffer &) = delete;
+
+  ~PageBuffer() { reset(); }
+
+  [[nodiscard]] std::byte *data() const noexcept { return ptr; }
+
+  [[nodiscard]] size_t size() const noexcept { return length; }
+
+  [[nodiscard]] PageKind kind() const noexcept { return page_kind; }
+
+private:
+  void reset() noexcept {
+    if (ptr != nullptr) { release_fn(ptr, length); }
+    ptr = nullptr;
+  }
+
+  std::byte *ptr{};
+  size_t length{};
+  PageKind page_kind{ PageKind::NORMAL };
+  Release release_fn{};
+};
+
+template<typename P>
+concept PageProvider = requires(const P &provider, size_t bytes) {
+  { provider.allocate(bytes) } -> std::same_as<PageBuffer>;
+};
+
+namespace _internal {
+  inline constexpr size_t HUGE_2M = size_t{ 2 } << 20;
+
+  //! THP mode of the kernel allows advised mappings, read once from /sys/kernel/mm/transparent_hugepage/enabled
+  //! ("always [madvise] never", the mode in brackets)
+  inline bool transparentHugeEnabled() {
+    static const bool enabled = [] {
+      std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+      std::string modes;
+      std::getline(file, modes);
+      return modes.find("[always]") != std::string::npos || modes.find("[madvise]") != std::string::npos;
+    }();
+    return enabled;
+  }
+}  // namespace _internal
+
+//! Memory aligned like the planned tensor buffers (MANIFOLD_TENSOR_ALIGN) on 4 KiB pages. Arenas of 2 MiB or more
+//! are mapped and advised MADV_NOHUGEPAGE, in THP "always" mode the kernel would otherwise back them with huge pages.
+struct NormalPages {
+  [[nodiscard]] PageBuffer allocate(size_t bytes) const {
+    bytes = std::max<size_t>(bytes, 1);
+#if defined(__linux__) && defined(MADV_NOHUGEPAGE)
+    static_assert(MANIFOLD_TENSOR_ALIGN <= 4096, "Scions: mappings are only page aligned");
+    if (bytes >= _internal::HUGE_2M) {
+      void *ptr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (ptr != MAP_FAILED) {
+        ::madvise(ptr, bytes, MADV_NOHUGEPAGE);
+        return PageBuffer(static_cast<std::byte *>(ptr), bytes, PageKind::NORMAL, [](std::byte *data, size_t size) {
+          ::munmap(data, size);
+        });
+      }
+    }
+#endif
+    return PageBuffer(new (std::align_val_t{ MANIFOLD_TENSOR_ALIGN }) std::byte[bytes],
+      bytes,
+      PageKind::NORMAL,
+      [](std::byte *ptr, size_t) { ::operator delete[](ptr, std::align_val_t{ MANIFOLD_TENSOR_ALIGN }); });
+  }
+};
+
+//! Huge pages with transparent fallback, see the top of the file. Arenas under 2 MiB get normal pages.
+struct HugePages {
+  //! try MAP_HUGETLB, 1 GiB pages for arenas of at least 1 GiB then 2 MiB pages
+  bool hugetlb = true;
+  //! try transparent huge pages, skipped when THP is disabled ("never")
+  bool transparent = true;
+
+  static constexpr size_t HUGE_2M = _internal::HUGE_2M;
+  static constexpr size_t HUGE_1G = size_t{ 1 } << 30;
+
+  [[nodiscard]] PageBuffer allocate(size_t bytes) const {
+#if defined(__linux__)
+    const auto round = [](const size_t size, const size_t page) { return (size + page - 1) / page * page; };
+    const auto unmap = [](std::byte *ptr, size_t size) { ::munmap(ptr, size); };
+    constexpr int ANON = MAP_PRIVATE | MAP_ANONYMOUS;
+
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+    if (hugetlb) {
+      const auto tryHugetlb = [&](const size_t page, const int log2, const PageKind kind) -> PageBuffer {
+        const size_t size = round(bytes, page);
+        void *ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, ANON | MAP_HUGETLB | (log2 << MAP_HUGE_SHIFT), -1, 0);
+        return ptr == MAP_FAILED ? PageBuffer{} : PageBuffer(static_cast<std::byte *>(ptr), size, kind, unmap);
+      };
+      if (bytes >= HUGE_1G) {
+        if (PageBuffer buffer = tryHugetlb(HUGE_1G, 30, PageKind::HUGETLB_1G); buffer.data() != nullptr) {
+          return buffer;
+        }
+      }
+      if (bytes >= HUGE_2M) {
+        if (PageBuffer buffer = tryHugetlb(HUGE_2M, 21, PageKind::HUGETLB_2M); buffer.data() != nullptr) {
+          return buffer;
+        }
+      }
+    }
+#endif
+
+#if defined(MADV_HUGEPAGE)
+    if (transparent && bytes >= HUGE_2M && _internal::transparentHugeEnabled()) {
+      // huge pages only back 2 MiB aligned ranges, map a page more and trim both ends to the alignment
+      const size_t size = round(bytes, HUGE_2M);
+      void *raw         = ::mmap(nullptr, size + HUGE_2M, PROT_READ | PROT_WRITE, ANON, -1, 0);
+      if (raw != MAP_FAILED) {
+        auto *begin        = static_cast<std::byte *>(raw);
+        const auto addr    = reinterpret_cast<uintptr_t>(begin);
+        const size_t head  = round(addr, HUGE_2M) - addr;
+        std::byte *aligned = begin + head;
+        if (head != 0) { ::munmap(begin, head); }
+        if (HUGE_2M - head != 0) { ::munmap(aligned + size, HUGE_2M - head); }
+        if (::madvise(aligned, size, MADV_HUGEPAGE) == 0) {
+          return PageBuffer(aligned, size, PageKind::THP_ADVISED, unmap);
+        }
+        ::munmap(aligned, size);
+      }
+    }
+#endif
+#endif
+    return NormalPages{}.allocate(bytes);
+  }
+};
+}  // namespace scions::mem
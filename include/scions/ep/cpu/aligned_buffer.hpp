@@ -0,0 +1,21 @@
+#pragma once
+#include "manifold/macro.hpp"
+#include "scions/common/common.hpp"
+#include <new>
+
+namespace scions::cpu {
+namespace _internal {
+  struct AlignedDelete {
+    void operator()(std::byte *ptr) const noexcept {
+      ::operator delete[](ptr, std::align_val_t{ MANIFOLD_TENSOR_ALIGN });
+    }
+  };
+}  // namespace _internal
+
+//! Tensor arena whose size is only known at runtime, aligned like the planned buffers (MANIFOLD_TENSOR_ALIGN)
+using AlignedBuffer = std::unique_ptr<std::byte[], _internal::AlignedDelete>;
+
+[[nodiscard]] inline AlignedBuffer allocateAligned(const size_t bytes) {
+  return AlignedBuffer(new (std::align_val_t{ MANIFOLD_TENSOR_ALIGN }) std::byte[bytes]);
+}
+}  // namespace scions::cpu
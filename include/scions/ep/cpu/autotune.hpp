@@ -0,0 +1,201 @@
+#pragma once
+#include "aligned_buffer.hpp"
+#include "cpu_graph.hpp"
+#include "runtime_exec.hpp"
+#include "scions/common/common.hpp"
+#include "thread_pool.hpp"
+#include "tile_schedule.hpp"
+#include "tuning_table.hpp"
+#include <chrono>
+
+//! Autotuner : times the candidate configurations of the kernels a graph actually uses on this machine and keeps the
+//! fastest in a TuningTable, saved once and loaded by later runs.
+//!
+//!     auto table = std::filesystem::exists(path) ? scions::cpu::TuningTable::load(path) : scions::cpu::TuningTable{};
+//!     table = scions::cpu::autotune(compact, std::chrono::milliseconds(500), std::move(table));
+//!     table.save(path);
+//!     scions::cpu::RuntimeCpuGraph graph(compact, table);
+//!     scions::cpu::ThreadPool pool(graph.threads());
+//!
+//! Tuned, most expensive first :
+//!  - the chunk of every many to one element wise op (OpType, DType, input count, elements)
+//!  - TileSchedule cache budget and ThreadPool workers
+//! by running the whole graph with every candidate, so each is timed with the cache state it really has.
+//! Ops already in the table are not timed again, so a table grows graph after graph. Tuning stops at the time budget,
+//! whatever is left keeps its default. The budget is checked between measurements, a single run of a very large
+//! graph may overshoot it.
+
+#ifndef SCIONS_CPU_TUNE_SAMPLE_US
+//! time each candidate runs for, the best of its runs over that time is kept
+#define SCIONS_CPU_TUNE_SAMPLE_US 2000
+#endif
+
+namespace scions::cpu {
+namespace _internal {
+  using TuneClock = std::chrono::steady_clock;
+
+  //! Seconds a run of @param fn takes, nullopt if @param deadline passed before the sample was complete
+  template<typename Fn>
+  std::optional<double> secondsPerRun(Fn &&fn, TuneClock::time_point deadline) {
+    fn();
+    double best      = std::numeric_limits<double>::max();
+    const auto start = TuneClock::now();
+    auto now         = start;
+    do {
+      const auto before = now;
+      fn();
+      now  = TuneClock::now();
+      best = std::min(best, std::chrono::duration<double>(now - before).count());
+      if (now >= deadline) { return std::nullopt; }
+    } while (now - start < std::chrono::microseconds(SCIONS_CPU_TUNE_SAMPLE_US));
+    return best;
+  }
+
+  inline bool manyToOne(const manifold::OpType type) {
+    using manifold::OpType;
+    return type == OpType::ELM_ADD || type == OpType::ELM_SUB || type == OpType::ELM_MUL || type == OpType::ELM_DIV;
+  }
+
+  //! Writes 1 to the @param size elements of @param dtype at @param ptr, a value every kernel takes (no division by 0)
+  inline void fillOnes(void *ptr, const manifold::DType dtype, const size_t size) {
+    const auto fill = [&]<typename T>(T) { std::fill_n(static_cast<T *>(ptr), size, T{ 1 }); };
+    using manifold::DType;
+    switch (dtype) {
+    case DType::UINT8: return fill(uint8_t{});
+    case DType::UINT16: return fill(uint16_t{});
+    case DType::UINT32: return fill(uint32_t{});
+    case DType::UINT64: return fill(uint64_t{});
+    case DType::INT8: return fill(int8_t{});
+    case DType::INT16: return fill(int16_t{});
+    case DType::INT32: return fill(int32_t{});
+    case DType::INT64: return fill(int64_t{});
+    case DType::F32: return fill(float{});
+    case DType::F64: return fill(double{});
+    }
+  }
+
+  //! Index of the fastest of @param count candidates, run by @param run(index). nullopt when out of time.
+  template<typename Run>
+  std::optional<size_t> fastest(size_t count, Run &&run, TuneClock::time_point deadline) {
+    size_t best_idx = 0;
+    double best     = std::numeric_limits<double>::max();
+    for (size_t i{}; i < count; i++) {
+      const auto time = secondsPerRun([&] { run(i); }, deadline);
+      if (!time) { return std::nullopt; }
+      if (*time < best) {
+        best     = *time;
+        best_idx = i;
+      }
+    }
+    return best_idx;
+  }
+
+  //! Fastest of TUNE_CHUNKS for the op @param key, on scratch buffers. nullopt when out of time.
+  inline std::optional<uint32_t> tuneChunk(const TuneKey &key, TuneClock::time_point deadline) {
+    const size_t bytes = key.size * manifold::DTYPE_SIZES[static_cast<uint8_t>(key.data_type)];
+    std::vector<AlignedBuffer> buffers;
+    Instruction ins{};
+    ins.size        = key.size;
+    ins.num_inputs  = key.inputs;
+    ins.num_outputs = 1;
+    for (uint32_t j{}; j <= key.inputs; j++) {
+      buffers.push_back(allocateAligned(std::max<size_t>(bytes, 1)));
+      fillOnes(buffers.back().get(), key.data_type, key.size);
+      (j == key.inputs ? ins.out[0] : ins.in[j]) = buffers.back().get();
+    }
+
+    const auto best = fastest(
+      TUNE_CHUNKS.size(),
+      [&](const size_t i) {
+        ins.kernel = resolveKernel(key.type, key.data_type, key.inputs, TUNE_CHUNKS[i]);
+        ins.kernel(ins);
+      },
+      deadline);
+    return best ? std::optional(TUNE_CHUNKS[*best]) : std::nullopt;
+  }
+}  // namespace _internal
+
+//! Tunes every configuration of @param graph missing from @param table within @param budget and returns the table
+[[nodiscard]] inline TuningTable autotune(const manifold::CompactRuntimeGraph &graph,
+  std::chrono::nanoseconds budget,
+  TuningTable table = {}) {
+  const auto deadline = _internal::TuneClock::now() + budget;
+
+  // kernels, by the work they stand for in the graph
+  std::map<TuneKey, size_t> work;
+  bool integer_div = false;
+  for (const auto &exp : graph.expressions) {
+    integer_div |= exp.type == manifold::OpType::ELM_DIV && exp.data_type != manifold::DType::F32
+                   && exp.data_type != manifold::DType::F64;
+    if (!_internal::manyToOne(exp.type) || exp.inp_size < 2) { continue; }
+    const TuneKey key{ exp.type, exp.data_type, exp.inp_size, graph.data[exp.output_indices[0]].size };
+    if (!table.chunks.contains(key)) { work[key] += key.size * (key.inputs + 1); }
+  }
+  std::vector<std::pair<TuneKey, size_t>> keys(work.begin(), work.end());
+  std::ranges::sort(keys, std::ranges::greater{}, &std::pair<TuneKey, size_t>::second);
+
+  // Integer divisions could divide by an intermediate 0 when the whole graph runs on made up inputs, their kernels
+  // are timed on scratch buffers and the graph keeps the default tile budget and worker count
+  if (integer_div) {
+    for (const auto &[key, cost] : keys) {
+      const auto chunk = _internal::tuneChunk(key, deadline);
+      if (!chunk) { return table; }
+      table.chunks[key] = *chunk;
+    }
+    return table;
+  }
+  if (graph.expressions.empty()) { return table; }
+
+  // otherwise every candidate runs the whole graph, its inputs set to ones, so it is timed with the cache state and
+  // the neighbours it really has
+  RuntimeCpuGraph exec(graph, table);
+  for (const uint32_t idx : exec.inputs()) {
+    _internal::fillOnes(exec.tensorAddresses()[idx], graph.data[idx].data_type, graph.data[idx].size);
+  }
+  for (const auto &[key, cost] : keys) {
+    std::vector<CpuGraph> plans;
+    for (const uint32_t chunk : TUNE_CHUNKS) {
+      table.chunks[key] = chunk;
+      plans.emplace_back(graph, exec.tensorAddresses(), &table);
+    }
+    const auto best = _internal::fastest(plans.size(), [&](const size_t i) { plans[i].run(); }, deadline);
+    if (!best) {
+      table.chunks.erase(key);
+      return table;
+    }
+    table.chunks[key] = TUNE_CHUNKS[*best];
+  }
+
+  const CpuGraph tuned(graph, exec.tensorAddresses(), &table);
+  constexpr std::array<size_t, 6> TILE_BYTES{ 64 << 10, 128 << 10, 256 << 10, 512 << 10, 1 << 20, 2 << 20 };
+  std::vector<TileSchedule> schedules;
+  for (const size_t bytes : TILE_BYTES) { schedules.emplace_back(graph, exec.tensorAddresses(), bytes); }
+  const bool tiled = std::ranges::any_of(schedules, [](const TileSchedule &tiles) {
+    return std::ranges::any_of(tiles.segments(), [](const TileSegment &seg) { return seg.tile != 0; });
+  });
+  if (tiled) {
+    const auto best = _internal::fastest(
+      schedules.size(), [&](const size_t i) { schedules[i].run(tuned); }, deadline);
+    if (!best) { return table; }
+    table.tile_bytes = TILE_BYTES[*best];
+  }
+
+  if (exec.taskGraph().size() > 1) {
+    std::vector<size_t> threads;
+    const size_t hardware = std::max(1U, std::thread::hardware_concurrency());
+    for (size_t count = 1; count < hardware; count *= 2) { threads.push_back(count); }
+    threads.push_back(hardware);
+    // a single pool alive at a time, made by the warm up run of its candidate
+    std::unique_ptr<ThreadPool> pool;
+    const auto best = _internal::fastest(
+      threads.size(),
+      [&](const size_t i) {
+        if (!pool || pool->size() != threads[i]) { pool = std::make_unique<ThreadPool>(threads[i]); }
+        pool->run(tuned, exec.taskGraph());
+      },
+      deadline);
+    if (best) { table.threads = threads[*best]; }
+  }
+  return table;
+}
+}  // namespace scions::cpu
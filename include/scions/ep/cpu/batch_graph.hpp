@@ -0,0 +1,175 @@
+#pragma once
+#include "aligned_buffer.hpp"
+#include "graph_io.hpp"
+#include "manifold/mem_plan.hpp"
+#include "manifold/op_type.hpp"
+#include "manifold/ops/element_wise_ops.hpp"
+#include "ops/element_wise_cpu.hpp"
+#include "scions/common/common.hpp"
+
+//! Batch lifting of a CompactStaticGraph : every tensor gets a leading batch dimension and is stored structure of
+//! arrays, ie. the batch of tensor `t` is one contiguous [batch][t.size] block. An op then runs once over
+//! `batch * t.size` elements instead of once per sample, so scalar graphs become SIMD across samples.
+//!
+//! Note: The memory plan of the graph is reused as is, all extents grow by the same factor so reuse and in place
+//!       decisions stay valid.
+//!
+//! Samples are processed in chunks small enough for the whole graph working set to stay in L2, otherwise every op
+//! would stream its batch through DRAM before the next one starts.
+
+#ifndef SCIONS_CPU_BATCH_CHUNK_BYTES
+#define SCIONS_CPU_BATCH_CHUNK_BYTES (256 * 1024)
+#endif
+
+namespace scions::cpu {
+namespace _internal {
+  //! Elements of every dtype pool needed by the planned offsets of @tparam graph
+  template<auto graph>
+  consteval std::array<size_t, manifold::NUM_DTYPE> poolSizes() {
+    std::array<size_t, manifold::NUM_DTYPE> sizes{};
+    for (size_t i{}; i < graph.data.size(); i++) {
+      const auto &ten = graph.data[i];
+      auto &pool      = sizes.at(static_cast<uint8_t>(ten.data_type));
+      pool            = std::max(pool, graph.offsets[i] + manifold::_internal::alignedExtent(ten));
+    }
+    return sizes;
+  }
+
+  template<auto graph>
+  consteval std::array<size_t, manifold::NUM_DTYPE> poolByteOffsets() {
+    constexpr auto SIZES = poolSizes<graph>();
+    std::array<size_t, manifold::NUM_DTYPE> offsets{};
+    for (uint8_t i = 1; i < manifold::NUM_DTYPE; i++) {
+      offsets[i] = offsets[i - 1] + SIZES[i - 1] * manifold::DTYPE_SIZES[i - 1];
+    }
+    return offsets;
+  }
+
+  //! @tparam N : elements of the output of @tparam exp for a single sample
+  template<typename T, auto exp, size_t N>
+  inline void batchOp(const auto &ptrs, const size_t batch) {
+    using manifold::OpType;
+    constexpr auto OP = exp.type;
+    static_assert(manifold::isElementWise(OP) || OP == OpType::ELM_FILL,
+      "Scions CPU: batch lifting only supports element wise ops for now");
+
+    std::array<T *, exp.inp_size> in{};
+    for (size_t j{}; j < exp.inp_size; j++) { in[j] = static_cast<T *>(ptrs[exp.input_indices[j]]); }
+    T *out = static_cast<T *>(ptrs[exp.output_indices[0]]);
+
+    // batch of the output, every element wise input has the same extent
+    const size_t n = batch * N;
+
+    if constexpr (OP == OpType::ELM_ADD) {
+      element_wise_add(out, in, n);
+    } else if constexpr (OP == OpType::ELM_SUB) {
+      element_wise_sub(out, in, n);
+    } else if constexpr (OP == OpType::ELM_MUL) {
+      element_wise_mul(out, in, n);
+    } else if constexpr (OP == OpType::ELM_DIV) {
+      element_wise_div(out, in, n);
+    } else if constexpr (OP == OpType::EXPONENTIAL) {
+      element_wise_exp(out, in[0], n);
+    } else if constexpr (OP == OpType::COPY) {
+      copy(out, in[0], n);
+    } else if constexpr (OP == OpType::SCL_ELM_ADD) {
+      scalar_add(out, manifold::op::oneValue<T>(exp.params), n);
+    } else if constexpr (OP == OpType::SCL_ELM_SUB) {
+      scalar_sub(out, manifold::op::oneValue<T>(exp.params), n);
+    } else if constexpr (OP == OpType::SCL_ELM_MUL) {
+      scalar_mul(out, manifold::op::oneValue<T>(exp.params), n);
+    } else if constexpr (OP == OpType::SCL_ELM_DIV) {
+      scalar_div(out, manifold::op::oneValue<T>(exp.params), n);
+    } else if constexpr (OP == OpType::ELM_FILL) {
+      for (size_t j{}; j < exp.out_size; j++) {
+        fill(static_cast<T *>(ptrs[exp.output_indices[j]]), manifold::op::oneValue<T>(exp.params), n);
+      }
+    } else {
+      static_assert(sizeof(T) == 0, "Scions CPU: op has no batched kernel");
+    }
+  }
+
+  //! @param ptrs : pointer to the first sample (of the chunk) of every tensor
+  template<auto graph, size_t... I>
+  inline void batchOps(const auto &ptrs, const size_t batch, std::index_sequence<I...>) {
+    (batchOp<typename manifold::DTypeToPrimitive<graph.data[graph.expressions[I].output_indices[0]].data_type>::type,
+       graph.expressions[I],
+       graph.data[graph.expressions[I].output_indices[0]].size>(ptrs, batch),
+      ...);
+  }
+}  // namespace _internal
+
+//! Runs the CompactStaticGraph @tparam graph over many independent samples at once.
+//!
+//!     scions::cpu::BatchExecutor<compact> exec(1 << 20);
+//!     auto outputs = exec.run<float>({ inputs_a, inputs_b });
+//!
+//! Inputs and outputs are ordered as @ref graph_inputs / @ref graph_outputs, each one holding `batch * tensor.size`
+//! values (sample major).
+template<auto graph>
+class BatchExecutor {
+public:
+  static constexpr auto POOL_SIZES     = _internal::poolSizes<graph>();
+  static constexpr auto POOL_OFFSETS   = _internal::poolByteOffsets<graph>();
+  static constexpr size_t SAMPLE_BYTES = POOL_OFFSETS.back() + POOL_SIZES.back() * manifold::DTYPE_SIZES.back();
+  static constexpr size_t CHUNK        = std::max<size_t>(SCIONS_CPU_BATCH_CHUNK_BYTES / SAMPLE_BYTES, 1);
+
+  [[nodiscard]] explicit BatchExecutor(const size_t batch)
+    : batch_size(batch), arena(allocateAligned(SAMPLE_BYTES * batch)) {
+    for (size_t i{}; i < graph.data.size(); i++) {
+      const auto &ten   = graph.data[i];
+      const auto d_type = static_cast<uint8_t>(ten.data_type);
+      ptrs[i] = arena.get() + POOL_OFFSETS[d_type] * batch + graph.offsets[i] * batch * manifold::DTYPE_SIZES[d_type];
+    }
+  }
+
+  [[nodiscard]] size_t batchSize() const noexcept { return batch_size; }
+
+  //! Batched view ([batch][tensor.size]) of the tensor at index @param idx
+  template<typename T>
+  [[nodiscard]] std::span<T> tensorSpan(size_t idx) {
+    return std::span<T>(static_cast<T *>(ptrs.at(idx)), graph.data.at(idx).size * batch_size);
+  }
+
+  //! Executes every op once per chunk of samples, inputs must already be in place (see tensorSpan)
+  void run() {
+    std::array<void *, graph.data.size()> chunk_ptrs{};
+    for (size_t start{}; start < batch_size; start += CHUNK) {
+      for (size_t i{}; i < graph.data.size(); i++) {
+        const auto &ten = graph.data[i];
+        chunk_ptrs[i] = static_cast<std::byte *>(ptrs[i])
+                        + start * ten.size * manifold::DTYPE_SIZES[static_cast<uint8_t>(ten.data_type)];
+      }
+      _internal::batchOps<graph>(
+        chunk_ptrs, std::min(CHUNK, batch_size - start), std::make_index_sequence<graph.expressions.size()>{});
+    }
+  }
+
+  //! Copies in a batch of inputs, runs the graph and returns views of the batched outputs. The views stay valid
+  //! until the next run.
+  template<typename T>
+  [[nodiscard]] std::array<std::span<const T>, _internal::graphIOCount<graph, false>()> run(
+    const std::array<std::span<const T>, _internal::graphIOCount<graph, true>()> &inputs) {
+    for (size_t i{}; i < inputs.size(); i++) {
+      auto dst = tensorSpan<T>(graph_inputs<graph>[i]);
+      if (inputs[i].size() != dst.size()) {
+        throw std::invalid_argument(std::format("Scions CPU: batched input {} should have {} values, got {}",
+          i,
+          dst.size(),
+          inputs[i].size()));
+      }
+      std::ranges::copy(inputs[i], dst.begin());
+    }
+    run();
+
+    std::array<std::span<const T>, _internal::graphIOCount<graph, false>()> outputs{};
+    for (size_t i{}; i < outputs.size(); i++) { outputs[i] = tensorSpan<T>(graph_outputs<graph>[i]); }
+    return outputs;
+  }
+
+private:
+  size_t batch_size;
+  AlignedBuffer arena;
+  std::array<void *, graph.data.size()> ptrs{};
+};
+}  // namespace scions::cpu
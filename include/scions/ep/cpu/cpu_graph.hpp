@@ -1,17 +1,219 @@
-//
 #pragma once
-
+#include "manifold/constants.hpp"
+#include "manifold/op_type.hpp"
+#include "manifold/ops/element_wise_ops.hpp"
+#include "manifold/utility.hpp"
+#include "op_recorder.hpp"
+#include "ops/element_wise_cpu.hpp"
 #include "scions/common/common.hpp"
+#include "tuning_table.hpp"
+
+//! Flat execution plan of a compact graph. Lowering resolves, once, the kernel of every expression (op, dtype and
+//! input count), the addresses of its tensors in the arena and its scalar parameter, running the graph is then a
+//! loop of direct calls over a contiguous array.
+//!
+//!     scions::cpu::CpuGraph plan(compact, ptrs);
+//!     plan.run();
+
+namespace scions::cpu {
+//! A single lowered op, the fields every op reads come first
+struct Instruction {
+  using Kernel = void (*)(const Instruction &);
+
+  Kernel kernel;
+  size_t size;
+  //! scalar parameter (SCL_ELM_*, ELM_FILL) in the op dtype
+  std::array<std::byte, sizeof(uint64_t)> param;
+  uint32_t num_inputs;
+  uint32_t num_outputs;
+  std::array<void *, MANIFOLD_MAX_EXP_OUTPUT> out;
+  std::array<void *, MANIFOLD_MAX_EXP_INPUT> in;
+};
+
+namespace _internal {
+  template<typename T, manifold::OpType OP, size_t K>
+  void kernel(const Instruction &ins) {
+    using manifold::OpType;
+    T *out = static_cast<T *>(ins.out[0]);
+
+    if constexpr (OP == OpType::ELM_ADD || OP == OpType::ELM_SUB || OP == OpType::ELM_MUL || OP == OpType::ELM_DIV) {
+      std::array<T *, K> arr{};
+      for (size_t j{}; j < K; j++) { arr[j] = static_cast<T *>(ins.in[j]); }
+      if constexpr (OP == OpType::ELM_ADD) {
+        element_wise_add(out, arr, ins.size);
+      } else if constexpr (OP == OpType::ELM_SUB) {
+        element_wise_sub(out, arr, ins.size);
+      } else if constexpr (OP == OpType::ELM_MUL) {
+        element_wise_mul(out, arr, ins.size);
+      } else {
+        element_wise_div(out, arr, ins.size);
+      }
+    } else if constexpr (OP == OpType::EXPONENTIAL) {
+      element_wise_exp(out, static_cast<const T *>(ins.in[0]), ins.size);
+    } else if constexpr (OP == OpType::COPY) {
+      copy(out, static_cast<const T *>(ins.in[0]), ins.size);
+    } else if constexpr (OP == OpType::SCL_ELM_ADD) {
+      scalar_add(out, manifold::op::oneValue<T>(ins.param), ins.size);
+    } else if constexpr (OP == OpType::SCL_ELM_SUB) {
+      scalar_sub(out, manifold::op::oneValue<T>(ins.param), ins.size);
+    } else if constexpr (OP == OpType::SCL_ELM_MUL) {
+      scalar_mul(out, manifold::op::oneValue<T>(ins.param), ins.size);
+    } else if constexpr (OP == OpType::SCL_ELM_DIV) {
+      scalar_div(out, manifold::op::oneValue<T>(ins.param), ins.size);
+    } else if constexpr (OP == OpType::ELM_FILL) {
+      const T value = manifold::op::oneValue<T>(ins.param);
+      for (size_t j{}; j < ins.num_outputs; j++) { fill(static_cast<T *>(ins.out[j]), value, ins.size); }
+    }
+  }
+
+  //! Many to one op folding its inputs CHUNK elements at a time : the partial results of a chunk stay in L1 while the
+  //! inputs are streamed one after the other, instead of every input being read for every element. The chunk is
+  //! accumulated aside so the output may alias any input.
+  template<typename T, manifold::OpType OP, size_t K, size_t CHUNK>
+  void chunkedKernel(const Instruction &ins) {
+    using manifold::OpType;
+    T *out = static_cast<T *>(ins.out[0]);
+    std::array<T, CHUNK> acc;
+    for (size_t begin{}; begin < ins.size; begin += CHUNK) {
+      const size_t count = std::min(CHUNK, ins.size - begin);
+      std::copy_n(static_cast<const T *>(ins.in[0]) + begin, count, acc.begin());
+      for (size_t j = 1; j < K; j++) {
+        const T *in = static_cast<const T *>(ins.in[j]) + begin;
+        for (size_t i{}; i < count; i++) {
+          if constexpr (OP == OpType::ELM_ADD) {
+            acc[i] += in[i];
+          } else if constexpr (OP == OpType::ELM_SUB) {
+            acc[i] -= in[i];
+          } else if constexpr (OP == OpType::ELM_MUL) {
+            acc[i] *= in[i];
+          } else {
+            acc[i] /= in[i];
+          }
+        }
+      }
+      std::copy_n(acc.begin(), count, out + begin);
+    }
+  }
+
+  //! Many to one kernels take their inputs as a fixed size array, pick the instantiation matching @param count,
+  //! folded by @param chunk elements when it is one of TUNE_CHUNKS
+  template<typename T, manifold::OpType OP, size_t K = 1>
+  Instruction::Kernel manyToOneKernel(const uint32_t count, const uint32_t chunk = 0) {
+    if constexpr (K <= MANIFOLD_MAX_EXP_INPUT) {
+      if (count != K) { return manyToOneKernel<T, OP, K + 1>(count, chunk); }
+      if constexpr (K >= 2) {
+        static_assert(TUNE_CHUNKS == std::array<uint32_t, 4>{ 0, 64, 256, 1024 }, "Scions CPU: chunk list changed");
+        if (chunk == 64) { return &chunkedKernel<T, OP, K, 64>; }
+        if (chunk == 256) { return &chunkedKernel<T, OP, K, 256>; }
+        if (chunk == 1024) { return &chunkedKernel<T, OP, K, 1024>; }
+      }
+      return &kernel<T, OP, K>;
+    } else {
+      return nullptr;
+    }
+  }
+
+  template<typename T>
+  Instruction::Kernel resolveKernel(const manifold::OpType type, const uint32_t count, const uint32_t chunk) {
+    using manifold::OpType;
+    switch (type) {
+    case OpType::ELM_ADD: return manyToOneKernel<T, OpType::ELM_ADD>(count, chunk);
+    case OpType::ELM_SUB: return manyToOneKernel<T, OpType::ELM_SUB>(count, chunk);
+    case OpType::ELM_MUL: return manyToOneKernel<T, OpType::ELM_MUL>(count, chunk);
+    case OpType::ELM_DIV: return manyToOneKernel<T, OpType::ELM_DIV>(count, chunk);
+    case OpType::EXPONENTIAL: return &kernel<T, OpType::EXPONENTIAL, 1>;
+    case OpType::COPY: return &kernel<T, OpType::COPY, 1>;
+    case OpType::SCL_ELM_ADD: return &kernel<T, OpType::SCL_ELM_ADD, 0>;
+    case OpType::SCL_ELM_SUB: return &kernel<T, OpType::SCL_ELM_SUB, 0>;
+    case OpType::SCL_ELM_MUL: return &kernel<T, OpType::SCL_ELM_MUL, 0>;
+    case OpType::SCL_ELM_DIV: return &kernel<T, OpType::SCL_ELM_DIV, 0>;
+    case OpType::ELM_FILL: return &kernel<T, OpType::ELM_FILL, 0>;
+    default: return nullptr;
+    }
+  }
+
+  //! Kernel of an op of @param type on @param dtype with @param count inputs, nullptr when there is none.
+  //! @param chunk : see TuningTable::chunks, ignored by the ops that aren't many to one
+  inline Instruction::Kernel resolveKernel(const manifold::OpType type,
+    const manifold::DType dtype,
+    const uint32_t count,
+    const uint32_t chunk = 0) {
+    using manifold::DType;
+    switch (dtype) {
+    case DType::UINT8: return resolveKernel<uint8_t>(type, count, chunk);
+    case DType::UINT16: return resolveKernel<uint16_t>(type, count, chunk);
+    case DType::UINT32: return resolveKernel<uint32_t>(type, count, chunk);
+    case DType::UINT64: return resolveKernel<uint64_t>(type, count, chunk);
+    case DType::INT8: return resolveKernel<int8_t>(type, count, chunk);
+    case DType::INT16: return resolveKernel<int16_t>(type, count, chunk);
+    case DType::INT32: return resolveKernel<int32_t>(type, count, chunk);
+    case DType::INT64: return resolveKernel<int64_t>(type, count, chunk);
+    case DType::F32: return resolveKernel<float>(type, count, chunk);
+    case DType::F64: return resolveKernel<double>(type, count, chunk);
+    }
+    return nullptr;
+  }
+}  // namespace _internal
 
-namespace scions {
-template<size_t N>
 class CpuGraph {
 public:
-  [[nodiscard]] CpuGraph(std::array<std::function<void()>, N> _o) noexcept : ops(_o) {}
+  //! Lowers every expression of @param graph (manifold::CompactStaticGraph or CompactRuntimeGraph), @param ptrs
+  //! holds the address of every tensor of the graph, indexed like graph.data. Throws if an op has no CPU kernel or
+  //! an operand without the size and dtype of the op output (the kernels would run past its end).
+  //! @param tuning : kernel configuration of this machine (see autotune), default kernels when nullptr
+  template<typename Graph>
+  [[nodiscard]] CpuGraph(const Graph &graph, std::span<void *const> ptrs, const TuningTable *tuning = nullptr) {
+    if (ptrs.size() != graph.data.size()) {
+      throw std::invalid_argument(
+        std::format("Scions CPU: {} tensor addresses for a graph of {} tensors", ptrs.size(), graph.data.size()));
+    }
+
+    instructions.reserve(graph.expressions.size());
+    for (const auto &exp : graph.expressions) {
+      Instruction ins{};
+      const size_t size = graph.data[exp.output_indices[0]].size;
+      const uint32_t chunk =
+        tuning == nullptr ? 0 : tuning->chunk(TuneKey{ exp.type, exp.data_type, exp.inp_size, size });
+      ins.kernel = _internal::resolveKernel(exp.type, exp.data_type, exp.inp_size, chunk);
+      if (ins.kernel == nullptr) {
+        throw std::runtime_error(std::format("Scions CPU: no kernel for {} on {} with {} inputs",
+          manifold::optypeToString(exp.type),
+          manifold::dtypeToString(exp.data_type),
+          exp.inp_size));
+      }
+      if (!manifold::_internal::operandsMatch(exp, std::span<const manifold::TensorReflection>(graph.data))) {
+        throw std::invalid_argument(std::format(
+          "Scions CPU: {} {} has an operand of another size or dtype than its output",
+          manifold::optypeToString(exp.type),
+          exp.id));
+      }
+      ins.size        = size;
+      ins.num_inputs  = exp.inp_size;
+      ins.num_outputs = exp.out_size;
+      std::copy_n(exp.params.begin(), ins.param.size(), ins.param.begin());
+      for (size_t j{}; j < exp.out_size; j++) { ins.out[j] = ptrs[exp.output_indices[j]]; }
+      for (size_t j{}; j < exp.inp_size; j++) { ins.in[j] = ptrs[exp.input_indices[j]]; }
+      instructions.push_back(ins);
+    }
+  }
+
+  void run() const {
+    for (const Instruction &ins : instructions) { ins.kernel(ins); }
+  }
+
+  //! run() reporting every op to @param recorder (OpProfiler, TraceRecorder)
+  void run(OpRecorder auto &recorder) const {
+    for (size_t i{}; i < instructions.size(); i++) {
+      recorder.begin();
+      instructions[i].kernel(instructions[i]);
+      recorder.end(i);
+    }
+    recorder.endRun();
+  }
+
+  [[nodiscard]] std::span<const Instruction> stream() const noexcept { return instructions; }
 
 private:
-  std::array<std::function<void()>, N> ops;
+  std::vector<Instruction> instructions;
 };
-
-#undef __COMPACT_TEMP_PARAMS
-}  // namespace scions
\ No newline at end of file
+}  // namespace scions::cpu
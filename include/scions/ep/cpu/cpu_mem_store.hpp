@@ -4,65 +4,89 @@
 #pragma once
 #include "manifold/static_graph.hpp"
 #include "manifold/utility.hpp"
+#include "page_provider.hpp"
 #include "raw_data.hpp"
 #include "scions/common/common.hpp"
+#include "weight_file.hpp"
 
 
 namespace scions::cpu {
 
 #define __COMPACT_TEMP_PARAMS G.graph_data_size, G.graph_op_size, G.max_in, G.max_out
-template<manifold::GraphMetadata G>
+//! @tparam Budget : bytes the tensors may take at most, a graph whose plan needs more doesn't compile
+//! @tparam Pages : where the arena comes from, huge pages when the system has some (see page_provider.hpp)
+template<manifold::GraphMetadata G, size_t Budget = SIZE_MAX, PageProvider Pages = HugePages>
 class CpuMemStore {
+  static_assert(G.fitsIn(Budget), "Scions CPU: planned peak memory of the graph is over the CpuMemStore budget");
+
 public:
+  //! Bytes of the arena, every tensor of the graph lives in it
+  static constexpr size_t PEAK_BYTES = G.peakBytes();
+
   [[nodiscard]] explicit CpuMemStore(const manifold::CompactStaticGraph<__COMPACT_TEMP_PARAMS> &graph) noexcept
     : _graph(graph) {}
 
-  void initializeMemory() {
-    if constexpr (G.f32_size) { f32_container = std::make_unique<std::array<float, G.f32_size>>(); }
-    if constexpr (G.u8_size) { u8_container = std::make_unique<std::array<uint8_t, G.u8_size>>(); }
-    static_assert(G.f32_size != 0);
-    //! Note :
-    //! probably should use an array of pointers and just increment them
-    //! but for two it should be fine
-    //! std::array<size_t, manifold::NUM_DTYPE> offsets;
-    size_t f32_offset{}, u8_offset{};
+  //! Allocates a single arena holding every dtype pool and binds each tensor to its planned offset.
+  //! Tensors that the planner made share a buffer (reuse or in place ops) get the same address.
+  //! The arena isn't written, its pages are first touched (and placed on the NUMA node of) the thread writing them.
+  void initializeMemory(const Pages &pages = {}) {
+    arena = pages.allocate(std::max<size_t>(G.total, 1));
 
     for (size_t i{}; i < G.graph_data_size; ++i) {
       manifold::TensorReflection &tensor = _graph.data[i];
-      void *data_ptr                     = nullptr;
-
-      switch (tensor.data_type) {
-      case manifold::DType::UINT8:
-        data_ptr = &u8_container->at(u8_offset);
-        u8_offset += tensor.size + 1;
-        break;
-      case manifold::DType::UINT16: break;
-      case manifold::DType::UINT32: break;
-      case manifold::DType::UINT64: break;
-      case manifold::DType::INT8: break;
-      case manifold::DType::INT16: break;
-      case manifold::DType::INT32: break;
-      case manifold::DType::INT64: break;
-      case manifold::DType::F32:
-        data_ptr = &f32_container->at(f32_offset);
-        f32_offset += tensor.size + 1;
-        break;
-      case manifold::DType::F64: break;
-      }
-      if (data_ptr == nullptr) {
+      const auto d_size                  = manifold::DTYPE_SIZES.at(static_cast<uint8_t>(tensor.data_type));
+      std::byte *pool                    = arena.data() + G.poolByteOffset(tensor.data_type);
+      void *data_ptr                     = pool + _graph.offsets[i] * d_size;
+
+      if (_graph.offsets[i] + tensor.size > G.poolSize(tensor.data_type)) {
         // Todo : Fix tensor print problem
         std::print("Tensor :\n{}", tensor);
-        throw std::format_error("Something went wrong initializing the tensor, maybe no implementation for the type");
+        throw std::format_error("Something went wrong initializing the tensor, planned buffer is out of its pool");
       }
 
       tensor_refs[i] = RawData{ data_ptr, &tensor };
     }
   }
 
-  [[nodiscard]] consteval static CpuMemStore fromStaticGraph(const manifold::SymbolContainer<> &graph) noexcept {
-    return CpuMemStore(manifold::compact<G>(graph));
+  //! Points the graph inputs held by @param weights (matched by tensor id) at the mapping instead of the arena, call
+  //! after initializeMemory(). Bound tensors are read only and @param weights has to outlive the store.
+  //! @return the number of tensors bound
+  size_t bindWeights(const MappedWeights &weights) {
+    std::array<bool, G.graph_data_size> written{};
+    for (const auto &exp : _graph.expressions) {
+      for (size_t j{}; j < exp.out_size; j++) { written[exp.output_indices[j]] = true; }
+    }
+
+    size_t bound{};
+    for (size_t i{}; i < G.graph_data_size; ++i) {
+      const std::byte *mapped = weightData(weights, _graph.data[i]);
+      if (mapped == nullptr) { continue; }
+      if (written[i]) {
+        throw std::invalid_argument(std::format(
+          "Scions CPU: tensor {} is written by the graph, it can't be read from a weight file", _graph.data[i].id));
+      }
+      tensor_refs[i].data_ptr = const_cast<std::byte *>(mapped);
+      bound++;
+    }
+    return bound;
+  }
+
+  template<size_t TSize, size_t ESize, size_t OSize, size_t PSize>
+  [[nodiscard]] consteval static CpuMemStore fromStaticDAG(
+    const manifold::StaticDAG<TSize, ESize, OSize, PSize> &dag) noexcept {
+    return CpuMemStore(manifold::compact<G>(dag));
   }
 
+  //! Typed view of the tensor at index @param idx, used for filling inputs and reading outputs
+  template<typename T>
+  [[nodiscard]] std::span<T> tensorSpan(size_t idx) {
+    const RawData<> &ref = tensor_refs.at(idx);
+    return std::span<T>(static_cast<T *>(ref.data_ptr), ref.meta->size);
+  }
+
+  //! Pages backing the arena, NORMAL before initializeMemory()
+  [[nodiscard]] PageKind pageKind() const noexcept { return arena.kind(); }
+
   CpuMemStore(const CpuMemStore &other)       = delete;
   CpuMemStore(CpuMemStore &&other)            = delete;
   CpuMemStore &operator=(CpuMemStore &&other) = delete;
@@ -70,9 +94,8 @@ public:
   std::array<RawData<>, G.graph_data_size> tensor_refs;
 
 private:
-  std::unique_ptr<std::array<float, G.f32_size>> f32_container;
-  std::unique_ptr<std::array<uint8_t, G.u8_size>> u8_container;
+  PageBuffer arena;
 
   manifold::CompactStaticGraph<__COMPACT_TEMP_PARAMS> _graph;
 };
-}  // namespace scions
\ No newline at end of file
+}  // namespace scions::cpu
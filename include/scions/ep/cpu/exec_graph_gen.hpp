@@ -6,7 +6,11 @@
 #include "cpu_graph.hpp"
 #include "manifold/constants.hpp"
 #include "manifold/op_type.hpp"
+#include "manifold/ops/element_wise_ops.hpp"
 #include "ops/element_wise_cpu.hpp"
+#include "op_recorder.hpp"
+#include "raw_data.hpp"
+#include "scalar_graph.hpp"
 #include "scions/common/common.hpp"
 
 namespace scions::cpu {
@@ -31,24 +35,88 @@ namespace _internal {
     constexpr auto IN_IND               = exp.input_indices;
     constexpr auto OUT_IND              = exp.output_indices;
     constexpr TensorReflection OUT_DATA = D_ARR[OUT_IND[0]];
-    auto ten_ptrs                       = memStore.tensor_refs;
+    auto &ten_ptrs                      = memStore.tensor_refs;
     auto in_arr                         = generatePointerArr<T, exp.inp_size, IN_IND>(ten_ptrs);
     auto out_arr                        = generatePointerArr<T, exp.out_size, OUT_IND>(ten_ptrs);
 
-//    if constexpr (OP == ARRAY_ELM_ADD) { element_wise_add<T, OUT_DATA.size, exp.inp_size>(out_arr[0], in_arr); }
-//    if constexpr (OP == ARRAY_ELM_MUL) { element_wise_mul<T, OUT_DATA.size, exp.inp_size>(out_arr[0], in_arr); }
-    //    invalidCpuOp();
+    if constexpr (OP == OpType::ELM_ADD) {
+      element_wise_add<T, OUT_DATA.size, exp.inp_size>(out_arr[0], in_arr);
+    } else if constexpr (OP == OpType::ELM_SUB) {
+      element_wise_sub<T, OUT_DATA.size, exp.inp_size>(out_arr[0], in_arr);
+    } else if constexpr (OP == OpType::ELM_MUL) {
+      element_wise_mul<T, OUT_DATA.size, exp.inp_size>(out_arr[0], in_arr);
+    } else if constexpr (OP == OpType::ELM_DIV) {
+      element_wise_div<T, OUT_DATA.size, exp.inp_size>(out_arr[0], in_arr);
+    } else if constexpr (OP == OpType::EXPONENTIAL) {
+      element_wise_exp<T, OUT_DATA.size>(out_arr[0], in_arr[0]);
+    } else if constexpr (OP == OpType::COPY) {
+      copy<T, OUT_DATA.size>(out_arr[0], in_arr[0]);
+    } else if constexpr (OP == OpType::SCL_ELM_ADD) {
+      scalar_add<T, OUT_DATA.size>(out_arr[0], manifold::op::oneValue<T>(exp.params));
+    } else if constexpr (OP == OpType::SCL_ELM_SUB) {
+      scalar_sub<T, OUT_DATA.size>(out_arr[0], manifold::op::oneValue<T>(exp.params));
+    } else if constexpr (OP == OpType::SCL_ELM_MUL) {
+      scalar_mul<T, OUT_DATA.size>(out_arr[0], manifold::op::oneValue<T>(exp.params));
+    } else if constexpr (OP == OpType::SCL_ELM_DIV) {
+      scalar_div<T, OUT_DATA.size>(out_arr[0], manifold::op::oneValue<T>(exp.params));
+    } else if constexpr (OP == OpType::ELM_FILL) {
+      const T value = manifold::op::oneValue<T>(exp.params);
+      for (size_t i = 0; i < exp.out_size; ++i) { fill<T, OUT_DATA.size>(out_arr[i], value); }
+    } else {
+      invalidCpuOp();
+    }
+  }
+
+  template<auto graph, size_t... I>
+  inline void recordedOps(auto &memStore, OpRecorder auto &recorder, std::index_sequence<I...>) {
+    ((recorder.begin(),
+       SwitchIMPL<
+         typename manifold::DTypeToPrimitive<graph.data[graph.expressions[I].output_indices[0]].data_type>::type,
+         graph.expressions[I],
+         graph.data>(memStore),
+       recorder.end(I)),
+      ...);
   }
 }  // namespace _internal
 
+//! Executes the CompactStaticGraph @tparam graph op by op over the buffers of @param memStore (CpuMemStore)
+//!
+//! Note: Scalar graphs are lowered to straight line code (see exec_scalar_graph), only the graph inputs are
+//!       loaded from and the outputs written back to the store.
 template<auto graph, size_t N = 0>
 inline auto exec_cpu_graph(auto &memStore) {
   static constexpr auto &D_ARR  = graph.data;
   static constexpr auto &EX_ARR = graph.expressions;
 
-  using inp_type = typename manifold::DTypeToPrimitive<D_ARR[EX_ARR[N].output_indices[0]].data_type>::type;
+  if constexpr (N == 0 && _internal::isScalarGraph<graph>()) {
+    using T                 = scalar_graph_t<graph>;
+    constexpr auto &INPUTS  = graph_inputs<graph>;
+    constexpr auto &OUTPUTS = graph_outputs<graph>;
+
+    std::array<T, INPUTS.size()> inputs{};
+    for (size_t i{}; i < INPUTS.size(); i++) {
+      inputs[i] = *static_cast<T *>(memStore.tensor_refs[INPUTS[i]].data_ptr);
+    }
+    const auto outputs = exec_scalar_graph<graph>(inputs);
+    for (size_t i{}; i < OUTPUTS.size(); i++) {
+      *static_cast<T *>(memStore.tensor_refs[OUTPUTS[i]].data_ptr) = outputs[i];
+    }
+  } else {
+    using inp_type = typename manifold::DTypeToPrimitive<D_ARR[EX_ARR[N].output_indices[0]].data_type>::type;
+
+    _internal::SwitchIMPL<inp_type, EX_ARR[N], D_ARR>(memStore);
+    if constexpr (N < EX_ARR.size() - 1) { exec_cpu_graph<graph, N + 1>(memStore); }
+  }
+}
 
-  _internal::SwitchIMPL<inp_type, EX_ARR[N], D_ARR>(memStore);
-  if constexpr (N < EX_ARR.size() - 1) { exec_cpu_graph<graph, N + 1>(memStore); }
+//! exec_cpu_graph reporting every op to @param recorder (OpProfiler, TraceRecorder) built from the same
+//! @tparam graph.
+//!
+//! Note: Scalar graphs run op by op here instead of as straight line code, otherwise there would be no op
+//!       boundaries left to record.
+template<auto graph>
+inline void exec_cpu_graph(auto &memStore, OpRecorder auto &recorder) {
+  _internal::recordedOps<graph>(memStore, recorder, std::make_index_sequence<graph.expressions.size()>{});
+  recorder.endRun();
 }
-}  // namespace scions::cpu
\ No newline at end of file
+}  // namespace scions::cpu
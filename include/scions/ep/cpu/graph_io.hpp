@@ -0,0 +1,45 @@
+#pragma once
+#include "scions/common/common.hpp"
+
+namespace scions::cpu {
+namespace _internal {
+  //! Tensors never written by an expression are inputs, tensors never read are outputs
+  template<auto graph, bool Inputs>
+  consteval auto graphIOMask() {
+    std::array<bool, graph.data.size()> mask{};
+    mask.fill(true);
+    for (const auto &exp : graph.expressions) {
+      if constexpr (Inputs) {
+        for (size_t j{}; j < exp.out_size; j++) { mask.at(exp.output_indices[j]) = false; }
+      } else {
+        for (size_t j{}; j < exp.inp_size; j++) { mask.at(exp.input_indices[j]) = false; }
+      }
+    }
+    return mask;
+  }
+
+  template<auto graph, bool Inputs>
+  consteval size_t graphIOCount() {
+    const auto mask = graphIOMask<graph, Inputs>();
+    return static_cast<size_t>(std::count(mask.begin(), mask.end(), true));
+  }
+
+  template<auto graph, bool Inputs>
+  consteval auto graphIO() {
+    constexpr auto MASK = graphIOMask<graph, Inputs>();
+    std::array<uint32_t, graphIOCount<graph, Inputs>()> idxs{};
+    for (uint32_t i{}, jx{}; i < MASK.size(); i++) {
+      if (MASK[i]) { idxs[jx++] = i; }
+    }
+    return idxs;
+  }
+}  // namespace _internal
+
+//! Graph inputs (tensors no expression writes) of a CompactStaticGraph in increasing tensor index order
+template<auto graph>
+inline constexpr auto graph_inputs = _internal::graphIO<graph, true>();
+
+//! Graph outputs (tensors no expression reads) of a CompactStaticGraph in increasing tensor index order
+template<auto graph>
+inline constexpr auto graph_outputs = _internal::graphIO<graph, false>();
+}  // namespace scions::cpu
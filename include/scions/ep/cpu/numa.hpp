@@ -0,0 +1,217 @@
+#pragma once
+#include "manifold/constants.hpp"
+#include "scions/common/common.hpp"
+#include "task_graph.hpp"
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+//! NUMA placement of the arena of a graph. The tasks of the graph (see TaskGraph) are split between the nodes of the
+//! machine, every page of the arena is then first touched by a thread pinned on the node of the first task using it,
+//! the kernel backs the page with memory of that node. A ThreadPool built over the same topology pins its workers
+//! node by node and runs the tasks of a node on its workers first, so tasks mostly read local memory.
+//!
+//!     const auto topology = scions::cpu::NumaTopology::detect();
+//!     scions::cpu::RuntimeCpuGraph graph(compact);
+//!     graph.place(topology);  // before the inputs are written
+//!     scions::cpu::ThreadPool pool(topology);
+//!     graph.run(pool);
+//!
+//! Note: Linux only (sysfs and thread affinity), elsewhere the machine is a single node and nothing is pinned.
+//!       Placement relies on the arena pages not being touched yet, page providers never write them. Over
+//!       transparent huge pages a whole 2 MiB page goes to the node of its first toucher.
+
+namespace scions::cpu {
+struct NumaNode {
+  uint32_t id;
+  std::vector<uint32_t> cpus;
+};
+
+struct NumaTopology {
+  //! nodes having cpus, by increasing id
+  std::vector<NumaNode> nodes;
+
+  [[nodiscard]] size_t size() const noexcept { return nodes.size(); }
+
+  //! Nodes of this machine from /sys/devices/system/node, a single node with every cpu when it can't be read
+  [[nodiscard]] static NumaTopology detect() {
+    NumaTopology topology;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator("/sys/devices/system/node", error)) {
+      const std::string name = entry.path().filename().string();
+      if (!name.starts_with("node") || name.size() == 4
+          || !std::ranges::all_of(name.substr(4), [](const char chr) { return chr >= '0' && chr <= '9'; })) {
+        continue;
+      }
+      std::ifstream file(entry.path() / "cpulist");
+      std::string list;
+      std::getline(file, list);
+      NumaNode node{ static_cast<uint32_t>(std::stoul(name.substr(4))), parseCpuList(list) };
+      if (!node.cpus.empty()) { topology.nodes.push_back(std::move(node)); }
+    }
+    std::ranges::sort(topology.nodes, {}, &NumaNode::id);
+
+    if (topology.nodes.empty()) {
+      NumaNode node{ 0, {} };
+      const uint32_t cpus = std::max(1U, std::thread::hardware_concurrency());
+      for (uint32_t cpu{}; cpu < cpus; cpu++) { node.cpus.push_back(cpu); }
+      topology.nodes.push_back(std::move(node));
+    }
+    return topology;
+  }
+
+  //! Cpus of a sysfs cpu list like "0-3,8-11"
+  [[nodiscard]] static std::vector<uint32_t> parseCpuList(std::string_view list) {
+    std::vector<uint32_t> cpus;
+    while (!list.empty()) {
+      const size_t comma      = list.find(',');
+      const std::string range = std::string(list.substr(0, comma));
+      list                    = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+      if (range.empty() || range.front() < '0' || range.front() > '9') { continue; }
+      const size_t dash = range.find('-');
+      const auto first  = static_cast<uint32_t>(std::stoul(range.substr(0, dash)));
+      const auto last   = dash == std::string::npos ? first : static_cast<uint32_t>(std::stoul(range.substr(dash + 1)));
+      for (uint32_t cpu = first; cpu <= last; cpu++) { cpus.push_back(cpu); }
+    }
+    return cpus;
+  }
+};
+
+//! Restricts the calling thread to the cpus of @param node, false when the thread can't be pinned
+inline bool pinThread(const NumaNode &node) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (const uint32_t cpu : node.cpus) {
+    if (cpu < CPU_SETSIZE) { CPU_SET(cpu, &set); }
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)node;
+  return false;
+#endif
+}
+
+class NumaPlacement {
+public:
+  //! Splits the tasks of @param tasks, lowered from @param graph with @param ptrs, between @param nodes nodes. Tasks
+  //! are cut in execution order into shares moving about the same bytes, so independent chains laid out one after
+  //! the other (SortOrder::LOCALITY) stay on a node. Only the tensors in @param arena are placed, others (mapped
+  //! weights) are left alone.
+  template<typename Graph>
+  [[nodiscard]] NumaPlacement(const Graph &graph,
+    std::span<void *const> ptrs,
+    const TaskGraph &tasks,
+    std::span<std::byte> arena,
+    size_t nodes)
+    : node_count(std::max<size_t>(nodes, 1)), task_node(tasks.size()) {
+    const auto bytes = [&](const uint32_t tensor) {
+      const auto &ten = graph.data[tensor];
+      return ten.size * manifold::DTYPE_SIZES[static_cast<uint8_t>(ten.data_type)];
+    };
+    std::vector<size_t> work(tasks.size());
+    size_t total{};
+    for (uint32_t task{}; task < tasks.size(); task++) {
+      const auto [first, last] = tasks.ops(task);
+      for (uint32_t i = first; i < last; i++) {
+        const auto &exp = graph.expressions[i];
+        for (size_t j{}; j < exp.inp_size; j++) { work[task] += bytes(exp.input_indices[j]); }
+        for (size_t j{}; j < exp.out_size; j++) { work[task] += bytes(exp.output_indices[j]); }
+      }
+      total += work[task];
+    }
+    size_t done{};
+    for (uint32_t task{}; task < tasks.size(); task++) {
+      // node of the middle of the task in the cumulative work
+      const size_t middle = done + work[task] / 2;
+      task_node[task] = total == 0 ? 0 : static_cast<uint32_t>(std::min(middle * node_count / total, node_count - 1));
+      done += work[task];
+    }
+
+    // every tensor goes to the node of the first task using it
+    std::vector<uint32_t> tensor_node(graph.data.size(), TaskGraph::NONE);
+    for (uint32_t task{}; task < tasks.size(); task++) {
+      const auto [first, last] = tasks.ops(task);
+      for (uint32_t i = first; i < last; i++) {
+        const auto &exp  = graph.expressions[i];
+        const auto claim = [&](const uint32_t tensor) {
+          if (tensor_node[tensor] == TaskGraph::NONE) { tensor_node[tensor] = task_node[task]; }
+        };
+        for (size_t j{}; j < exp.inp_size; j++) { claim(exp.input_indices[j]); }
+        for (size_t j{}; j < exp.out_size; j++) { claim(exp.output_indices[j]); }
+      }
+    }
+    const auto in_arena = [&](const std::byte *ptr, const size_t size) {
+      const auto begin = reinterpret_cast<uintptr_t>(arena.data());
+      const auto addr  = reinterpret_cast<uintptr_t>(ptr);
+      return addr >= begin && addr - begin <= arena.size() && size <= arena.size() - (addr - begin);
+    };
+    for (uint32_t i{}; i < graph.data.size(); i++) {
+      auto *ptr = static_cast<std::byte *>(ptrs[i]);
+      if (tensor_node[i] != TaskGraph::NONE && bytes(i) != 0 && in_arena(ptr, bytes(i))) {
+        regions.push_back(Region{ ptr, bytes(i), tensor_node[i] });
+      }
+    }
+  }
+
+  [[nodiscard]] size_t nodes() const noexcept { return node_count; }
+
+  //! Node the task @param task should run on
+  [[nodiscard]] uint32_t node(uint32_t task) const noexcept { return task_node[task]; }
+
+  //! Touches every page of the tensors from a thread pinned on their node, call before anything writes the arena : a
+  //! page already written stays where it is. The data is kept. Pages shared by tensors of different nodes stay with
+  //! the first. @param topology needs nodes() nodes.
+  void firstTouch(const NumaTopology &topology) const {
+    if (topology.size() < node_count) {
+      throw std::invalid_argument(
+        std::format("Scions CPU: placement over {} nodes on a machine of {}", node_count, topology.size()));
+    }
+#if defined(__linux__)
+    const auto page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+#else
+    const uintptr_t page = 4096;
+#endif
+    // a page belongs to the node of its first region, it is touched through the first byte of the region in it
+    std::map<uintptr_t, std::pair<uint32_t, std::byte *>> owner;
+    for (const Region &region : regions) {
+      const auto begin = reinterpret_cast<uintptr_t>(region.begin);
+      for (uintptr_t addr = begin / page * page; addr < begin + region.bytes; addr += page) {
+        owner.emplace(addr, std::pair{ region.node, region.begin + (std::max(addr, begin) - begin) });
+      }
+    }
+
+    std::vector<std::thread> touchers;
+    for (uint32_t node{}; node < node_count; node++) {
+      touchers.emplace_back([&, node] {
+        pinThread(topology.nodes[node]);
+        for (const auto &[addr, target] : owner) {
+          if (target.first == node) {
+            // rewrite the byte it holds, a touch never changes the data
+            volatile std::byte *byte = target.second;
+            *byte                    = *byte;
+          }
+        }
+      });
+    }
+    for (auto &toucher : touchers) { toucher.join(); }
+  }
+
+private:
+  struct Region {
+    std::byte *begin;
+    size_t bytes;
+    uint32_t node;
+  };
+
+  size_t node_count;
+  std::vector<uint32_t> task_node;
+  std::vector<Region> regions;
+};
+}  // namespace scions::cpu
@@ -0,0 +1,14 @@
+#pragma once
+#include "scions/common/common.hpp"
+
+namespace scions::cpu {
+//! Anything the instrumented executor paths can report op boundaries to (OpProfiler, TraceRecorder). An
+//! executor calls `begin()` right before op `idx` of its graph runs and `end(idx)` right after it, both from the
+//! thread running the op, then `endRun()` once the whole graph ran.
+template<typename R>
+concept OpRecorder = requires(R &rec, size_t idx) {
+  rec.begin();
+  rec.end(idx);
+  rec.endRun();
+};
+}  // namespace scions::cpu
@@ -4,28 +4,186 @@
 
 #pragma once
 #include "scions/common/common.hpp"
+#include <cmath>
+
+//! Note: Memory planner can hand out the buffer of a dying input as output (in place execution), so
+//! every kernel here must stay correct for `out == in[j]`. Element wise kernels read all the inputs of
+//! element i before writing element i which keeps exact aliasing safe. Partial overlaps never happen as
+//! buffers are only shared between equally sized tensors.
 
 namespace scions::cpu {
-template<typename T, size_t N, size_t IN_S>
-void element_wise_add(T *out, std::array<T *, IN_S> &in)
+// Runtime length kernels, also used by the batched executor where n = batch * tensor size
+template<typename T, size_t IN_S>
+void element_wise_add(T *out, std::array<T *, IN_S> &in, const size_t n)
   requires std::is_arithmetic_v<T>
 {
-  for (size_t i = 0; i < N; ++i) {
+  for (size_t i = 0; i < n; ++i) {
     T sum{ in[0][i] };
     for (size_t j = 1; j < IN_S; ++j) { sum += in[j][i]; }
     out[i] = sum;
   }
 }
 
-template<typename T, size_t N, size_t IN_S>
-void element_wise_mul(T *out, std::array<T *, IN_S> &in)
+template<typename T, size_t IN_S>
+void element_wise_mul(T *out, std::array<T *, IN_S> &in, const size_t n)
   requires std::is_arithmetic_v<T>
 {
-  for (size_t i = 0; i < N; ++i) {
+  for (size_t i = 0; i < n; ++i) {
     T prod{ in[0][i] };
     for (size_t j = 1; j < IN_S; ++j) { prod *= in[j][i]; }
     out[i] = prod;
   }
 }
 
-}  // namespace scions::cpu
\ No newline at end of file
+template<typename T, size_t IN_S>
+void element_wise_sub(T *out, std::array<T *, IN_S> &in, const size_t n)
+  requires std::is_arithmetic_v<T>
+{
+  for (size_t i = 0; i < n; ++i) {
+    T diff{ in[0][i] };
+    for (size_t j = 1; j < IN_S; ++j) { diff -= in[j][i]; }
+    out[i] = diff;
+  }
+}
+
+template<typename T, size_t IN_S>
+void element_wise_div(T *out, std::array<T *, IN_S> &in, const size_t n)
+  requires std::is_arithmetic_v<T>
+{
+  for (size_t i = 0; i < n; ++i) {
+    T quot{ in[0][i] };
+    for (size_t j = 1; j < IN_S; ++j) { quot /= in[j][i]; }
+    out[i] = quot;
+  }
+}
+
+template<typename T>
+void element_wise_exp(T *out, const T *in, const size_t n)
+  requires std::is_arithmetic_v<T>
+{
+  for (size_t i = 0; i < n; ++i) { out[i] = static_cast<T>(std::exp(in[i])); }
+}
+
+// Scalar ops have no input tensor, they update their output in place
+template<typename T>
+void scalar_add(T *out, const T value, const size_t n)
+  requires std::is_arithmetic_v<T>
+{
+  for (size_t i = 0; i < n; ++i) { out[i] += value; }
+}
+
+template<typename T>
+void scalar_sub(T *out, const T value, const size_t n)
+  requires std::is_arithmetic_v<T>
+{
+  for (size_t i = 0; i < n; ++i) { out[i] -= value; }
+}
+
+template<typename T>
+void scalar_mul(T *out, const T value, const size_t n)
+  requires std::is_arithmetic_v<T>
+{
+  for (size_t i = 0; i < n; ++i) { out[i] *= value; }
+}
+
+template<typename T>
+void scalar_div(T *out, const T value, const size_t n)
+  requires std::is_arithmetic_v<T>
+{
+  for (size_t i = 0; i < n; ++i) { out[i] /= value; }
+}
+
+template<typename T>
+void fill(T *out, const T value, const size_t n)
+  requires std::is_arithmetic_v<T>
+{
+  std::fill_n(out, n, value);
+}
+
+template<typename T>
+void copy(T *out, const T *in, const size_t n)
+  requires std::is_arithmetic_v<T>
+{
+  // in place copy is a no-op
+  if (out != in) { std::copy_n(in, n, out); }
+}
+
+// Compile time length versions used by exec_cpu_graph
+template<typename T, size_t N, size_t IN_S>
+void element_wise_add(T *out, std::array<T *, IN_S> &in)
+  requires std::is_arithmetic_v<T>
+{
+  element_wise_add(out, in, N);
+}
+
+template<typename T, size_t N, size_t IN_S>
+void element_wise_mul(T *out, std::array<T *, IN_S> &in)
+  requires std::is_arithmetic_v<T>
+{
+  element_wise_mul(out, in, N);
+}
+
+template<typename T, size_t N, size_t IN_S>
+void element_wise_sub(T *out, std::array<T *, IN_S> &in)
+  requires std::is_arithmetic_v<T>
+{
+  element_wise_sub(out, in, N);
+}
+
+template<typename T, size_t N, size_t IN_S>
+void element_wise_div(T *out, std::array<T *, IN_S> &in)
+  requires std::is_arithmetic_v<T>
+{
+  element_wise_div(out, in, N);
+}
+
+template<typename T, size_t N>
+void element_wise_exp(T *out, const T *in)
+  requires std::is_arithmetic_v<T>
+{
+  element_wise_exp(out, in, N);
+}
+
+template<typename T, size_t N>
+void scalar_add(T *out, const T value)
+  requires std::is_arithmetic_v<T>
+{
+  scalar_add(out, value, N);
+}
+
+template<typename T, size_t N>
+void scalar_sub(T *out, const T value)
+  requires std::is_arithmetic_v<T>
+{
+  scalar_sub(out, value, N);
+}
+
+template<typename T, size_t N>
+void scalar_mul(T *out, const T value)
+  requires std::is_arithmetic_v<T>
+{
+  scalar_mul(out, value, N);
+}
+
+template<typename T, size_t N>
+void scalar_div(T *out, const T value)
+  requires std::is_arithmetic_v<T>
+{
+  scalar_div(out, value, N);
+}
+
+template<typename T, size_t N>
+void fill(T *out, const T value)
+  requires std::is_arithmetic_v<T>
+{
+  fill(out, value, N);
+}
+
+template<typename T, size_t N>
+void copy(T *out, const T *in)
+  requires std::is_arithmetic_v<T>
+{
+  copy(out, in, N);
+}
+
+}  // namespace scions::cpu
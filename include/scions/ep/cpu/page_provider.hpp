@@ -0,0 +1,13 @@
+#pragma once
+#include "scions/common/page_provider.hpp"
+
+//! Page providers of the CPU EP, see scions/common/page_provider.hpp
+
+namespace scions::cpu {
+using mem::HugePages;
+using mem::NormalPages;
+using mem::PageBuffer;
+using mem::PageKind;
+using mem::PageProvider;
+using mem::pageKindToString;
+}  // namespace scions::cpu
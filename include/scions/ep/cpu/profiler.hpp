@@ -0,0 +1,245 @@
+#pragma once
+#include "manifold/constants.hpp"
+#include "manifold/cost_model.hpp"
+#include "manifold/op_type.hpp"
+#include "manifold/utility.hpp"
+#include "op_recorder.hpp"
+#include "scions/common/common.hpp"
+#include <chrono>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//! Opt-in per op profiling of the CPU executors. Executors only take an OpProfiler through their profiled
+//! overloads (exec_cpu_graph(store, profiler), RuntimeCpuGraph::run(profiler)), the default paths are untouched
+//! so profiling costs nothing unless it is asked for.
+//!
+//!     scions::cpu::OpProfiler profiler(compact);
+//!     for (int i{}; i < 100; i++) { scions::cpu::exec_cpu_graph<compact>(store, profiler); }
+//!     std::print("{}", profiler.table());
+//!
+//! Hardware counters (cycles, instructions, LLC misses) come from perf_event_open on linux, they read as 0 when
+//! the kernel doesn't allow it (see /proc/sys/kernel/perf_event_paranoid) or on other platforms.
+
+namespace scions::cpu {
+//! Cost of a single op. Bytes and flops are per call and derived from the graph, times and counters are summed
+//! over every profiled call.
+struct OpProfile {
+  uint32_t id;
+  manifold::OpType type;
+  manifold::DType data_type;
+  uint64_t elements;
+  uint64_t bytes_read;
+  uint64_t bytes_written;
+  //! arithmetic ops per call, math functions (exp, sin ...) count as one
+  uint64_t flops;
+
+  uint64_t calls;
+  uint64_t ns;
+  uint64_t cycles;
+  uint64_t instructions;
+  uint64_t llc_misses;
+
+  [[nodiscard]] double averageNs() const noexcept {
+    return calls == 0 ? 0.0 : static_cast<double>(ns) / static_cast<double>(calls);
+  }
+};
+
+namespace _internal {
+  //! Static part of the OpProfile of @param exp, @param data are the tensors its indices point into
+  inline OpProfile opCost(const auto &exp, const auto &data) {
+    const manifold::OpCost cost = manifold::expressionCost(exp, data);
+    return OpProfile{ exp.id,
+      exp.type,
+      exp.data_type,
+      data[exp.output_indices[0]].size,
+      cost.bytes_read,
+      cost.bytes_written,
+      cost.flops,
+      0,
+      0,
+      0,
+      0,
+      0 };
+  }
+
+  //! cycles, instructions and LLC misses of the calling thread as one perf event group
+  class PerfCounters {
+  public:
+    static constexpr size_t COUNT = 3;
+    using Values                  = std::array<uint64_t, COUNT>;
+
+    PerfCounters() {
+#if defined(__linux__)
+      constexpr std::array<uint64_t, COUNT> events{
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES
+      };
+      for (size_t i{}; i < COUNT; i++) {
+        perf_event_attr attr{};
+        attr.type           = PERF_TYPE_HARDWARE;
+        attr.size           = sizeof(perf_event_attr);
+        attr.config         = events[i];
+        attr.disabled       = i == 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_GROUP;
+        fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds[0], 0));
+        if (fds[i] < 0) {
+          close();
+          return;
+        }
+      }
+      ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    PerfCounters(const PerfCounters &)            = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    ~PerfCounters() { close(); }
+
+    [[nodiscard]] bool valid() const noexcept { return fds[0] >= 0; }
+
+    //! Current value of every counter, zeros when the counters couldn't be opened
+    [[nodiscard]] Values read() const noexcept {
+      Values values{};
+#if defined(__linux__)
+      if (valid()) {
+        struct {
+          uint64_t nr;
+          Values values;
+        } group{};
+        if (::read(fds[0], &group, sizeof(group)) == static_cast<ssize_t>(sizeof(group))) { values = group.values; }
+      }
+#endif
+      return values;
+    }
+
+  private:
+    void close() noexcept {
+#if defined(__linux__)
+      for (int &fd : fds) {
+        if (fd >= 0) { ::close(fd); }
+        fd = -1;
+      }
+#endif
+    }
+
+    std::array<int, COUNT> fds{ -1, -1, -1 };
+  };
+}  // namespace _internal
+
+//! OpRecorder collecting an OpProfile per op of a compact graph (manifold::CompactStaticGraph or
+//! CompactRuntimeGraph), indexed like graph.expressions, and aggregating them over every profiled run.
+class OpProfiler {
+public:
+  //! @param hw_counters : also read the perf_event counters around every op, each read is a syscall
+  template<typename Graph>
+  [[nodiscard]] explicit OpProfiler(const Graph &graph, bool hw_counters = true) {
+    profiles.reserve(graph.expressions.size());
+    for (const auto &exp : graph.expressions) { profiles.push_back(_internal::opCost(exp, graph.data)); }
+    if (hw_counters) { counters = std::make_unique<_internal::PerfCounters>(); }
+  }
+
+  //! Called by the executors right before the op runs
+  void begin() noexcept {
+    if (counters) { start_counters = counters->read(); }
+    start = std::chrono::steady_clock::now();
+  }
+
+  //! Called by the executors right after op @param idx ran
+  void end(size_t idx) noexcept {
+    const auto stop = std::chrono::steady_clock::now();
+    auto &prof      = profiles[idx];
+    prof.calls++;
+    prof.ns += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+    if (counters) {
+      const auto values = counters->read();
+      prof.cycles += values[0] - start_counters[0];
+      prof.instructions += values[1] - start_counters[1];
+      prof.llc_misses += values[2] - start_counters[2];
+    }
+  }
+
+  //! Called by the executors once a whole graph ran
+  void endRun() noexcept { runs++; }
+
+  [[nodiscard]] uint64_t runCount() const noexcept { return runs; }
+
+  //! True when the hardware counters are available and read
+  [[nodiscard]] bool hasCounters() const noexcept { return counters && counters->valid(); }
+
+  [[nodiscard]] std::span<const OpProfile> ops() const noexcept { return profiles; }
+
+  //! Ops by decreasing total time
+  [[nodiscard]] std::vector<OpProfile> sorted() const {
+    std::vector<OpProfile> ops(profiles);
+    std::ranges::stable_sort(ops, std::greater{}, &OpProfile::ns);
+    return ops;
+  }
+
+  //! Zeroes the measurements, the static costs stay
+  void reset() noexcept {
+    runs = 0;
+    for (auto &prof : profiles) { prof.calls = prof.ns = prof.cycles = prof.instructions = prof.llc_misses = 0; }
+  }
+
+  //! Human readable report, most expensive op first
+  [[nodiscard]] std::string table() const {
+    uint64_t total{};
+    for (const auto &prof : profiles) { total += prof.ns; }
+
+    std::string out = std::format("{:>6} {:>14} {:>8} {:>8} {:>12} {:>7} {:>10} {:>10}",
+      "id",
+      "op",
+      "dtype",
+      "calls",
+      "avg ns",
+      "time %",
+      "GB/s",
+      "GFLOP/s");
+    if (hasCounters()) { out += std::format(" {:>12} {:>6} {:>12}", "cycles", "IPC", "LLC miss"); }
+    out += '\n';
+
+    for (const auto &prof : sorted()) {
+      const double avg = prof.averageNs();
+      // bytes (flops) per ns is GB/s (GFLOP/s)
+      const double bandwidth = avg == 0.0 ? 0.0 : static_cast<double>(prof.bytes_read + prof.bytes_written) / avg;
+      const double flops     = avg == 0.0 ? 0.0 : static_cast<double>(prof.flops) / avg;
+      out += std::format("{:>6} {:>14} {:>8} {:>8} {:>12.1f} {:>7.2f} {:>10.2f} {:>10.2f}",
+        prof.id,
+        manifold::optypeToString(prof.type),
+        manifold::dtypeToString(prof.data_type),
+        prof.calls,
+        avg,
+        total == 0 ? 0.0 : 100.0 * static_cast<double>(prof.ns) / static_cast<double>(total),
+        bandwidth,
+        flops);
+      if (hasCounters()) {
+        const double calls = static_cast<double>(std::max<uint64_t>(prof.calls, 1));
+        out += std::format(" {:>12.0f} {:>6.2f} {:>12.0f}",
+          static_cast<double>(prof.cycles) / calls,
+          prof.cycles == 0 ? 0.0 : static_cast<double>(prof.instructions) / static_cast<double>(prof.cycles),
+          static_cast<double>(prof.llc_misses) / calls);
+      }
+      out += '\n';
+    }
+    out += std::format("{} runs, {:.1f} ns per run\n",
+      runs,
+      runs == 0 ? 0.0 : static_cast<double>(total) / static_cast<double>(runs));
+    return out;
+  }
+
+private:
+  std::vector<OpProfile> profiles;
+  std::unique_ptr<_internal::PerfCounters> counters;
+  _internal::PerfCounters::Values start_counters{};
+  std::chrono::steady_clock::time_point start;
+  uint64_t runs{};
+};
+}  // namespace scions::cpu
@@ -0,0 +1,158 @@
+#pragma once
+#include "cpu_graph.hpp"
+#include "manifold/runtime_graph.hpp"
+#include "numa.hpp"
+#include "op_recorder.hpp"
+#include "page_provider.hpp"
+#include "scions/common/common.hpp"
+#include "task_graph.hpp"
+#include "thread_pool.hpp"
+#include "tile_schedule.hpp"
+#include "tuning_table.hpp"
+#include "weight_file.hpp"
+
+//! Executor for graphs built at runtime (manifold::CompactRuntimeGraph). Same kernels and arena layout as
+//! exec_cpu_graph, the graph is lowered once to a CpuGraph so the op, dtype and input count aren't dispatched
+//! again on every run.
+
+namespace scions::cpu {
+//! Owns a CompactRuntimeGraph together with its arena.
+//!
+//!     scions::cpu::RuntimeCpuGraph exec(manifold::compact(builder.toDag().topologicalSort()));
+//!     std::ranges::fill(exec.tensorSpan<float>(exec.inputs()[0]), 1.0F);
+//!     exec.run();
+class RuntimeCpuGraph {
+public:
+  [[nodiscard]] explicit RuntimeCpuGraph(manifold::CompactRuntimeGraph compact_graph)
+    : RuntimeCpuGraph(std::move(compact_graph), nullptr, nullptr) {}
+
+  //! Graph inputs held by @param weights (matched by tensor id) are read in place from the mapping instead of the
+  //! arena, they are read only. @param weights has to outlive the graph.
+  [[nodiscard]] RuntimeCpuGraph(manifold::CompactRuntimeGraph compact_graph, const MappedWeights &weights)
+    : RuntimeCpuGraph(std::move(compact_graph), &weights, nullptr) {}
+
+  //! Kernels and tiles configured by @param tuning (see autotune), which is only read while lowering
+  [[nodiscard]] RuntimeCpuGraph(manifold::CompactRuntimeGraph compact_graph, const TuningTable &tuning)
+    : RuntimeCpuGraph(std::move(compact_graph), nullptr, &tuning) {}
+
+  [[nodiscard]] RuntimeCpuGraph(manifold::CompactRuntimeGraph compact_graph,
+    const MappedWeights &weights,
+    const TuningTable &tuning)
+    : RuntimeCpuGraph(std::move(compact_graph), &weights, &tuning) {}
+
+  //! Graph inputs (tensors no expression writes) in increasing tensor index order
+  [[nodiscard]] std::span<const uint32_t> inputs() const noexcept { return graph_inputs; }
+
+  //! Graph outputs (tensors no expression reads) in increasing tensor index order
+  [[nodiscard]] std::span<const uint32_t> outputs() const noexcept { return graph_outputs; }
+
+  //! Typed view of the tensor at index @param idx, throws if T doesn't match the tensor dtype
+  template<typename T>
+  [[nodiscard]] std::span<T> tensorSpan(size_t idx) {
+    const auto &ten = graph.data.at(idx);
+    if (sizeof(T) != manifold::DTYPE_SIZES[static_cast<uint8_t>(ten.data_type)]) {
+      throw std::runtime_error(std::format("Scions CPU: tensor {} is not of the requested type", idx));
+    }
+    return std::span<T>(static_cast<T *>(ptrs[idx]), ten.size);
+  }
+
+  //! Address of every tensor, indexed like compactGraph().data
+  [[nodiscard]] std::span<void *const> tensorAddresses() const noexcept { return ptrs; }
+
+  //! Pages backing the arena, huge pages when the system gave some (see page_provider.hpp)
+  [[nodiscard]] PageKind pageKind() const noexcept { return arena.kind(); }
+
+  void run() const { plan.run(); }
+
+  //! run() reporting every op to @param recorder (OpProfiler, TraceRecorder)
+  void run(OpRecorder auto &recorder) const { plan.run(recorder); }
+
+  //! Workers of the ThreadPool running the graph : TuningTable::threads when it was lowered with a tuning table, every
+  //! hardware thread otherwise
+  [[nodiscard]] size_t threads() const noexcept { return workers; }
+
+  //! Runs the independent ops (and pinned groups) of the graph in parallel on @param pool, the tasks of each node on
+  //! its workers first once the graph is placed
+  void run(ThreadPool &pool) const { pool.run(plan, tasks, placement ? &*placement : nullptr); }
+
+  //! run(pool) reporting every op to @param recorder from the worker running it (TraceRecorder, see thread_pool.hpp)
+  void run(ThreadPool &pool, OpRecorder auto &recorder) const {
+    pool.run(plan, tasks, recorder, placement ? &*placement : nullptr);
+  }
+
+  //! Splits the tasks between the nodes of @param topology and places the arena pages on the node of the tasks using
+  //! them (see NumaPlacement). Call before anything writes the tensors, the inputs included.
+  void place(const NumaTopology &topology) {
+    placement.emplace(graph, ptrs, tasks, std::span(arena.data(), graph.meta.total), topology.size());
+    placement->firstTouch(topology);
+  }
+
+  //! Runs the graph segment by segment, element wise segments a cache sized tile at a time (see TileSchedule)
+  void runTiled() const { tiles.run(plan); }
+
+  [[nodiscard]] const manifold::CompactRuntimeGraph &compactGraph() const noexcept { return graph; }
+
+  [[nodiscard]] const CpuGraph &cpuGraph() const noexcept { return plan; }
+
+  [[nodiscard]] const TaskGraph &taskGraph() const noexcept { return tasks; }
+
+  [[nodiscard]] const TileSchedule &tileSchedule() const noexcept { return tiles; }
+
+private:
+  [[nodiscard]] RuntimeCpuGraph(manifold::CompactRuntimeGraph compact_graph,
+    const MappedWeights *weights,
+    const TuningTable *tuning)
+    : graph(std::move(compact_graph)), arena(HugePages{}.allocate(std::max<size_t>(graph.meta.total, 1))),
+      ptrs(tensorPointers(graph, arena.data(), weights)), plan(graph, ptrs, tuning), tasks(graph, ptrs),
+      tiles(graph, ptrs, tuning == nullptr ? SCIONS_CPU_TILE_BYTES : tuning->tile_bytes),
+      workers(tuning == nullptr ? TuningTable{}.threads : tuning->threads) {
+    std::vector<uint8_t> written(graph.data.size());
+    std::vector<uint8_t> read(graph.data.size());
+    for (const auto &exp : graph.expressions) {
+      for (size_t j{}; j < exp.out_size; j++) { written[exp.output_indices[j]] = 1; }
+      for (size_t j{}; j < exp.inp_size; j++) { read[exp.input_indices[j]] = 1; }
+    }
+    for (uint32_t i{}; i < graph.data.size(); i++) {
+      if (!written[i]) { graph_inputs.push_back(i); }
+      if (!read[i]) { graph_outputs.push_back(i); }
+    }
+  }
+
+  //! Address of every tensor at its planned offset in @param base, or in @param weights when it holds the tensor
+  static std::vector<void *> tensorPointers(const manifold::CompactRuntimeGraph &graph,
+    std::byte *base,
+    const MappedWeights *weights) {
+    std::vector<uint8_t> written(graph.data.size());
+    for (const auto &exp : graph.expressions) {
+      for (size_t j{}; j < exp.out_size; j++) { written[exp.output_indices[j]] = 1; }
+    }
+
+    std::vector<void *> ptrs(graph.data.size());
+    for (size_t i{}; i < graph.data.size(); i++) {
+      const auto &ten = graph.data[i];
+      ptrs[i]         = base + graph.meta.poolByteOffset(ten.data_type)
+                + graph.offsets[i] * manifold::DTYPE_SIZES[static_cast<uint8_t>(ten.data_type)];
+
+      const std::byte *mapped = weights == nullptr ? nullptr : weightData(*weights, ten);
+      if (mapped == nullptr) { continue; }
+      if (written[i]) {
+        throw std::invalid_argument(
+          std::format("Scions CPU: tensor {} is written by the graph, it can't be read from a weight file", ten.id));
+      }
+      ptrs[i] = const_cast<std::byte *>(mapped);
+    }
+    return ptrs;
+  }
+
+  manifold::CompactRuntimeGraph graph;
+  PageBuffer arena;
+  std::vector<void *> ptrs;
+  std::vector<uint32_t> graph_inputs;
+  std::vector<uint32_t> graph_outputs;
+  CpuGraph plan;
+  TaskGraph tasks;
+  TileSchedule tiles;
+  size_t workers;
+  std::optional<NumaPlacement> placement;
+};
+}  // namespace scions::cpu
@@ -0,0 +1,101 @@
+#pragma once
+#include "manifold/constants.hpp"
+#include "manifold/op_type.hpp"
+#include "manifold/ops/element_wise_ops.hpp"
+#include "graph_io.hpp"
+#include "scions/common/common.hpp"
+#include <cmath>
+#include <utility>
+
+//! Straight line lowering of scalar graphs (every tensor holds a single element of one dtype, as the graphs built
+//! from manifold::Scalar). Instead of pointers into a CpuMemStore and loops of length 1, the whole graph becomes
+//! one inlined function over a local array indexed by compile time constants, which the compiler promotes to
+//! registers.
+
+namespace scions::cpu {
+namespace _internal {
+  template<auto graph>
+  consteval bool isScalarGraph() {
+    if (graph.data.empty() || graph.expressions.empty()) { return false; }
+    const auto type = graph.data[0].data_type;
+    for (const auto &ten : graph.data) {
+      if (ten.size != 1 || ten.data_type != type) { return false; }
+    }
+    return true;
+  }
+
+  template<typename T, auto exp, typename Fn, size_t... J>
+  [[gnu::always_inline]] inline T foldInputs(const auto &regs, Fn fn, std::index_sequence<J...>) {
+    T acc = regs[exp.input_indices[0]];
+    ((acc = fn(acc, regs[exp.input_indices[J + 1]])), ...);
+    return acc;
+  }
+
+  template<typename T, auto exp>
+  [[gnu::always_inline]] inline void scalarOp(auto &regs) {
+    using manifold::OpType;
+    constexpr auto OP  = exp.type;
+    constexpr auto OUT = exp.output_indices[0];
+    using rest         = std::make_index_sequence<(exp.inp_size > 0 ? exp.inp_size - 1 : 0)>;
+
+    if constexpr (OP == OpType::ELM_ADD) {
+      regs[OUT] = foldInputs<T, exp>(regs, std::plus<T>{}, rest{});
+    } else if constexpr (OP == OpType::ELM_SUB) {
+      regs[OUT] = foldInputs<T, exp>(regs, std::minus<T>{}, rest{});
+    } else if constexpr (OP == OpType::ELM_MUL) {
+      regs[OUT] = foldInputs<T, exp>(regs, std::multiplies<T>{}, rest{});
+    } else if constexpr (OP == OpType::ELM_DIV) {
+      regs[OUT] = foldInputs<T, exp>(regs, std::divides<T>{}, rest{});
+    } else if constexpr (OP == OpType::EXPONENTIAL) {
+      regs[OUT] = static_cast<T>(std::exp(regs[exp.input_indices[0]]));
+    } else if constexpr (OP == OpType::COPY) {
+      regs[OUT] = regs[exp.input_indices[0]];
+    } else if constexpr (OP == OpType::SCL_ELM_ADD) {
+      regs[OUT] += manifold::op::oneValue<T>(exp.params);
+    } else if constexpr (OP == OpType::SCL_ELM_SUB) {
+      regs[OUT] -= manifold::op::oneValue<T>(exp.params);
+    } else if constexpr (OP == OpType::SCL_ELM_MUL) {
+      regs[OUT] *= manifold::op::oneValue<T>(exp.params);
+    } else if constexpr (OP == OpType::SCL_ELM_DIV) {
+      regs[OUT] /= manifold::op::oneValue<T>(exp.params);
+    } else if constexpr (OP == OpType::ELM_FILL) {
+      constexpr T value = manifold::op::oneValue<T>(exp.params);
+      [&]<size_t... J>(std::index_sequence<J...>) {
+        ((regs[exp.output_indices[J]] = value), ...);
+      }(std::make_index_sequence<exp.out_size>{});
+    } else {
+      static_assert(sizeof(T) == 0, "Scions CPU: op has no scalar lowering");
+    }
+  }
+
+  template<typename T, auto graph, size_t... I>
+  [[gnu::always_inline]] inline void scalarOps(auto &regs, std::index_sequence<I...>) {
+    (scalarOp<T, graph.expressions[I]>(regs), ...);
+  }
+}  // namespace _internal
+
+template<auto graph>
+  requires(_internal::isScalarGraph<graph>())
+using scalar_graph_t = typename manifold::DTypeToPrimitive<graph.data[0].data_type>::type;
+
+//! Evaluates a scalar CompactStaticGraph as straight line code.
+//!
+//! @param inputs : values of the graph inputs, ordered as @ref graph_inputs
+//! @return values of the graph outputs, ordered as @ref graph_outputs
+template<auto graph, typename T = scalar_graph_t<graph>>
+[[nodiscard, gnu::always_inline]] inline std::array<T, _internal::graphIOCount<graph, false>()>
+  exec_scalar_graph(const std::array<T, _internal::graphIOCount<graph, true>()> &inputs) {
+  constexpr auto &INPUTS  = graph_inputs<graph>;
+  constexpr auto &OUTPUTS = graph_outputs<graph>;
+
+  // One local per tensor, all accesses use constant indices so these never touch memory
+  std::array<T, graph.data.size()> regs{};
+  for (size_t i{}; i < INPUTS.size(); i++) { regs[INPUTS[i]] = inputs[i]; }
+
+  _internal::scalarOps<T, graph>(regs, std::make_index_sequence<graph.expressions.size()>{});
+
+  std::array<T, OUTPUTS.size()> outputs{};
+  for (size_t i{}; i < OUTPUTS.size(); i++) { outputs[i] = regs[OUTPUTS[i]]; }
+  return outputs;
+}
+}  // namespace scions::cpu
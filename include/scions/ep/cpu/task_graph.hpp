@@ -0,0 +1,153 @@
+#pragma once
+#include "manifold/constants.hpp"
+#include "scions/common/common.hpp"
+#include <map>
+
+//! Tasks of a compact graph for the parallel executor (ThreadPool). A task is a run of consecutive ops of the
+//! execution order : every member of a pinned group lands in a single task so the group runs back to back on one
+//! worker with its intermediates still in cache, every other op is a task of its own. Members of free groups keep
+//! their group as a hint, the pool prefers continuing a group on the worker that ran its previous member.
+//!
+//! Dependencies come from the memory the ops touch, not from tensor ids : the planner makes tensors share buffers,
+//! so an op also waits for every earlier reader (and writer) of the bytes it overwrites.
+
+namespace scions::cpu {
+class TaskGraph {
+public:
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  //! @param graph : manifold::CompactStaticGraph or CompactRuntimeGraph
+  //! @param ptrs : address of every tensor of the graph, indexed like graph.data (see CpuGraph)
+  template<typename Graph>
+  [[nodiscard]] TaskGraph(const Graph &graph, std::span<void *const> ptrs) {
+    if (ptrs.size() != graph.data.size()) {
+      throw std::invalid_argument(
+        std::format("Scions CPU: {} tensor addresses for a graph of {} tensors", ptrs.size(), graph.data.size()));
+    }
+
+    const auto &exprs = graph.expressions;
+    for (uint32_t i{}; i < exprs.size(); i++) {
+      const bool joins = i > 0 && exprs[i].pinned && exprs[i - 1].pinned && exprs[i].group == exprs[i - 1].group;
+      if (!joins) {
+        starts.push_back(i);
+        groups.push_back(exprs[i].group);
+      }
+    }
+    starts.push_back(static_cast<uint32_t>(exprs.size()));
+
+    Accesses accesses;
+    std::vector<std::pair<uint32_t, uint32_t>> deps;
+    const auto range = [&](const uint32_t tensor) {
+      const auto &ten   = graph.data[tensor];
+      const auto begin  = reinterpret_cast<uintptr_t>(ptrs[tensor]);
+      const size_t size = ten.size * manifold::DTYPE_SIZES[static_cast<uint8_t>(ten.data_type)];
+      return std::pair{ begin, begin + std::max<size_t>(size, 1) };
+    };
+    for (uint32_t task{}; task < size(); task++) {
+      for (uint32_t i = starts[task]; i < starts[task + 1]; i++) {
+        const auto &exp = exprs[i];
+        for (size_t j{}; j < exp.inp_size; j++) {
+          const auto [begin, end] = range(exp.input_indices[j]);
+          accesses.touch(begin, end, task, false, deps);
+        }
+        // a write waits for the previous writer too, which also orders the read-modify-write of scalar ops
+        for (size_t j{}; j < exp.out_size; j++) {
+          const auto [begin, end] = range(exp.output_indices[j]);
+          accesses.touch(begin, end, task, true, deps);
+        }
+      }
+    }
+
+    std::ranges::sort(deps);
+    const auto [first, last] = std::ranges::unique(deps);
+    deps.erase(first, last);
+
+    offsets.assign(size() + 1, 0);
+    in_degree.assign(size(), 0);
+    for (const auto &[from, to] : deps) {
+      offsets[from + 1]++;
+      in_degree[to]++;
+    }
+    for (uint32_t i{}; i < size(); i++) { offsets[i + 1] += offsets[i]; }
+    succ.resize(deps.size());
+    // deps are sorted by source, the successors of every task come out in order
+    for (size_t i{}; i < deps.size(); i++) { succ[i] = deps[i].second; }
+  }
+
+  [[nodiscard]] uint32_t size() const noexcept { return static_cast<uint32_t>(groups.size()); }
+
+  //! First op of @param task and one past its last, ops are indexed like graph.expressions
+  [[nodiscard]] std::pair<uint32_t, uint32_t> ops(uint32_t task) const noexcept {
+    return { starts[task], starts[task + 1] };
+  }
+
+  [[nodiscard]] std::span<const uint32_t> successors(uint32_t task) const noexcept {
+    return std::span(succ).subspan(offsets[task], offsets[task + 1] - offsets[task]);
+  }
+
+  //! Number of tasks @param task waits for
+  [[nodiscard]] uint32_t dependencies(uint32_t task) const noexcept { return in_degree[task]; }
+
+  //! Group of the ops of @param task, NONE when they are free
+  [[nodiscard]] uint32_t group(uint32_t task) const noexcept { return groups[task]; }
+
+private:
+  //! Last writer and readers since of every byte range touched so far, split on demand at access boundaries
+  class Accesses {
+  public:
+    void touch(uintptr_t begin,
+      uintptr_t end,
+      uint32_t task,
+      bool write,
+      std::vector<std::pair<uint32_t, uint32_t>> &deps) {
+      split(begin);
+      split(end);
+      auto iterator = segments.lower_bound(begin);
+      for (uintptr_t pos = begin; pos < end; ++iterator) {
+        if (iterator == segments.end() || iterator->first > pos) {
+          const uintptr_t gap_end = iterator == segments.end() ? end : std::min(end, iterator->first);
+          iterator                = segments.emplace_hint(iterator, pos, Segment{ gap_end, NONE, {} });
+        }
+        Segment &seg = iterator->second;
+        if (seg.writer != NONE && seg.writer != task) { deps.emplace_back(seg.writer, task); }
+        if (write) {
+          for (const uint32_t reader : seg.readers) {
+            if (reader != task) { deps.emplace_back(reader, task); }
+          }
+          seg.writer = task;
+          seg.readers.clear();
+        } else if (seg.readers.empty() || seg.readers.back() != task) {
+          seg.readers.push_back(task);
+        }
+        pos = seg.end;
+      }
+    }
+
+  private:
+    struct Segment {
+      uintptr_t end;
+      uint32_t writer;
+      std::vector<uint32_t> readers;
+    };
+
+    void split(uintptr_t at) {
+      auto iterator = segments.upper_bound(at);
+      if (iterator == segments.begin()) { return; }
+      --iterator;
+      if (iterator->first < at && at < iterator->second.end) {
+        Segment tail         = iterator->second;
+        iterator->second.end = at;
+        segments.emplace_hint(std::next(iterator), at, std::move(tail));
+      }
+    }
+
+    std::map<uintptr_t, Segment> segments;
+  };
+
+  std::vector<uint32_t> starts;
+  std::vector<uint32_t> groups;
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> succ;
+  std::vector<uint32_t> in_degree;
+};
+}  // namespace scions::cpu
@@ -0,0 +1,231 @@
+#pragma once
+#include "cpu_graph.hpp"
+#include "numa.hpp"
+#include "op_recorder.hpp"
+#include "scions/common/common.hpp"
+#include "task_graph.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+//! Parallel executor of lowered graphs. Tasks (see TaskGraph) start as soon as every task they wait for is done.
+//! The worker finishing a task keeps going with one of the tasks it made ready, preferably one of the same group,
+//! so chains and groups stay on a core while their data is hot, the other ready tasks go to the shared ready queues.
+//!
+//!     scions::cpu::ThreadPool pool(4);
+//!     graph.run(pool);
+//!
+//! A pool built over a NumaTopology pins its workers node by node and keeps a ready queue per node : given a
+//! NumaPlacement, workers run the tasks of their node first and only take others when it has none ready.
+//!
+//! Given an OpRecorder, every op is reported from the worker running it, so several threads call the recorder at
+//! once : TraceRecorder keeps a buffer per thread, OpProfiler isn't made for it.
+
+namespace scions::cpu {
+class ThreadPool {
+public:
+  //! @param threads : workers running tasks, the thread calling run() counts as one of them
+  [[nodiscard]] explicit ThreadPool(size_t threads = std::max(1U, std::thread::hardware_concurrency())) : ready(1) {
+    workers.reserve(std::max<size_t>(threads, 1) - 1);
+    for (size_t i = 1; i < threads; i++) { workers.emplace_back([this] { workerLoop(0); }); }
+  }
+
+  //! @param threads workers (the calling thread included, it is never pinned) spread round robin over the nodes of
+  //! @param topology, each pinned to the cpus of its node. Every cpu of the machine by default.
+  [[nodiscard]] explicit ThreadPool(const NumaTopology &topology, size_t threads = 0) : ready(topology.size()) {
+    if (topology.nodes.empty()) {
+      throw std::invalid_argument("Scions CPU: thread pool over a topology without nodes");
+    }
+    if (threads == 0) {
+      for (const NumaNode &node : topology.nodes) { threads += node.cpus.size(); }
+    }
+    workers.reserve(std::max<size_t>(threads, 1) - 1);
+    for (size_t i = 1; i < threads; i++) {
+      const auto node = static_cast<uint32_t>(i % topology.size());
+      workers.emplace_back([this, node, cpus = topology.nodes[node]] {
+        pinThread(cpus);
+        workerLoop(node);
+      });
+    }
+  }
+
+  ThreadPool(const ThreadPool &)            = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  ~ThreadPool() {
+    {
+      const std::scoped_lock lock(mutex);
+      stop = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers) { worker.join(); }
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return workers.size() + 1; }
+
+  //! Runs every instruction of @param plan following @param tasks, both lowered from the same graph. Returns once
+  //! the whole graph ran, a pool runs a single graph at a time.
+  //! @param placement : node of every task, see NumaPlacement. Ignored by pools not built over a NumaTopology.
+  void run(const CpuGraph &plan, const TaskGraph &tasks, const NumaPlacement *placement = nullptr) {
+    execute(plan, tasks, placement, {});
+  }
+
+  //! run() reporting every op to @param recorder (TraceRecorder) from the worker running it, see the top of the file.
+  //! Op indices are the ones of the CpuGraph stream, endRun() is called once the whole graph ran.
+  void run(const CpuGraph &plan,
+    const TaskGraph &tasks,
+    OpRecorder auto &recorder,
+    const NumaPlacement *placement = nullptr) {
+    using R = std::remove_reference_t<decltype(recorder)>;
+    execute(plan,
+      tasks,
+      placement,
+      RecorderRef{ &recorder,
+        [](void *rec) { static_cast<R *>(rec)->begin(); },
+        [](void *rec, size_t idx) { static_cast<R *>(rec)->end(idx); } });
+    recorder.endRun();
+  }
+
+private:
+  //! OpRecorder of the graph being run, type erased so the workers don't depend on its type
+  struct RecorderRef {
+    void *self{};
+    void (*begin)(void *){};
+    void (*end)(void *, size_t){};
+  };
+
+  void execute(const CpuGraph &plan, const TaskGraph &tasks, const NumaPlacement *placement, RecorderRef rec) {
+    const std::scoped_lock run_lock(run_mutex);
+    if (tasks.size() == 0) { return; }
+
+    pending = std::make_unique<std::atomic<uint32_t>[]>(tasks.size());
+    {
+      const std::scoped_lock lock(mutex);
+      instructions = plan.stream();
+      graph        = &tasks;
+      task_nodes   = placement;
+      recorder     = rec;
+      remaining.store(tasks.size(), std::memory_order_relaxed);
+      for (uint32_t i{}; i < tasks.size(); i++) {
+        pending[i].store(tasks.dependencies(i), std::memory_order_relaxed);
+        if (tasks.dependencies(i) == 0) { push(i); }
+      }
+    }
+    wake.notify_all();
+
+    // the calling thread isn't pinned, it takes from any node
+    std::unique_lock lock(mutex);
+    while (true) {
+      wake.wait(lock, [this] { return ready_count != 0 || remaining.load(std::memory_order_acquire) == 0; });
+      if (ready_count == 0) { break; }
+      const uint32_t task = pop(0);
+      lock.unlock();
+      drain(task);
+      lock.lock();
+    }
+  }
+
+  void workerLoop(uint32_t node) {
+    std::unique_lock lock(mutex);
+    while (true) {
+      wake.wait(lock, [this] { return stop || ready_count != 0; });
+      if (stop) { return; }
+      const uint32_t task = pop(node);
+      lock.unlock();
+      drain(task);
+      lock.lock();
+    }
+  }
+
+  //! Node queue of @param task, the first one without a placement
+  [[nodiscard]] size_t queueOf(uint32_t task) const noexcept {
+    return task_nodes == nullptr ? 0 : task_nodes->node(task) % ready.size();
+  }
+
+  //! Queues a ready task, with @ref mutex held
+  void push(uint32_t task) {
+    ready[queueOf(task)].push_back(task);
+    ready_count++;
+  }
+
+  //! Oldest ready task of @param node, or of the next node having one, with @ref mutex held and a task ready
+  uint32_t pop(uint32_t node) {
+    for (size_t i{}; i < ready.size(); i++) {
+      auto &queue = ready[(node + i) % ready.size()];
+      if (queue.empty()) { continue; }
+      const uint32_t task = queue.front();
+      queue.pop_front();
+      ready_count--;
+      return task;
+    }
+    throw std::logic_error("Scions CPU: no ready task to run");
+  }
+
+  //! Runs @param task, then the ready successor it picks, until a task makes nothing ready
+  void drain(uint32_t task) {
+    thread_local std::vector<uint32_t> released;
+    while (task != TaskGraph::NONE) {
+      const auto [first, last] = graph->ops(task);
+      if (recorder.self == nullptr) {
+        for (uint32_t i = first; i < last; i++) { instructions[i].kernel(instructions[i]); }
+      } else {
+        for (uint32_t i = first; i < last; i++) {
+          recorder.begin(recorder.self);
+          instructions[i].kernel(instructions[i]);
+          recorder.end(recorder.self, i);
+        }
+      }
+
+      released.clear();
+      for (const uint32_t next : graph->successors(task)) {
+        if (pending[next].fetch_sub(1, std::memory_order_acq_rel) == 1) { released.push_back(next); }
+      }
+
+      uint32_t next = TaskGraph::NONE;
+      if (!released.empty()) {
+        const auto same = std::ranges::find_if(released, [&](const uint32_t candidate) {
+          return graph->group(task) != TaskGraph::NONE && graph->group(candidate) == graph->group(task);
+        });
+        // then a task of the node of this one, its data is local
+        const auto local = std::ranges::find_if(
+          released, [&](const uint32_t candidate) { return queueOf(candidate) == queueOf(task); });
+        next = same != released.end() ? *same : local != released.end() ? *local : released.front();
+        if (released.size() > 1) {
+          {
+            const std::scoped_lock lock(mutex);
+            for (const uint32_t other : released) {
+              if (other != next) { push(other); }
+            }
+          }
+          wake.notify_all();
+        }
+      }
+
+      if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        const std::scoped_lock lock(mutex);
+        wake.notify_all();
+      }
+      task = next;
+    }
+  }
+
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake;
+  //! ready tasks, a queue per node
+  std::vector<std::deque<uint32_t>> ready;
+  size_t ready_count{};
+  bool stop{};
+
+  //! state of the graph being run
+  std::mutex run_mutex;
+  std::span<const Instruction> instructions;
+  const TaskGraph *graph{};
+  const NumaPlacement *task_nodes{};
+  RecorderRef recorder;
+  std::unique_ptr<std::atomic<uint32_t>[]> pending;
+  std::atomic<uint32_t> remaining;
+};
+}  // namespace scions::cpu
@@ -0,0 +1,153 @@
+#pragma once
+#include "cpu_graph.hpp"
+#include "manifold/constants.hpp"
+#include "manifold/dag_node.hpp"
+#include "manifold/op_type.hpp"
+#include "scions/common/common.hpp"
+#include "tuning_table.hpp"
+#include <map>
+
+//! Cache tiled execution of a lowered graph. Runs of consecutive element wise ops over tensors of the same extent
+//! (segments) are run tile by tile : every op of the segment runs on the first tile, then every op on the second
+//! one ... so the intermediates of a tile are still in cache when the next op reads them instead of every op
+//! streaming its whole tensor through DRAM.
+//!
+//!     scions::cpu::TileSchedule tiles(compact, ptrs);
+//!     tiles.run(plan);
+//!
+//! Tiles are whole rows (innermost dimension of the tensor shape) when a row fits, they are sized so the tile of
+//! every buffer the segment touches fits in SCIONS_CPU_TILE_BYTES. Segments already fitting run untiled.
+//!
+//! Note: A segment stops at an op whose buffers partially overlap a buffer of the segment. Element wise ops only
+//!       stay correct tile by tile when buffers are either shared exactly (in place) or disjoint.
+
+namespace scions::cpu {
+//! Ops [first, last) of the stream run @ref tile elements at a time, once over all @ref size elements if tile is 0
+struct TileSegment {
+  uint32_t first;
+  uint32_t last;
+  size_t size;
+  size_t tile;
+};
+
+class TileSchedule {
+public:
+  //! @param graph : manifold::CompactStaticGraph or CompactRuntimeGraph, lowered with the same @param ptrs
+  //! @param cache_bytes : bytes the tiles of a segment may take, about the L2 left to a single core
+  template<typename Graph>
+  [[nodiscard]] TileSchedule(const Graph &graph,
+    std::span<void *const> ptrs,
+    size_t cache_bytes = SCIONS_CPU_TILE_BYTES) {
+    if (ptrs.size() != graph.data.size()) {
+      throw std::invalid_argument(
+        std::format("Scions CPU: {} tensor addresses for a graph of {} tensors", ptrs.size(), graph.data.size()));
+    }
+
+    const auto &exprs = graph.expressions;
+    elem_bytes.reserve(exprs.size());
+    Buffers buffers;
+    std::vector<std::pair<uintptr_t, uintptr_t>> op_buffers;
+    for (uint32_t i{}; i < exprs.size(); i++) {
+      const auto &exp   = exprs[i];
+      const size_t size = graph.data[exp.output_indices[0]].size;
+      elem_bytes.push_back(manifold::DTYPE_SIZES[static_cast<uint8_t>(exp.data_type)]);
+
+      op_buffers.clear();
+      bool tileable  = tileableOp(exp.type);
+      const auto add = [&](const uint32_t tensor) {
+        const auto &ten  = graph.data[tensor];
+        const auto begin = reinterpret_cast<uintptr_t>(ptrs[tensor]);
+        tileable &= ten.size == size;
+        op_buffers.emplace_back(begin, begin + ten.size * elem_bytes.back());
+      };
+      for (size_t j{}; j < exp.inp_size; j++) { add(exp.input_indices[j]); }
+      for (size_t j{}; j < exp.out_size; j++) { add(exp.output_indices[j]); }
+
+      const bool joins = tileable && !segs.empty() && segs.back().tile != 0 && segs.back().size == size
+                         && std::ranges::all_of(op_buffers, [&](const auto &buf) { return consistent(buffers, buf); });
+      if (!joins) {
+        if (!segs.empty()) { finish(graph, buffers, cache_bytes); }
+        buffers.clear();
+        // a tile of 1 marks a segment open to more element wise ops, finish() picks the real tile
+        segs.push_back(TileSegment{ i, i, size, tileable ? 1U : 0U });
+      }
+      segs.back().last = i + 1;
+      buffers.insert(op_buffers.begin(), op_buffers.end());
+    }
+    if (!segs.empty()) { finish(graph, buffers, cache_bytes); }
+  }
+
+  [[nodiscard]] std::span<const TileSegment> segments() const noexcept { return segs; }
+
+  //! Runs every instruction of @param plan, lowered from the same graph, segment by segment
+  void run(const CpuGraph &plan) const {
+    const auto stream = plan.stream();
+    for (const TileSegment &seg : segs) {
+      if (seg.tile == 0) {
+        for (uint32_t i = seg.first; i < seg.last; i++) { stream[i].kernel(stream[i]); }
+        continue;
+      }
+      for (size_t begin{}; begin < seg.size; begin += seg.tile) {
+        const size_t count = std::min(seg.tile, seg.size - begin);
+        for (uint32_t i = seg.first; i < seg.last; i++) {
+          Instruction ins    = stream[i];
+          const size_t shift = begin * elem_bytes[i];
+          ins.size           = count;
+          for (uint32_t j{}; j < ins.num_outputs; j++) { ins.out[j] = static_cast<std::byte *>(ins.out[j]) + shift; }
+          for (uint32_t j{}; j < ins.num_inputs; j++) { ins.in[j] = static_cast<std::byte *>(ins.in[j]) + shift; }
+          ins.kernel(ins);
+        }
+      }
+    }
+  }
+
+private:
+  //! [begin, end) byte range of every buffer of the open segment, keyed by begin
+  using Buffers = std::map<uintptr_t, uintptr_t>;
+
+  //! The i-th output element of these ops only depends on the i-th element of their inputs (or on nothing)
+  static constexpr bool tileableOp(const manifold::OpType type) {
+    return manifold::isElementWise(type) || type == manifold::OpType::ELM_FILL;
+  }
+
+  //! True if @param buf is one of @param buffers or disjoint from all of them
+  static bool consistent(const Buffers &buffers, const std::pair<uintptr_t, uintptr_t> &buf) {
+    const auto next = buffers.upper_bound(buf.first);
+    if (next != buffers.end() && next->first < buf.second) { return false; }
+    if (next == buffers.begin()) { return true; }
+    const auto &prev = *std::prev(next);
+    return prev.first == buf.first ? prev.second == buf.second : prev.second <= buf.first;
+  }
+
+  //! Picks the tile of the last segment from the @param buffers it touches and the shape of its first output
+  template<typename Graph>
+  void finish(const Graph &graph, const Buffers &buffers, size_t cache_bytes) {
+    TileSegment &seg = segs.back();
+    if (seg.tile == 0) { return; }
+
+    size_t bytes{};
+    for (const auto &[begin, end] : buffers) { bytes += end - begin; }
+    if (seg.last - seg.first < 2 || bytes <= cache_bytes) {
+      seg.tile = 0;
+      return;
+    }
+
+    // every buffer has seg.size elements, a tile of n elements takes n * per_element bytes over all of them
+    const auto &ten          = graph.data[graph.expressions[seg.first].output_indices[0]];
+    const size_t per_element = std::max<size_t>(bytes / seg.size, 1);
+    const size_t elements    = std::max<size_t>(cache_bytes / per_element, 1);
+    const size_t row         = ten.shape.rank == 0 ? 1 : ten.shape.shape[ten.shape.rank - 1];
+    if (row <= elements) {
+      seg.tile = elements / row * row;
+    } else {
+      // a row doesn't fit, cut it at MANIFOLD_TENSOR_ALIGN boundaries
+      const size_t align = manifold::_internal::alignElements(ten.data_type);
+      seg.tile           = std::max(elements / align * align, align);
+    }
+    if (seg.tile >= seg.size) { seg.tile = 0; }
+  }
+
+  std::vector<TileSegment> segs;
+  std::vector<size_t> elem_bytes;
+};
+}  // namespace scions::cpu
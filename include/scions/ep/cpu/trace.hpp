@@ -0,0 +1,175 @@
+#pragma once
+#include "manifold/op_type.hpp"
+#include "manifold/utility.hpp"
+#include "op_recorder.hpp"
+#include "scions/common/common.hpp"
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <mutex>
+
+//! Timeline of graph executions in the Chrome Trace Event format, open the dump in chrome://tracing or
+//! https://ui.perfetto.dev to see idle gaps, the critical path and load imbalance between workers.
+//!
+//!     scions::cpu::TraceRecorder trace(compact);
+//!     scions::cpu::exec_cpu_graph<compact>(store, trace);
+//!     trace.writeChromeTrace("graph.json");
+//!
+//! Every thread reporting ops gets its own ring buffer on first use, only that thread ever writes it so recording
+//! takes no lock. When a buffer is full the oldest events are overwritten.
+
+namespace scions::cpu {
+//! A single op execution, times in ns since the recorder was created
+struct TraceEvent {
+  uint64_t begin;
+  uint64_t end;
+  uint32_t op;
+};
+
+namespace _internal {
+  //! Single writer ring of TraceEvent, @ref head only grows and is published with release so a reader (after the
+  //! run) sees every event it counts
+  struct TraceRing {
+    explicit TraceRing(const size_t capacity, const uint32_t thread) : events(std::bit_ceil(capacity)), tid(thread) {}
+
+    void push(const TraceEvent &event) noexcept {
+      const uint64_t pos                = head.load(std::memory_order_relaxed);
+      events[pos & (events.size() - 1)] = event;
+      head.store(pos + 1, std::memory_order_release);
+    }
+
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> head{};
+    uint64_t open{};
+    uint32_t tid;
+  };
+
+  inline std::atomic<uint64_t> trace_recorder_ids{};
+}  // namespace _internal
+
+class TraceRecorder {
+public:
+  //! @param graph : compact graph (manifold::CompactStaticGraph or CompactRuntimeGraph) whose ops are recorded,
+  //!                names and tensor ids of the events come from it
+  //! @param capacity : events kept per thread, rounded up to a power of two
+  template<typename Graph>
+  [[nodiscard]] explicit TraceRecorder(const Graph &graph, size_t capacity = 1 << 16)
+    : ring_capacity(std::max<size_t>(capacity, 1)), origin(std::chrono::steady_clock::now()) {
+    ops.reserve(graph.expressions.size());
+    for (const auto &exp : graph.expressions) {
+      std::string args =
+        std::format(R"("id":{},"dtype":"{}","inputs":[)", exp.id, manifold::dtypeToString(exp.data_type));
+      for (size_t j{}; j < exp.inp_size; j++) {
+        args += std::format("{}{}", j == 0 ? "" : ",", graph.data[exp.input_indices[j]].id);
+      }
+      args += R"(],"outputs":[)";
+      for (size_t j{}; j < exp.out_size; j++) {
+        args += std::format("{}{}", j == 0 ? "" : ",", graph.data[exp.output_indices[j]].id);
+      }
+      args += ']';
+      ops.push_back({ manifold::optypeToString(exp.type), std::move(args) });
+    }
+  }
+
+  TraceRecorder(const TraceRecorder &)            = delete;
+  TraceRecorder &operator=(const TraceRecorder &) = delete;
+
+  void begin() {
+    auto &ring = localRing();
+    ring.open  = now();
+  }
+
+  void end(size_t idx) {
+    auto &ring = localRing();
+    ring.push({ ring.open, now(), static_cast<uint32_t>(idx) });
+  }
+
+  void endRun() noexcept {}
+
+  //! Events of every thread, only complete once the recorded runs returned
+  [[nodiscard]] std::vector<std::pair<uint32_t, std::vector<TraceEvent>>> events() const {
+    const std::scoped_lock lock(rings_mutex);
+    std::vector<std::pair<uint32_t, std::vector<TraceEvent>>> out;
+    for (const auto &ring : rings) {
+      const uint64_t head  = ring.head.load(std::memory_order_acquire);
+      const uint64_t count = std::min<uint64_t>(head, ring.events.size());
+      std::vector<TraceEvent> thread_events;
+      thread_events.reserve(count);
+      for (uint64_t pos = head - count; pos < head; pos++) {
+        thread_events.push_back(ring.events[pos & (ring.events.size() - 1)]);
+      }
+      out.emplace_back(ring.tid, std::move(thread_events));
+    }
+    return out;
+  }
+
+  //! Chrome Trace Event JSON, one complete ("X") event per op execution and a named track per thread
+  [[nodiscard]] std::string chromeTrace() const {
+    std::string out = R"({"displayTimeUnit":"ns","traceEvents":[)";
+    bool first      = true;
+    for (const auto &[tid, thread_events] : events()) {
+      out += std::format(R"({}{{"ph":"M","pid":0,"tid":{},"name":"thread_name","args":{{"name":"worker {}"}}}})",
+        first ? "" : ",",
+        tid,
+        tid);
+      first = false;
+      for (const TraceEvent &event : thread_events) {
+        const auto &op = ops.at(event.op);
+        out += std::format(
+          R"(,{{"ph":"X","pid":0,"tid":{},"name":"{}","cat":"op","ts":{:.3f},"dur":{:.3f},"args":{{"op":{},{}}}}})",
+          tid,
+          op.name,
+          static_cast<double>(event.begin) / 1000.0,
+          static_cast<double>(event.end - event.begin) / 1000.0,
+          event.op,
+          op.args);
+      }
+    }
+    out += "]}\n";
+    return out;
+  }
+
+  void writeChromeTrace(const std::string &path) const {
+    std::ofstream file(path);
+    if (!file) { throw std::runtime_error(std::format("Scions CPU: can't open {} for the trace", path)); }
+    file << chromeTrace();
+  }
+
+private:
+  struct OpInfo {
+    std::string_view name;
+    std::string args;
+  };
+
+  [[nodiscard]] uint64_t now() const noexcept {
+    return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count());
+  }
+
+  //! Ring of the calling thread, only the first call of a thread on this recorder takes the lock. Recorder ids are
+  //! never reused so entries of destroyed recorders can't be hit again.
+  _internal::TraceRing &localRing() {
+    thread_local std::vector<std::pair<uint64_t, _internal::TraceRing *>> owned;
+    if (!owned.empty() && owned.back().first == uid) { return *owned.back().second; }
+
+    const auto iterator = std::ranges::find(owned, uid, &std::pair<uint64_t, _internal::TraceRing *>::first);
+    if (iterator != owned.end()) {
+      std::iter_swap(iterator, owned.end() - 1);
+    } else {
+      const std::scoped_lock lock(rings_mutex);
+      owned.emplace_back(uid, &rings.emplace_back(ring_capacity, static_cast<uint32_t>(rings.size())));
+    }
+    return *owned.back().second;
+  }
+
+  std::vector<OpInfo> ops;
+  //! deque keeps the rings in place while other threads register theirs
+  std::deque<_internal::TraceRing> rings;
+  mutable std::mutex rings_mutex;
+  size_t ring_capacity;
+  uint64_t uid{ _internal::trace_recorder_ids.fetch_add(1, std::memory_order_relaxed) };
+  std::chrono::steady_clock::time_point origin;
+};
+}  // namespace scions::cpu
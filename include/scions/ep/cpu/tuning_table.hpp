@@ -0,0 +1,110 @@
+#pragma once
+#include "manifold/constants.hpp"
+#include "manifold/op_type.hpp"
+#include "scions/common/common.hpp"
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <thread>
+
+//! Default cache budget of a TileSchedule segment, about the L2 left to a single core
+#ifndef SCIONS_CPU_TILE_BYTES
+#define SCIONS_CPU_TILE_BYTES (256 * 1024)
+#endif
+
+//! Per machine kernel configuration picked by the autotuner (see autotune.hpp) and loaded by the CPU EP at startup.
+//!
+//!     const auto table = scions::cpu::TuningTable::load("machine.tune");
+//!     scions::cpu::RuntimeCpuGraph graph(compact, table);
+//!     scions::cpu::ThreadPool pool(table.threads);
+//!
+//! The file is plain text, a version line then one setting per line :
+//!
+//!     scions-tuning 1
+//!     tile_bytes 262144
+//!     threads 4
+//!     chunk <op type> <dtype> <inputs> <elements> <chunk>
+
+namespace scions::cpu {
+inline constexpr uint32_t TUNING_FILE_VERSION = 1;
+
+//! Ops that get their own tuned configuration, shapes only matter through their element count
+struct TuneKey {
+  manifold::OpType type;
+  manifold::DType data_type;
+  uint32_t inputs;
+  size_t size;
+
+  auto operator<=>(const TuneKey &) const = default;
+};
+
+//! Chunk sizes (elements) many to one element wise kernels can fold their inputs by, 0 is the element by element loop
+inline constexpr std::array<uint32_t, 4> TUNE_CHUNKS{ 0, 64, 256, 1024 };
+
+struct TuningTable {
+  //! chunk of every tuned many to one op, ops missing here use the element by element loop
+  std::map<TuneKey, uint32_t> chunks;
+  //! cache budget of TileSchedule
+  size_t tile_bytes = SCIONS_CPU_TILE_BYTES;
+  //! workers of the ThreadPool running the graph, see RuntimeCpuGraph::threads
+  size_t threads = std::max(1U, std::thread::hardware_concurrency());
+
+  [[nodiscard]] uint32_t chunk(const TuneKey &key) const {
+    const auto iterator = chunks.find(key);
+    return iterator == chunks.end() ? 0 : iterator->second;
+  }
+
+  void save(const std::filesystem::path &path) const {
+    std::ofstream file(path, std::ios::trunc);
+    file << "scions-tuning " << TUNING_FILE_VERSION << '\n';
+    file << "tile_bytes " << tile_bytes << '\n';
+    file << "threads " << threads << '\n';
+    for (const auto &[key, value] : chunks) {
+      file << "chunk " << static_cast<uint32_t>(key.type) << ' ' << static_cast<uint32_t>(key.data_type) << ' '
+           << key.inputs << ' ' << key.size << ' ' << value << '\n';
+    }
+    if (!file) {
+      throw std::runtime_error(std::format("Scions CPU: couldn't write the tuning file {}", path.string()));
+    }
+  }
+
+  //! Throws std::runtime_error if @param path isn't a tuning file of this version
+  [[nodiscard]] static TuningTable load(const std::filesystem::path &path) {
+    std::ifstream file(path);
+    const auto fail = [&] {
+      throw std::runtime_error(
+        std::format("Scions CPU: {} is not a version {} tuning file", path.string(), TUNING_FILE_VERSION));
+    };
+    std::string word;
+    uint32_t version{};
+    if (!(file >> word >> version) || word != "scions-tuning" || version != TUNING_FILE_VERSION) { fail(); }
+
+    TuningTable table;
+    while (file >> word) {
+      if (word == "tile_bytes") {
+        file >> table.tile_bytes;
+      } else if (word == "threads") {
+        file >> table.threads;
+      } else if (word == "chunk") {
+        uint32_t type{};
+        uint32_t data_type{};
+        TuneKey key{};
+        uint32_t value{};
+        file >> type >> data_type >> key.inputs >> key.size >> value;
+        if (type > static_cast<uint32_t>(manifold::OpType::BRUH) || data_type >= manifold::NUM_DTYPE
+            || std::ranges::find(TUNE_CHUNKS, value) == TUNE_CHUNKS.end()) {
+          fail();
+        }
+        key.type          = static_cast<manifold::OpType>(type);
+        key.data_type     = static_cast<manifold::DType>(data_type);
+        table.chunks[key] = value;
+      } else {
+        fail();
+      }
+      if (!file) { fail(); }
+    }
+    if (table.tile_bytes == 0 || table.threads == 0) { fail(); }
+    return table;
+  }
+};
+}  // namespace scions::cpu
@@ -0,0 +1,217 @@
+#pragma once
+#include "manifold/constants.hpp"
+#include "manifold/tensor.hpp"
+#include "scions/common/common.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//! Weight files : constant tensors stored so they can be used straight from a memory mapping. Binding a mapped
+//! tensor (RuntimeCpuGraph, CpuMemStore::bindWeights) points the graph at the mapping instead of copying the data
+//! into the arena, startup is bounded by page in and the weights are only resident once.
+//!
+//!     scions::cpu::writeWeightFile("model.scw", blobs);
+//!     const scions::cpu::MappedWeights weights("model.scw", { .populate = true });
+//!     scions::cpu::RuntimeCpuGraph graph(compact, weights);
+//!
+//! Layout (native byte order) : a WeightFileHeader, WeightEntry table sorted by tensor id, then the data of every
+//! tensor at a WEIGHT_FILE_ALIGN aligned offset.
+
+namespace scions::cpu {
+//! Alignment of the tensor data in the file, a page so every mapped tensor is page aligned
+inline constexpr size_t WEIGHT_FILE_ALIGN    = 4096;
+inline constexpr uint32_t WEIGHT_FILE_VERSION = 1;
+inline constexpr std::array<char, 4> WEIGHT_FILE_MAGIC{ 'S', 'C', 'W', 'T' };
+
+struct WeightFileHeader {
+  std::array<char, 4> magic;
+  uint32_t version;
+  uint64_t count;
+};
+
+//! A tensor of the file, @ref offset is from the start of the file
+struct WeightEntry {
+  uint32_t id;
+  manifold::DType data_type;
+  std::array<uint8_t, 3> reserved;
+  uint64_t offset;
+  uint64_t bytes;
+};
+static_assert(sizeof(WeightFileHeader) == 16 && sizeof(WeightEntry) == 24, "Scions CPU: weight file layout changed");
+
+//! Data of the tensor with id @ref id, input of writeWeightFile
+struct WeightBlob {
+  uint32_t id;
+  manifold::DType data_type;
+  std::span<const std::byte> bytes;
+};
+
+//! Writes @param blobs (unique ids) as a weight file at @param path
+inline void writeWeightFile(const std::filesystem::path &path, std::span<const WeightBlob> blobs) {
+  std::vector<WeightBlob> sorted(blobs.begin(), blobs.end());
+  std::ranges::sort(sorted, {}, &WeightBlob::id);
+  if (std::ranges::adjacent_find(sorted, {}, &WeightBlob::id) != sorted.end()) {
+    throw std::invalid_argument("Scions CPU: weight file with a tensor id used more than once");
+  }
+
+  const auto align = [](const uint64_t pos) {
+    return (pos + WEIGHT_FILE_ALIGN - 1) / WEIGHT_FILE_ALIGN * WEIGHT_FILE_ALIGN;
+  };
+  std::vector<WeightEntry> entries;
+  entries.reserve(sorted.size());
+  uint64_t pos = sizeof(WeightFileHeader) + sorted.size() * sizeof(WeightEntry);
+  for (const WeightBlob &blob : sorted) {
+    pos = align(pos);
+    entries.push_back(WeightEntry{ blob.id, blob.data_type, {}, pos, blob.bytes.size() });
+    pos += blob.bytes.size();
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  const WeightFileHeader header{ WEIGHT_FILE_MAGIC, WEIGHT_FILE_VERSION, sorted.size() };
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(entries.data()),
+    static_cast<std::streamsize>(entries.size() * sizeof(WeightEntry)));
+  for (size_t i{}; i < sorted.size(); i++) {
+    const std::vector<char> padding(entries[i].offset - static_cast<uint64_t>(file.tellp()));
+    file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+    file.write(
+      reinterpret_cast<const char *>(sorted[i].bytes.data()), static_cast<std::streamsize>(sorted[i].bytes.size()));
+  }
+  if (!file) { throw std::runtime_error(std::format("Scions CPU: couldn't write the weight file {}", path.string())); }
+}
+
+//! How the mapping of a weight file is paged in
+enum class WeightAdvice : uint8_t {
+  //! kernel default
+  NORMAL,
+  //! tensors are read front to back, aggressive read ahead
+  SEQUENTIAL,
+  //! start reading the whole file in the background
+  WILL_NEED,
+};
+
+struct WeightMapOptions {
+  //! read the whole file in while mapping it (MAP_POPULATE, linux only), no page fault when the graph runs
+  bool populate = false;
+  WeightAdvice advice = WeightAdvice::NORMAL;
+};
+
+//! Read only mapping of a weight file, tensors bound to it must not outlive it
+class MappedWeights {
+public:
+  [[nodiscard]] explicit MappedWeights(const std::filesystem::path &path, const WeightMapOptions &options = {}) {
+#if defined(__unix__) || defined(__APPLE__)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error(std::format("Scions CPU: couldn't open the weight file {}", path.string()));
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(WeightFileHeader))) {
+      ::close(fd);
+      throw std::runtime_error(std::format("Scions CPU: {} is not a weight file", path.string()));
+    }
+    length = static_cast<size_t>(info.st_size);
+
+    int flags = MAP_PRIVATE;
+#if defined(__linux__)
+    if (options.populate) { flags |= MAP_POPULATE; }
+#endif
+    void *ptr = ::mmap(nullptr, length, PROT_READ, flags, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED) {
+      throw std::runtime_error(std::format("Scions CPU: couldn't map the weight file {}", path.string()));
+    }
+    base = static_cast<const std::byte *>(ptr);
+
+    if (options.advice == WeightAdvice::SEQUENTIAL) { ::madvise(ptr, length, MADV_SEQUENTIAL); }
+    if (options.advice == WeightAdvice::WILL_NEED) { ::madvise(ptr, length, MADV_WILLNEED); }
+
+    try {
+      validate(path);
+    } catch (...) {
+      unmap();
+      throw;
+    }
+#else
+    throw std::runtime_error("Scions CPU: weight files need mmap");
+#endif
+  }
+
+  MappedWeights(const MappedWeights &)            = delete;
+  MappedWeights &operator=(const MappedWeights &) = delete;
+
+  ~MappedWeights() { unmap(); }
+
+  [[nodiscard]] std::span<const WeightEntry> entries() const noexcept { return table; }
+
+  //! Entry of the tensor with id @param id, nullptr if the file doesn't hold it
+  [[nodiscard]] const WeightEntry *find(uint32_t id) const noexcept {
+    const auto iterator = std::ranges::lower_bound(table, id, {}, &WeightEntry::id);
+    return iterator != table.end() && iterator->id == id ? &*iterator : nullptr;
+  }
+
+  [[nodiscard]] std::span<const std::byte> bytes(const WeightEntry &entry) const noexcept {
+    return { base + entry.offset, entry.bytes };
+  }
+
+  [[nodiscard]] size_t fileBytes() const noexcept { return length; }
+
+private:
+  void validate(const std::filesystem::path &path) {
+    WeightFileHeader header{};
+    std::memcpy(&header, base, sizeof(header));
+    const bool fits          = header.count <= length / sizeof(WeightEntry);
+    const uint64_t table_end = sizeof(header) + (fits ? header.count : 0) * sizeof(WeightEntry);
+    if (header.magic != WEIGHT_FILE_MAGIC || header.version != WEIGHT_FILE_VERSION || !fits || table_end > length) {
+      throw std::runtime_error(
+        std::format("Scions CPU: {} is not a version {} weight file", path.string(), WEIGHT_FILE_VERSION));
+    }
+
+    // the table starts right after the 16 bytes header of a page aligned mapping, WeightEntry is 8 bytes aligned
+    table = std::span(reinterpret_cast<const WeightEntry *>(base + sizeof(header)), header.count);
+    for (size_t i{}; i < table.size(); i++) {
+      const WeightEntry &entry = table[i];
+      const bool sorted        = i == 0 || table[i - 1].id < entry.id;
+      if (!sorted || entry.offset % WEIGHT_FILE_ALIGN != 0 || entry.offset < table_end || entry.bytes > length
+          || entry.offset > length - entry.bytes) {
+        throw std::runtime_error(std::format("Scions CPU: corrupted entry {} in the weight file {}", i, path.string()));
+      }
+    }
+  }
+
+  void unmap() noexcept {
+#if defined(__unix__) || defined(__APPLE__)
+    if (base != nullptr) { ::munmap(const_cast<std::byte *>(base), length); }
+#endif
+    base = nullptr;
+  }
+
+  const std::byte *base{};
+  size_t length{};
+  std::span<const WeightEntry> table;
+};
+
+//! Mapped data of @param ten in @param weights (looked up by tensor id), nullptr when the file doesn't hold it.
+//! Throws if the stored tensor doesn't have the dtype and size of @param ten.
+[[nodiscard]] inline const std::byte *weightData(const MappedWeights &weights, const manifold::TensorReflection &ten) {
+  const WeightEntry *entry = weights.find(ten.id);
+  if (entry == nullptr) { return nullptr; }
+  const size_t bytes = ten.size * manifold::DTYPE_SIZES[static_cast<uint8_t>(ten.data_type)];
+  if (entry->data_type != ten.data_type || entry->bytes != bytes) {
+    throw std::runtime_error(std::format("Scions CPU: weights of tensor {} are {} bytes of {}, expected {} of {}",
+      ten.id,
+      entry->bytes,
+      manifold::dtypeToString(entry->data_type),
+      bytes,
+      manifold::dtypeToString(ten.data_type)));
+  }
+  return weights.bytes(*entry).data();
+}
+}  // namespace scions::cpu
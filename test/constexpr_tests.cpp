@@ -2,6 +2,9 @@
 
 #include <Scions/sample_library.hpp>
 
+#include "manifold/ops/element_wise_ops.hpp"
+#include "manifold/static_graph.hpp"
+
 TEST_CASE("Factorials are computed with constexpr", "[factorial]")
 {
   STATIC_REQUIRE(factorial_constexpr(0) == 1);
@@ -10,3 +13,241 @@ TEST_CASE("Factorials are computed with constexpr", "[factorial]")
   STATIC_REQUIRE(factorial_constexpr(3) == 6);
   STATIC_REQUIRE(factorial_constexpr(10) == 3628800);
 }
+
+namespace {
+constexpr auto elementWiseChain()
+{
+  using namespace manifold;
+  using T = Tensor<TBase<DType::F32, 100>>;
+  const T a(0), b(1), c(2), d(3), e(4);
+
+  const auto container = SymbolContainer{ std::array{ a.reflect(), b.reflect(), c.reflect(), d.reflect(), e.reflect() },
+    std::array{ op::elm_add(10, c, std::array{ a, b }), op::exp(11, d, c), op::elm_mul(12, e, std::array{ d, a }) } };
+  return container.to_dag().topologicalSort();
+}
+
+//! 4 chains of 3 exps given layer by layer, ie. breadth first
+constexpr auto wideGraph()
+{
+  using namespace manifold;
+  using T = Tensor<TBase<DType::F32, 64>>;
+  std::array<TensorReflection, 16> tensors{};
+  std::array<ExpressionReflection, 12> exprs{};
+  for (uint32_t i{}; i < tensors.size(); i++) { tensors[i] = T(i).reflect(); }
+  for (uint32_t layer{}; layer < 3; layer++) {
+    for (uint32_t chain{}; chain < 4; chain++) {
+      exprs[layer * 4 + chain] = op::exp(100 + layer * 4 + chain, T((layer + 1) * 4 + chain), T(layer * 4 + chain));
+    }
+  }
+  return SymbolContainer{ tensors, exprs }.to_dag();
+}
+
+//! 4 chains of a = exp(in), b = exp(a), out = a + b given layer by layer, a is still read when b is computed
+constexpr auto forkGraph()
+{
+  using namespace manifold;
+  using T = Tensor<TBase<DType::F32, 64>>;
+  std::array<TensorReflection, 16> tensors{};
+  std::array<ExpressionReflection, 12> exprs{};
+  for (uint32_t i{}; i < tensors.size(); i++) { tensors[i] = T(i).reflect(); }
+  for (uint32_t chain{}; chain < 4; chain++) {
+    const T in(chain), a(4 + chain), b(8 + chain), out(12 + chain);
+    exprs[chain]     = op::exp(100 + chain, a, in);
+    exprs[4 + chain] = op::exp(104 + chain, b, a);
+    exprs[8 + chain] = op::elm_add(108 + chain, out, std::array{ a, b });
+  }
+  return SymbolContainer{ tensors, exprs }.to_dag();
+}
+}  // namespace
+
+TEST_CASE("Dead inputs of element wise ops are reused in place", "[manifold][mem_plan]")
+{
+  constexpr auto plan = manifold::planMemory(elementWiseChain());
+  STATIC_REQUIRE(plan.in_place[0] == UINT32_MAX);
+  STATIC_REQUIRE(plan.in_place[1] == 0);
+  STATIC_REQUIRE(plan.in_place[2] == 0);
+  STATIC_REQUIRE(plan.offsets[2] == plan.offsets[4]);
+  // a and b are inputs and keep their own buffers, c -> d -> e share a single one
+  STATIC_REQUIRE(plan.pool_sizes[static_cast<uint8_t>(manifold::DType::F32)] == 3 * 112);
+  // ops without a CPU kernel are never planned in place
+  STATIC_REQUIRE(manifold::isElementWise(manifold::OpType::EXPONENTIAL));
+  STATIC_REQUIRE(!manifold::isElementWise(manifold::OpType::SIN));
+}
+
+TEST_CASE("Expressions are sorted in dependency order", "[manifold][sort]")
+{
+  using namespace manifold;
+  using T = Tensor<TBase<DType::F32, 8>>;
+  // Ids don't match the tensor positions, the second chain is given between the steps of the first
+  constexpr auto sorted = [] {
+    const T a(40), b(30), c(20), d(10), e(50), f(60);
+    return SymbolContainer{ std::array{ a.reflect(), b.reflect(), c.reflect(), d.reflect(), e.reflect(), f.reflect() },
+      std::array{ op::exp(1, b, a), op::exp(4, f, e), op::exp(2, c, b), op::exp(3, d, c) } }
+      .to_dag()
+      .topologicalSort(SortOrder::LOCALITY);
+  }();
+  STATIC_REQUIRE(sorted.edges[0].id == 1);
+  STATIC_REQUIRE(sorted.edges[1].id == 2);
+  STATIC_REQUIRE(sorted.edges[2].id == 3);
+  STATIC_REQUIRE(sorted.edges[3].id == 4);
+  STATIC_REQUIRE(sorted.data[3].incoming == 2);
+}
+
+namespace {
+//! 0: x = exp(t), 1: x *= 2, 2: t = exp(a), 3: out = x + a. Op 1 updates the x of op 0, op 0 reads t before op 2
+//! overwrites it.
+template<manifold::SortOrder Order>
+constexpr bool keepsHazards()
+{
+  using namespace manifold;
+  using T = Tensor<TBase<DType::F32, 8>>;
+  const T t(0), x(1), a(2), out(3);
+  const std::array exprs{
+    op::exp(10, x, t), op::elm_mul(11, x, 2.0F), op::exp(12, t, a), op::elm_add(13, out, std::array{ x, a })
+  };
+  const auto sorted = SymbolContainer{ std::array{ t.reflect(), x.reflect(), a.reflect(), out.reflect() }, exprs }
+                        .to_dag()
+                        .topologicalSort(Order);
+  std::array<size_t, 4> pos{};
+  for (size_t i{}; i < pos.size(); i++) { pos[sorted.edges[i].id - 10] = i; }
+  return pos[0] < pos[1] && pos[0] < pos[2] && pos[1] < pos[3];
+}
+}  // namespace
+
+TEST_CASE("Sorting keeps tensors written more than once in order", "[manifold][sort]")
+{
+  using manifold::SortOrder;
+  STATIC_REQUIRE(keepsHazards<SortOrder::INDEX>());
+  STATIC_REQUIRE(keepsHazards<SortOrder::LOCALITY>());
+  STATIC_REQUIRE(keepsHazards<SortOrder::MEMORY>());
+}
+
+namespace {
+//! a is read by three ops, twice by one of them, and c is updated in place by a scalar op
+constexpr auto fanOutGraph()
+{
+  using namespace manifold;
+  using T = Tensor<TBase<DType::F32, 8>>;
+  const T a(0), b(1), c(2), d(3), e(4);
+  return SymbolContainer{ std::array{ a.reflect(), b.reflect(), c.reflect(), d.reflect(), e.reflect() },
+    std::array{ op::exp(10, b, a),
+      op::elm_add(11, c, std::array{ a, b }),
+      op::elm_mul(12, d, std::array{ a, a }),
+      op::elm_mul(13, c, 3.0F),
+      op::elm_add(14, e, std::array{ c, d, b }) } };
+}
+
+//! The fanOut table against the reader lists TensorNode used to keep, built from the expressions as given (tensor
+//! ids are their positions)
+constexpr bool fanOutMatchesLists()
+{
+  const auto graph = fanOutGraph();
+  const auto dag   = graph.to_dag();
+  std::array<std::vector<uint32_t>, 5> lists{};
+  for (uint32_t i{}; i < graph.exprs.size(); i++) {
+    for (uint32_t j{}; j < graph.exprs[i].num_inputs; j++) { lists[graph.exprs[i].inputs[j]].push_back(i); }
+  }
+
+  std::vector<uint32_t> offsets(dag.data.size() + 1);
+  std::vector<uint32_t> consumers;
+  for (const auto &ten : dag.data) { consumers.resize(consumers.size() + ten.total_out); }
+  manifold::_internal::fanOut(dag.edgeSpan(), offsets, consumers);
+  for (uint32_t i{}; i < lists.size(); i++) {
+    const auto readers = std::span<const uint32_t>(consumers).subspan(offsets[i], offsets[i + 1] - offsets[i]);
+    if (dag.data[i].total_out != lists[i].size() || !std::ranges::equal(readers, lists[i])) { return false; }
+  }
+  return true;
+}
+
+//! Every edge reads the tensors and params it was given back from the operand and param tables
+constexpr bool operandsMatchExpressions()
+{
+  const auto graph = fanOutGraph();
+  const auto dag   = graph.to_dag();
+  const auto edges = dag.edgeSpan();
+  for (uint32_t i{}; i < graph.exprs.size(); i++) {
+    const auto &exp = graph.exprs[i];
+    if (!std::ranges::equal(edges.inputs(edges[i]), std::span(exp.inputs).first(exp.num_inputs))
+        || !std::ranges::equal(edges.outputs(edges[i]), std::span(exp.outputs).first(exp.num_outputs))
+        || edges.paramsOf(edges[i]) != exp.params) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+TEST_CASE("Fan out and operands are read from the CSR tables", "[manifold][dag]")
+{
+  STATIC_REQUIRE(fanOutMatchesLists());
+  STATIC_REQUIRE(operandsMatchExpressions());
+  // only the scalar op has params, stored without their trailing zero bytes
+  constexpr auto dag = fanOutGraph().to_dag();
+  STATIC_REQUIRE(dag.edges[3].param_bytes == sizeof(float));
+  STATIC_REQUIRE(dag.edges[4].params == sizeof(float));
+  STATIC_REQUIRE(dag.edges[4].operands == 2 + 3 + 3 + 1);
+
+  // sized from the container the tables hold exactly the operands and params above
+  constexpr auto exact = fanOutGraph().to_dag<fanOutGraph().tableSizes()>();
+  STATIC_REQUIRE(exact.operands.size() == dag.edges[4].operands + 3 + 1);
+  STATIC_REQUIRE(exact.params.size() == sizeof(float));
+  STATIC_REQUIRE(std::ranges::equal(exact.operands, std::span(dag.operands).first(exact.operands.size())));
+  STATIC_REQUIRE(sizeof(exact) < sizeof(dag));
+}
+
+TEST_CASE("Cost model finds the critical path", "[manifold][cost_model]")
+{
+  // c = a + b (100 flops, 1200 bytes) then d = exp(c), e = d * a
+  constexpr auto cost = elementWiseChain().costModel(manifold::MachineModel{ 10.0, 100.0 });
+  STATIC_REQUIRE(cost.ops[0].flops == 100);
+  STATIC_REQUIRE(cost.ops[0].bytes() == 3 * 100 * sizeof(float));
+  STATIC_REQUIRE(cost.ns[0] == 120.0);
+  STATIC_REQUIRE(cost.total.flops == 300);
+  // a single chain, the critical path is the whole graph
+  STATIC_REQUIRE(cost.critical[0]);
+  STATIC_REQUIRE(cost.critical[1]);
+  STATIC_REQUIRE(cost.critical[2]);
+  STATIC_REQUIRE(cost.critical_ns == cost.work_ns);
+  STATIC_REQUIRE(!cost.machine.isComputeBound(cost.ops[1]));
+}
+
+TEST_CASE("Planned peak memory is known at compile time", "[manifold][mem_plan]")
+{
+  constexpr auto meta = manifold::graphMetadata(elementWiseChain());
+  STATIC_REQUIRE(meta.peakBytes() == 3 * 112 * sizeof(float));
+  STATIC_REQUIRE(meta.peakBytes(manifold::DType::F32) == meta.peakBytes());
+  STATIC_REQUIRE(meta.peakBytes(manifold::DType::F64) == 0);
+  STATIC_REQUIRE(meta.unplanned == 5 * 112 * sizeof(float));
+  STATIC_REQUIRE(manifold::checkMemoryBudget(meta, 2048));
+  STATIC_REQUIRE(!meta.fitsIn(1024));
+}
+
+TEST_CASE("Locality order runs consumers right after their producers", "[manifold][sort]")
+{
+  using manifold::SortOrder;
+  constexpr auto by_index    = wideGraph().topologicalSort();
+  constexpr auto by_locality = wideGraph().topologicalSort(SortOrder::LOCALITY);
+  // chain 0 runs to its end before chain 1 starts
+  STATIC_REQUIRE(by_index.edges[1].id == 101);
+  STATIC_REQUIRE(by_locality.edges[1].id == 104);
+  STATIC_REQUIRE(by_locality.edges[2].id == 108);
+  // the 8 reads of produced tensors are of the previous op, breadth first reads the op 4 positions back
+  STATIC_REQUIRE(by_locality.reuseDistance() == 8);
+  STATIC_REQUIRE(by_index.reuseDistance() == 8 * 4);
+}
+
+TEST_CASE("Memory order keeps fewer intermediates alive", "[manifold][sort][mem_plan]")
+{
+  constexpr auto schedule = forkGraph().memorySchedule();
+  constexpr auto stats    = schedule.second;
+  constexpr size_t tensor = manifold::_internal::alignedExtent(forkGraph().data[0]) * sizeof(float);
+  // breadth first has a and b of every chain alive at once, chain by chain only those of one chain
+  STATIC_REQUIRE(stats.index_peak == 8 * tensor);
+  STATIC_REQUIRE(stats.peak == 2 * tensor);
+  STATIC_REQUIRE(stats.exhaustive);
+  STATIC_REQUIRE(schedule.first.edges[1].id == 104);
+  // out reuses a in place and stays alive, the b buffer is shared by every chain
+  constexpr auto planned = manifold::graphMetadata(schedule.first).peakBytes();
+  STATIC_REQUIRE(planned == 9 * tensor);
+  STATIC_REQUIRE(manifold::graphMetadata(forkGraph().topologicalSort()).peakBytes() == 12 * tensor);
+}
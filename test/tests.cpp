@@ -3,6 +3,54 @@
 
 #include <Scions/sample_library.hpp>
 
+#include "manifold/graph_file.hpp"
+#include "manifold/ops/element_wise_ops.hpp"
+#include "manifold/ops/special_ops.hpp"
+#include "manifold/plan_cache.hpp"
+#include "manifold/runtime_graph.hpp"
+#include "manifold/static_graph.hpp"
+#include "scions/ep/cpu/autotune.hpp"
+#include "scions/ep/cpu/batch_graph.hpp"
+#include "scions/ep/cpu/cpu_mem_store.hpp"
+#include "scions/ep/cpu/exec_graph_gen.hpp"
+#include "scions/ep/cpu/numa.hpp"
+#include "scions/ep/cpu/page_provider.hpp"
+#include "scions/ep/cpu/profiler.hpp"
+#include "scions/ep/cpu/runtime_exec.hpp"
+#include "scions/ep/cpu/scalar_graph.hpp"
+#include "scions/ep/cpu/thread_pool.hpp"
+#include "scions/ep/cpu/trace.hpp"
+#include <thread>
+
+
+namespace {
+//! Gate network of examples/gates_v3.cpp : v2 = exp(v1), v3 = v2 + 1, v4 = v2 * v3
+consteval auto gatesGraph()
+{
+  using namespace manifold;
+  const auto v1 = Scalar<DType::F32>(0);
+  const auto v2 = Scalar<DType::F32>(1);
+  const auto v3 = Scalar<DType::F32>(2);
+  const auto v4 = Scalar<DType::F32>(3);
+
+  const auto copy_v2_v3 = op::copy(5, v3, v2);
+  const auto add_2      = op::elm_add(6, v3, 1.0F);
+  const auto group      = op::exp_group(7, std::array{ copy_v2_v3, add_2 }, true);
+  const auto container  = SymbolContainer{ std::array{ v1.reflect(), v2.reflect(), v3.reflect(), v4.reflect() },
+     std::array{ op::exp(4, v2, v1), group, op::elm_mul(8, v4, std::array{ v2, v3 }), add_2, copy_v2_v3 } };
+  return container.to_dag().topologicalSort();
+}
+
+constexpr auto GATES_META  = manifold::graphMetadata(gatesGraph());
+constexpr auto GATES_GRAPH = manifold::compact<GATES_META>(gatesGraph());
+
+//! Records nothing, only makes exec_cpu_graph run the ops one by one
+struct NoRecorder {
+  void begin() {}
+  void end(size_t) {}
+  void endRun() {}
+};
+}  // namespace
 
 TEST_CASE("Factorials are computed", "[factorial]")
 {
@@ -12,3 +60,628 @@ TEST_CASE("Factorials are computed", "[factorial]")
   REQUIRE(factorial(3) == 6);
   REQUIRE(factorial(10) == 3628800);
 }
+
+TEST_CASE("Runtime graphs are planned and executed", "[manifold][runtime]")
+{
+  using namespace manifold;
+  constexpr uint32_t steps = 5000;
+
+  // x_{i+1} = copy(x_i) + 1, every step pinned so the scalar op runs after its copy
+  GraphBuilder builder;
+  builder.reserve(steps + 1, 3 * steps);
+  uint32_t prev = builder.tensor(DType::F32, std::array{ 64U });
+  for (uint32_t i{}; i < steps; i++) {
+    const auto next = builder.tensor(DType::F32, std::array{ 64U });
+    const auto copy = builder.copy(next, prev);
+    const auto add  = builder.scalarOp(OpType::SCL_ELM_ADD, next, 1.0F);
+    builder.group(std::array{ copy, add }, true);
+    prev = next;
+  }
+
+  scions::cpu::RuntimeCpuGraph graph(compact(builder.toDag().topologicalSort()));
+  // every copy but the first runs in place, the pinned input plus a single buffer for the whole chain
+  REQUIRE(graph.compactGraph().meta.poolSize(DType::F32) == 2 * 64);
+  REQUIRE(graph.inputs().size() == 1);
+  REQUIRE(graph.outputs().size() == 1);
+
+  std::ranges::fill(graph.tensorSpan<float>(graph.inputs()[0]), 0.5F);
+  graph.run();
+  for (const float val : graph.tensorSpan<float>(graph.outputs()[0])) { REQUIRE(val == 0.5F + steps); }
+}
+
+TEST_CASE("Profiled runs record every op", "[scions][profiler]")
+{
+  using namespace manifold;
+  GraphBuilder builder;
+  const auto a = builder.tensor(DType::F32, std::array{ 256U });
+  const auto b = builder.tensor(DType::F32, std::array{ 256U });
+  const auto c = builder.tensor(DType::F32, std::array{ 256U });
+  builder.elementWise(OpType::ELM_ADD, b, std::array{ a, a });
+  builder.elementWise(OpType::EXPONENTIAL, c, std::array{ b });
+
+  scions::cpu::RuntimeCpuGraph graph(compact(builder.toDag().topologicalSort()));
+  scions::cpu::OpProfiler profiler(graph.compactGraph(), false);
+  for (int i{}; i < 3; i++) { graph.run(profiler); }
+
+  REQUIRE(profiler.runCount() == 3);
+  REQUIRE(profiler.ops().size() == 2);
+  for (const auto &prof : profiler.ops()) {
+    REQUIRE(prof.calls == 3);
+    REQUIRE(prof.bytes_written == 256 * sizeof(float));
+  }
+  REQUIRE(profiler.ops()[0].bytes_read == 2 * 256 * sizeof(float));
+  REQUIRE(profiler.ops()[0].flops == 256);
+  REQUIRE(profiler.sorted().front().ns >= profiler.sorted().back().ns);
+}
+
+TEST_CASE("Traces hold an event per op and thread", "[scions][trace]")
+{
+  using namespace manifold;
+  GraphBuilder builder;
+  const auto a = builder.tensor(DType::F32, std::array{ 64U });
+  const auto b = builder.tensor(DType::F32, std::array{ 64U });
+  builder.elementWise(OpType::EXPONENTIAL, b, std::array{ a });
+
+  scions::cpu::RuntimeCpuGraph graph(compact(builder.toDag().topologicalSort()));
+  // 4 events per thread, the oldest run is overwritten
+  scions::cpu::TraceRecorder trace(graph.compactGraph(), 4);
+  for (int i{}; i < 5; i++) { graph.run(trace); }
+  std::thread([&] { graph.run(trace); }).join();
+
+  const auto events = trace.events();
+  REQUIRE(events.size() == 2);
+  REQUIRE(events[0].second.size() == 4);
+  REQUIRE(events[1].second.size() == 1);
+  for (const auto &event : events[0].second) {
+    REQUIRE(event.op == 0);
+    REQUIRE(event.begin <= event.end);
+  }
+}
+
+TEST_CASE("Pool runs are traced from every worker", "[scions][trace][threads]")
+{
+  using namespace manifold;
+  // independent chains large enough that the workers take some of them from the calling thread
+  constexpr uint32_t chains = 8;
+  constexpr uint32_t steps  = 4;
+  GraphBuilder builder;
+  for (uint32_t chain{}; chain < chains; chain++) {
+    auto prev = builder.tensor(DType::F32, std::array{ 1U << 16 });
+    for (uint32_t step{}; step < steps; step++) {
+      const auto next = builder.tensor(DType::F32, std::array{ 1U << 16 });
+      builder.elementWise(OpType::EXPONENTIAL, next, std::array{ prev });
+      prev = next;
+    }
+  }
+
+  scions::cpu::RuntimeCpuGraph graph(compact(builder.toDag().topologicalSort()));
+  scions::cpu::ThreadPool pool(4);
+  scions::cpu::TraceRecorder trace(graph.compactGraph());
+  int runs{};
+  while (runs < 50 && trace.events().size() < 2) {
+    graph.run(pool, trace);
+    runs++;
+  }
+
+  const auto events = trace.events();
+  REQUIRE(events.size() > 1);
+  std::vector<uint32_t> calls(chains * steps);
+  for (const auto &[tid, thread_events] : events) {
+    for (const auto &event : thread_events) {
+      REQUIRE(event.begin <= event.end);
+      calls.at(event.op)++;
+    }
+  }
+  for (const uint32_t count : calls) { REQUIRE(count == static_cast<uint32_t>(runs)); }
+}
+
+TEST_CASE("Runtime graphs are lowered to a flat instruction stream", "[scions][runtime]")
+{
+  using namespace manifold;
+  GraphBuilder builder;
+  const auto a = builder.tensor(DType::F64, std::array{ 32U });
+  const auto b = builder.tensor(DType::F64, std::array{ 32U });
+  builder.elementWise(OpType::ELM_ADD, b, std::array{ a, a, a });
+  builder.scalarOp(OpType::SCL_ELM_MUL, b, 0.5);
+
+  scions::cpu::RuntimeCpuGraph graph(compact(builder.toDag().topologicalSort()));
+  REQUIRE(graph.cpuGraph().stream().size() == 2);
+  std::ranges::fill(graph.tensorSpan<double>(a), 2.0);
+  graph.run();
+  for (const double val : graph.tensorSpan<double>(b)) { REQUIRE(val == 3.0); }
+
+  // ops without a CPU kernel are rejected when lowering, not when running
+  GraphBuilder unsupported;
+  const auto x = unsupported.tensor(DType::F32, std::array{ 8U });
+  const auto y = unsupported.tensor(DType::F32, std::array{ 8U });
+  unsupported.elementWise(OpType::SIN, y, std::array{ x });
+  REQUIRE_THROWS_AS(scions::cpu::RuntimeCpuGraph(compact(unsupported.toDag().topologicalSort())), std::runtime_error);
+
+  // kernels run every operand over the size of output 0, smaller or narrower operands are rejected
+  GraphBuilder mismatched;
+  const auto big   = mismatched.tensor(DType::F32, std::array{ 64U });
+  const auto small = mismatched.tensor(DType::F32, std::array{ 8U });
+  const auto bytes = mismatched.tensor(DType::UINT8, std::array{ 64U });
+  REQUIRE_THROWS_AS(mismatched.fill(std::array{ big, small }, 1.0F), std::logic_error);
+  REQUIRE_THROWS_AS(mismatched.elementWise(OpType::ELM_ADD, big, std::array{ big, bytes }), std::logic_error);
+  REQUIRE_THROWS_AS(mismatched.copy(big, small), std::logic_error);
+  REQUIRE(mismatched.expressionCount() == 0);
+
+  // and by the CPU EP for graphs that didn't come from a builder
+  auto lowered = compact(builder.toDag().topologicalSort());
+  lowered.data[a].size /= 2;
+  REQUIRE_THROWS_AS(scions::cpu::RuntimeCpuGraph(lowered), std::invalid_argument);
+}
+
+TEST_CASE("Pinned groups run as single tasks on the thread pool", "[scions][runtime][parallel]")
+{
+  using namespace manifold;
+  constexpr uint32_t chains = 8;
+  constexpr uint32_t steps  = 50;
+
+  // independent chains of x_{i+1} = copy(x_i) + 1, every step a pinned group
+  GraphBuilder builder;
+  for (uint32_t c{}; c < chains; c++) {
+    uint32_t prev = builder.tensor(DType::F32, std::array{ 64U });
+    for (uint32_t i{}; i < steps; i++) {
+      const auto next = builder.tensor(DType::F32, std::array{ 64U });
+      const auto copy = builder.copy(next, prev);
+      const auto add  = builder.scalarOp(OpType::SCL_ELM_ADD, next, 1.0F);
+      builder.group(std::array{ copy, add }, true);
+      prev = next;
+    }
+  }
+
+  scions::cpu::RuntimeCpuGraph graph(compact(builder.toDag().topologicalSort()));
+  REQUIRE(graph.taskGraph().size() == chains * steps);
+  for (uint32_t task{}; task < graph.taskGraph().size(); task++) {
+    const auto [first, last] = graph.taskGraph().ops(task);
+    REQUIRE(last - first == 2);
+  }
+
+  scions::cpu::ThreadPool pool(4);
+  for (int run{}; run < 20; run++) {
+    for (const auto idx : graph.inputs()) { std::ranges::fill(graph.tensorSpan<float>(idx), 0.5F); }
+    graph.run(pool);
+    for (const auto idx : graph.outputs()) {
+      for (const float val : graph.tensorSpan<float>(idx)) { REQUIRE(val == 0.5F + steps); }
+    }
+  }
+}
+
+TEST_CASE("Element wise segments run tile by tile", "[scions][runtime][tiling]")
+{
+  using namespace manifold;
+  // m, s and e share a buffer in place, x and that buffer (200 KB each) don't fit in SCIONS_CPU_TILE_BYTES
+  const std::array shape{ 512U, 100U };
+  GraphBuilder builder;
+  const auto x = builder.tensor(DType::F32, shape);
+  const auto m = builder.tensor(DType::F32, shape);
+  const auto s = builder.tensor(DType::F32, shape);
+  const auto e = builder.tensor(DType::F32, shape);
+  builder.elementWise(OpType::ELM_MUL, m, std::array{ x, x });
+  builder.elementWise(OpType::ELM_ADD, s, std::array{ m, x });
+  builder.elementWise(OpType::EXPONENTIAL, e, std::array{ s });
+  builder.scalarOp(OpType::SCL_ELM_MUL, e, 0.5F);
+
+  scions::cpu::RuntimeCpuGraph graph(compact(builder.toDag().topologicalSort()));
+  const auto segments = graph.tileSchedule().segments();
+  REQUIRE(segments.size() == 1);
+  REQUIRE(segments[0].last - segments[0].first == 4);
+  // whole rows
+  REQUIRE(segments[0].tile != 0);
+  REQUIRE(segments[0].tile % 100 == 0);
+
+  auto input = graph.tensorSpan<float>(x);
+  for (size_t i{}; i < input.size(); i++) { input[i] = static_cast<float>(i % 97) * 0.01F; }
+  graph.run();
+  const auto out = graph.tensorSpan<float>(e);
+  const std::vector<float> expected(out.begin(), out.end());
+  std::ranges::fill(out, 0.0F);
+  graph.runTiled();
+  REQUIRE(std::ranges::equal(out, expected));
+}
+
+TEST_CASE("Weights are read in place from a mapped file", "[scions][runtime][weights]")
+{
+  using namespace manifold;
+  GraphBuilder builder;
+  const auto x = builder.tensor(DType::F32, std::array{ 1024U });
+  const auto w = builder.tensor(DType::F32, std::array{ 1024U });
+  const auto y = builder.tensor(DType::F32, std::array{ 1024U });
+  builder.elementWise(OpType::ELM_MUL, y, std::array{ x, w });
+  const auto compact_graph = compact(builder.toDag().topologicalSort());
+
+  std::vector<float> weight(1024);
+  for (size_t i{}; i < weight.size(); i++) { weight[i] = static_cast<float>(i); }
+  const auto path = std::filesystem::temp_directory_path() / "scions_weights_test.scw";
+  const std::array blobs{ scions::cpu::WeightBlob{ w, DType::F32, std::as_bytes(std::span(weight)) } };
+  scions::cpu::writeWeightFile(path, blobs);
+
+  {
+    const scions::cpu::MappedWeights weights(path, { .populate = true });
+    REQUIRE(weights.entries().size() == 1);
+    scions::cpu::RuntimeCpuGraph graph(compact_graph, weights);
+    // no copy, the tensor is the mapping
+    REQUIRE(static_cast<const void *>(graph.tensorSpan<float>(w).data())
+            == static_cast<const void *>(weights.bytes(weights.entries()[0]).data()));
+    std::ranges::fill(graph.tensorSpan<float>(x), 2.0F);
+    graph.run();
+    const auto out = graph.tensorSpan<float>(y);
+    for (size_t i{}; i < out.size(); i++) { REQUIRE(out[i] == 2.0F * static_cast<float>(i)); }
+
+    // the output is written by the graph, it can't come from the file
+    const std::array wrong{ scions::cpu::WeightBlob{ y, DType::F32, std::as_bytes(std::span(weight)) } };
+    scions::cpu::writeWeightFile(path.string() + ".out", wrong);
+    const scions::cpu::MappedWeights out_weights(path.string() + ".out");
+    REQUIRE_THROWS_AS(scions::cpu::RuntimeCpuGraph(compact_graph, out_weights), std::invalid_argument);
+  }
+  std::filesystem::remove(path);
+  std::filesystem::remove(path.string() + ".out");
+}
+
+TEST_CASE("Static stores read weights in place from a mapped file", "[scions][static][weights]")
+{
+  using manifold::DType;
+  constexpr auto &INPUTS  = scions::cpu::graph_inputs<GATES_GRAPH>;
+  constexpr auto &OUTPUTS = scions::cpu::graph_outputs<GATES_GRAPH>;
+
+  const uint32_t input_id  = GATES_GRAPH.data[INPUTS[0]].id;
+  const uint32_t output_id = GATES_GRAPH.data[OUTPUTS[0]].id;
+
+  const std::array weight{ 0.5F };
+  const auto path = std::filesystem::temp_directory_path() / "scions_static_weights_test.scw";
+  const std::array blobs{ scions::cpu::WeightBlob{ input_id, DType::F32, std::as_bytes(std::span(weight)) } };
+  scions::cpu::writeWeightFile(path, blobs);
+
+  {
+    const scions::cpu::MappedWeights weights(path);
+    scions::cpu::CpuMemStore<GATES_META> store(GATES_GRAPH);
+    store.initializeMemory();
+    REQUIRE(store.bindWeights(weights) == 1);
+    // no copy, the input is the mapping
+    REQUIRE(static_cast<const void *>(store.tensorSpan<float>(INPUTS[0]).data())
+            == static_cast<const void *>(weights.bytes(weights.entries()[0]).data()));
+    scions::cpu::exec_cpu_graph<GATES_GRAPH>(store);
+    REQUIRE(store.tensorSpan<float>(OUTPUTS[0])[0] == scions::cpu::exec_scalar_graph<GATES_GRAPH>({ 0.5F })[0]);
+
+    // the output is written by the graph, it can't come from the file
+    const std::array wrong{ scions::cpu::WeightBlob{ output_id, DType::F32, std::as_bytes(std::span(weight)) } };
+    scions::cpu::writeWeightFile(path.string() + ".out", wrong);
+    const scions::cpu::MappedWeights out_weights(path.string() + ".out");
+    scions::cpu::CpuMemStore<GATES_META> out_store(GATES_GRAPH);
+    out_store.initializeMemory();
+    REQUIRE_THROWS_AS(out_store.bindWeights(out_weights), std::invalid_argument);
+  }
+  std::filesystem::remove(path);
+  std::filesystem::remove(path.string() + ".out");
+}
+
+TEST_CASE("Planned graphs are saved and loaded back", "[manifold][runtime][graph_file]")
+{
+  using namespace manifold;
+  GraphBuilder builder;
+  const auto a = builder.tensor(DType::F32, std::array{ 16U, 8U });
+  const auto b = builder.tensor(DType::F32, std::array{ 16U, 8U });
+  const auto c = builder.tensor(DType::F32, std::array{ 16U, 8U });
+  const auto d = builder.tensor(DType::F32, std::array{ 16U, 8U });
+  builder.elementWise(OpType::ELM_ADD, c, std::array{ a, b });
+  builder.scalarOp(OpType::SCL_ELM_MUL, c, 3.0F);
+  builder.elementWise(OpType::ELM_MUL, d, std::array{ c, a });
+  const auto planned = compact(builder.toDag().topologicalSort());
+
+  const auto path = std::filesystem::temp_directory_path() / "manifold_graph_test.mfg";
+  saveGraph(path, planned);
+  const auto loaded = loadGraph(path);
+  REQUIRE(loaded.offsets == planned.offsets);
+  REQUIRE(loaded.meta.total == planned.meta.total);
+  REQUIRE(loaded.expressions.size() == planned.expressions.size());
+  for (size_t i{}; i < loaded.expressions.size(); i++) {
+    REQUIRE(loaded.expressions[i].type == planned.expressions[i].type);
+    REQUIRE(loaded.expressions[i].input_indices == planned.expressions[i].input_indices);
+    REQUIRE(loaded.expressions[i].output_indices == planned.expressions[i].output_indices);
+  }
+
+  scions::cpu::RuntimeCpuGraph graph(loaded);
+  std::ranges::fill(graph.tensorSpan<float>(a), 2.0F);
+  std::ranges::fill(graph.tensorSpan<float>(b), 1.0F);
+  graph.run();
+  for (const float val : graph.tensorSpan<float>(d)) { REQUIRE(val == 18.0F); }
+
+  // the same graph gives the same file whatever the padding bytes of its records hold
+  CompactRuntimeGraph dirty = planned;
+  for (auto &ten : dirty.data) {
+    const TensorReflection src = ten;
+    std::memset(static_cast<void *>(&ten), 0xAB, sizeof(ten));
+    ten.data_type      = src.data_type;
+    ten.size           = src.size;
+    ten.id             = src.id;
+    ten.shape.rank     = src.shape.rank;
+    ten.shape.shape    = src.shape.shape;
+    ten.storage_layout = src.storage_layout;
+    ten.storage_type   = src.storage_type;
+  }
+  for (auto &exp : dirty.expressions) {
+    const RuntimeExpression src = exp;
+    std::memset(static_cast<void *>(&exp), 0xAB, sizeof(exp));
+    exp.type           = src.type;
+    exp.data_type      = src.data_type;
+    exp.id             = src.id;
+    exp.inp_size       = src.inp_size;
+    exp.out_size       = src.out_size;
+    exp.input_indices  = src.input_indices;
+    exp.output_indices = src.output_indices;
+    exp.params         = src.params;
+    exp.in_place       = src.in_place;
+    exp.group          = src.group;
+    exp.pinned         = src.pinned;
+  }
+  const auto read_file = [](const std::filesystem::path &file) {
+    std::ifstream stream(file, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(stream), {});
+  };
+  const auto dirty_path = std::filesystem::temp_directory_path() / "manifold_graph_test_dirty.mfg";
+  saveGraph(dirty_path, dirty);
+  REQUIRE(read_file(dirty_path) == read_file(path));
+  std::filesystem::remove(dirty_path);
+
+  // offsets planned with another tensor alignment are rejected
+  CompactRuntimeGraph misaligned = planned;
+  misaligned.offsets[0] += 1;
+  REQUIRE_THROWS_AS(_internal::validateGraph(misaligned, "misaligned"), std::runtime_error);
+  // as are expressions reading a tensor smaller than their output
+  CompactRuntimeGraph mismatched = planned;
+  mismatched.data[a].size /= 2;
+  REQUIRE_THROWS_AS(_internal::validateGraph(mismatched, "mismatched"), std::runtime_error);
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    const uint16_t other_align = MANIFOLD_TENSOR_ALIGN * 2;
+    file.seekp(offsetof(GraphFileHeader, tensor_align));
+    file.write(reinterpret_cast<const char *>(&other_align), sizeof(other_align));
+  }
+  REQUIRE_THROWS_AS(loadGraph(path), std::runtime_error);
+  saveGraph(path, planned);
+
+  // a truncated file is rejected before anything is read past its end
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 8);
+  REQUIRE_THROWS_AS(loadGraph(path), std::runtime_error);
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Plans are reused from the cache directory", "[manifold][runtime][plan_cache]")
+{
+  using namespace manifold;
+  const auto build = [](const float scale) {
+    GraphBuilder builder;
+    const auto a = builder.tensor(DType::F32, std::array{ 256U });
+    const auto b = builder.tensor(DType::F32, std::array{ 256U });
+    const auto c = builder.tensor(DType::F32, std::array{ 256U });
+    builder.elementWise(OpType::EXPONENTIAL, b, std::array{ a });
+    builder.elementWise(OpType::ELM_ADD, c, std::array{ a, b });
+    builder.scalarOp(OpType::SCL_ELM_MUL, c, scale);
+    return builder.toDag();
+  };
+  const auto dir = std::filesystem::temp_directory_path() / "manifold_plan_cache_test";
+  std::filesystem::remove_all(dir);
+
+  {
+    PlanCache cache(dir);
+    const auto first = cache.plan(build(2.0F));
+    REQUIRE(cache.misses() == 1);
+    REQUIRE(std::filesystem::exists(cache.planPath(graphHash(build(2.0F)))));
+    // params are part of the key
+    REQUIRE(graphHash(build(2.0F)) != graphHash(build(3.0F)));
+    REQUIRE(graphHash(build(2.0F)) != graphHash(build(2.0F), SortOrder::LOCALITY));
+    REQUIRE(first.offsets == compact(build(2.0F).topologicalSort()).offsets);
+  }
+  {
+    // a new cache over the same directory, as after a restart
+    PlanCache cache(dir);
+    const auto again = cache.plan(build(2.0F));
+    REQUIRE(cache.hits() == 1);
+    REQUIRE(cache.misses() == 0);
+    REQUIRE(again.offsets == compact(build(2.0F).topologicalSort()).offsets);
+
+    // a corrupted entry is planned again and replaced
+    const auto path = cache.planPath(graphHash(build(2.0F)));
+    std::filesystem::resize_file(path, 32);
+    REQUIRE(cache.plan(build(2.0F)).expressions.size() == again.expressions.size());
+    REQUIRE(cache.misses() == 1);
+    REQUIRE(cache.plan(build(2.0F)).expressions.size() == again.expressions.size());
+    REQUIRE(cache.hits() == 2);
+  }
+  // nothing but complete graph files is left behind
+  for (const auto &entry : std::filesystem::directory_iterator(dir)) { REQUIRE(entry.path().extension() == ".mfg"); }
+  std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Autotuned kernels are saved, loaded and give the same results", "[scions][runtime][autotune]")
+{
+  using namespace manifold;
+  GraphBuilder builder;
+  const auto a = builder.tensor(DType::F32, std::array{ 4000U });
+  const auto b = builder.tensor(DType::F32, std::array{ 4000U });
+  const auto c = builder.tensor(DType::F32, std::array{ 4000U });
+  const auto d = builder.tensor(DType::F32, std::array{ 4000U });
+  const auto e = builder.tensor(DType::F32, std::array{ 4000U });
+  builder.elementWise(OpType::ELM_ADD, d, std::array{ a, b, c });
+  builder.elementWise(OpType::ELM_DIV, e, std::array{ d, a, b });
+  const auto compact_graph = compact(builder.toDag().topologicalSort());
+
+  // a budget the tuning never reaches, every op gets its chunk however slow the machine is
+  const auto table = scions::cpu::autotune(compact_graph, std::chrono::hours(1));
+  REQUIRE(table.chunks.size() == 2);
+  REQUIRE(table.threads >= 1);
+  // nothing left to tune, an exhausted budget keeps the table as it is
+  REQUIRE(scions::cpu::autotune(compact_graph, std::chrono::nanoseconds(0), table).chunks == table.chunks);
+
+  const auto path = std::filesystem::temp_directory_path() / "scions_tuning_test.tune";
+  table.save(path);
+  const auto loaded = scions::cpu::TuningTable::load(path);
+  REQUIRE(loaded.chunks == table.chunks);
+  REQUIRE(loaded.tile_bytes == table.tile_bytes);
+  REQUIRE(loaded.threads == table.threads);
+  std::filesystem::remove(path);
+
+  // every chunk computes what the element by element kernels do
+  for (const uint32_t chunk : scions::cpu::TUNE_CHUNKS) {
+    scions::cpu::TuningTable forced = loaded;
+    for (auto &[key, value] : forced.chunks) { value = chunk; }
+    forced.threads = 2;
+    scions::cpu::RuntimeCpuGraph graph(compact_graph, forced);
+    REQUIRE(graph.threads() == 2);
+    for (size_t i{}; i < 4000; i++) {
+      graph.tensorSpan<float>(a)[i] = static_cast<float>(i + 1);
+      graph.tensorSpan<float>(b)[i] = 2.0F;
+      graph.tensorSpan<float>(c)[i] = 0.5F;
+    }
+    scions::cpu::ThreadPool pool(graph.threads());
+    graph.run(pool);
+    for (size_t i{}; i < 4000; i++) {
+      const float x = static_cast<float>(i + 1);
+      REQUIRE(graph.tensorSpan<float>(e)[i] == (x + 2.5F) / x / 2.0F);
+    }
+  }
+  REQUIRE(scions::cpu::RuntimeCpuGraph(compact_graph).threads() == scions::cpu::TuningTable{}.threads);
+}
+
+TEST_CASE("Arenas are placed on the node of the tasks using them", "[scions][runtime][numa]")
+{
+  using namespace manifold;
+  REQUIRE(scions::cpu::NumaTopology::parseCpuList("0-2,8,10-11\n") == std::vector<uint32_t>{ 0, 1, 2, 8, 10, 11 });
+  REQUIRE(!scions::cpu::NumaTopology::detect().nodes.empty());
+
+  // independent chains of exp, laid out chain by chain so each node gets whole chains
+  constexpr uint32_t chains = 8;
+  constexpr uint32_t steps  = 10;
+  GraphBuilder builder;
+  for (uint32_t c{}; c < chains; c++) {
+    uint32_t prev = builder.tensor(DType::F32, std::array{ 2048U });
+    for (uint32_t i{}; i < steps; i++) {
+      const auto next = builder.tensor(DType::F32, std::array{ 2048U });
+      builder.elementWise(OpType::ELM_ADD, next, std::array{ prev, prev });
+      prev = next;
+    }
+  }
+  scions::cpu::RuntimeCpuGraph graph(compact(builder.toDag().topologicalSort(SortOrder::LOCALITY)));
+
+  // the first chains go to the first node, the last ones to the second
+  const scions::cpu::NumaPlacement split(
+    graph.compactGraph(), graph.tensorAddresses(), graph.taskGraph(), std::span<std::byte>{}, 2);
+  REQUIRE(split.node(0) == 0);
+  REQUIRE(split.node(graph.taskGraph().size() - 1) == 1);
+
+  // two nodes sharing the first cpu, as many nodes as a dual socket machine without needing one
+  const uint32_t cpu = scions::cpu::NumaTopology::detect().nodes[0].cpus[0];
+  const scions::cpu::NumaTopology topology{ { { 0, { cpu } }, { 1, { cpu } } } };
+  // touching the pages keeps what they hold
+  for (const auto idx : graph.inputs()) { std::ranges::fill(graph.tensorSpan<float>(idx), 1.0F); }
+  graph.place(topology);
+  for (const auto idx : graph.inputs()) {
+    REQUIRE(std::ranges::all_of(graph.tensorSpan<float>(idx), [](const float val) { return val == 1.0F; }));
+  }
+  scions::cpu::ThreadPool pool(topology, 4);
+  REQUIRE_THROWS_AS(scions::cpu::ThreadPool(scions::cpu::NumaTopology{}), std::invalid_argument);
+
+  for (int run{}; run < 5; run++) {
+    for (const auto idx : graph.inputs()) { std::ranges::fill(graph.tensorSpan<float>(idx), 1.0F); }
+    graph.run(pool);
+    for (const auto idx : graph.outputs()) {
+      for (const float val : graph.tensorSpan<float>(idx)) { REQUIRE(val == 1024.0F); }
+    }
+  }
+}
+
+TEST_CASE("Arenas fall back from huge pages to normal ones", "[scions][runtime][pages]")
+{
+  using namespace manifold;
+  using scions::cpu::PageKind;
+  // too small for a huge page, and every step of the fallback turned off
+  REQUIRE(scions::cpu::HugePages{}.allocate(4096).kind() == PageKind::NORMAL);
+  REQUIRE(scions::cpu::HugePages{ false, false }.allocate(8 << 20).kind() == PageKind::NORMAL);
+  // advised only when the kernel THP mode lets the advice through
+  const auto thp = scions::mem::_internal::transparentHugeEnabled() ? PageKind::THP_ADVISED : PageKind::NORMAL;
+  REQUIRE(scions::cpu::HugePages{ false, true }.allocate(4 << 20).kind() == thp);
+
+  // whatever the system gives, the arena is at least as large as asked and 2 MiB aligned once mapped
+  const scions::cpu::PageBuffer pages = scions::cpu::HugePages{}.allocate(3 << 20);
+  REQUIRE(pages.size() >= (3 << 20));
+  if (pages.kind() != PageKind::NORMAL) { REQUIRE(reinterpret_cast<uintptr_t>(pages.data()) % (2 << 20) == 0); }
+  std::ranges::fill(std::span(pages.data(), pages.size()), std::byte{ 1 });
+
+  GraphBuilder builder;
+  const auto inp = builder.tensor(DType::F32, std::array{ 1U << 20 });
+  const auto out = builder.tensor(DType::F32, std::array{ 1U << 20 });
+  builder.elementWise(OpType::ELM_ADD, out, std::array{ inp, inp });
+  scions::cpu::RuntimeCpuGraph graph(compact(builder.toDag().topologicalSort()));
+  REQUIRE(!scions::cpu::pageKindToString(graph.pageKind()).empty());
+  std::ranges::fill(graph.tensorSpan<float>(inp), 1.0F);
+  graph.run();
+  for (const float val : graph.tensorSpan<float>(out)) { REQUIRE(val == 2.0F); }
+}
+
+TEST_CASE("Normal pages are aligned like the tensor buffers", "[scions][runtime][pages]")
+{
+  using scions::cpu::PageKind;
+  for (const size_t bytes : { size_t{ 0 }, size_t{ 1 }, size_t{ 4097 }, size_t{ 3 } << 20 }) {
+    const scions::cpu::PageBuffer pages = scions::cpu::NormalPages{}.allocate(bytes);
+    REQUIRE(pages.kind() == PageKind::NORMAL);
+    REQUIRE(pages.size() >= std::max<size_t>(bytes, 1));
+    REQUIRE(reinterpret_cast<uintptr_t>(pages.data()) % MANIFOLD_TENSOR_ALIGN == 0);
+  }
+
+  // moved from buffers give nothing back
+  scions::cpu::PageBuffer from = scions::cpu::NormalPages{}.allocate(64);
+  std::byte *data              = from.data();
+  scions::cpu::PageBuffer to   = std::move(from);
+  REQUIRE(from.data() == nullptr);  // NOLINT(bugprone-use-after-move)
+  REQUIRE(to.data() == data);
+  REQUIRE(to.size() == 64);
+}
+
+TEST_CASE("Scalar graphs run as straight line code", "[scions][static][scalar]")
+{
+  constexpr auto &INPUTS  = scions::cpu::graph_inputs<GATES_GRAPH>;
+  constexpr auto &OUTPUTS = scions::cpu::graph_outputs<GATES_GRAPH>;
+  STATIC_REQUIRE(INPUTS.size() == 1);
+  STATIC_REQUIRE(OUTPUTS.size() == 1);
+
+  scions::cpu::CpuMemStore<GATES_META> store(GATES_GRAPH);
+  store.initializeMemory();
+  NoRecorder recorder;
+  for (const float val : { -2.0F, 0.0F, 0.5F, 3.0F }) {
+    store.tensorSpan<float>(INPUTS[0])[0] = val;
+    scions::cpu::exec_cpu_graph<GATES_GRAPH>(store, recorder);
+    const float expected = store.tensorSpan<float>(OUTPUTS[0])[0];
+    REQUIRE(expected == std::exp(val) * (std::exp(val) + 1.0F));
+    REQUIRE(scions::cpu::exec_scalar_graph<GATES_GRAPH>({ val })[0] == expected);
+
+    // exec_cpu_graph takes the straight line path itself
+    store.tensorSpan<float>(OUTPUTS[0])[0] = 0.0F;
+    scions::cpu::exec_cpu_graph<GATES_GRAPH>(store);
+    REQUIRE(store.tensorSpan<float>(OUTPUTS[0])[0] == expected);
+  }
+}
+
+TEST_CASE("Batched graphs match per sample runs", "[scions][static][batch]")
+{
+  constexpr auto &INPUTS  = scions::cpu::graph_inputs<GATES_GRAPH>;
+  constexpr auto &OUTPUTS = scions::cpu::graph_outputs<GATES_GRAPH>;
+  // more samples than a chunk, the last chunk is partial
+  constexpr size_t batch = scions::cpu::BatchExecutor<GATES_GRAPH>::CHUNK * 2 + 3;
+  std::vector<float> samples(batch);
+  for (size_t i{}; i < batch; i++) { samples[i] = static_cast<float>(i % 100) / 50.0F - 1.0F; }
+
+  scions::cpu::BatchExecutor<GATES_GRAPH> executor(batch);
+  const auto outputs = executor.run<float>({ std::span<const float>(samples) });
+  REQUIRE(outputs[0].size() == batch);
+
+  scions::cpu::CpuMemStore<GATES_META> store(GATES_GRAPH);
+  store.initializeMemory();
+  for (size_t i{}; i < batch; i++) {
+    store.tensorSpan<float>(INPUTS[0])[0] = samples[i];
+    scions::cpu::exec_cpu_graph<GATES_GRAPH>(store);
+    REQUIRE(outputs[0][i] == store.tensorSpan<float>(OUTPUTS[0])[0]);
+  }
+  REQUIRE_THROWS_AS(executor.run<float>({ std::span<const float>(samples).first(batch - 1) }), std::invalid_argument);
+}
@@ -0,0 +1,263 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "Scions/ep/cpu/cpu_ep.h"
+#include "Scions/ep/cpu/mem/runtime_mem_manager.h"
+#include "Scions/ep/cpu/op/execute_op.h"
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+using scions::ep::cpu::CpuMemOptions;
+using scions::ep::cpu::RuntimeCpuMemoryManager;
+using scions::ep::cpu::executeOp;
+using scions::op::OpDesc;
+using Inputs  = std::array<const size_t, SC_OP_INPUT_MAX>;
+using Outputs = std::array<const size_t, SC_OP_OUTPUT_MAX>;
+
+scions::mem::MemObject floats(const uint64_t id, const uint64_t offset, const uint32_t count)
+{
+  return { count * sizeof(float), "floats", id, offset, 1, { count }, scions::d_type::F32 };
+}
+
+// Memory object @param id of @param count elements, 64 bytes after the previous one
+template<typename T>
+scions::mem::MemObject typed(const uint64_t id, const uint32_t count, const scions::d_type::TYPE type)
+{
+  return { count * sizeof(T), "typed", id, id * 64, 1, { count }, type };
+}
+
+// Operand indices of an OpDesc are 1 based, index i is mem_refs[i - 1]
+OpDesc opDesc(const int32_t op_id, const Inputs &inputs, const Outputs &outputs)
+{
+  return { op_id, inputs, outputs, "test op" };
+}
+
+bool alignedTo(const void *ptr, const size_t alignment)
+{
+  return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+}  // namespace
+
+TEST_CASE("Runtime memory is aligned and zeroed", "[scions][v1][mem]")
+{
+  const std::array objects{ floats(0, 0, 16), floats(1, 64, 16) };
+  const scions::graph::RuntimeSequentialGraph graph(objects, {}, 128);
+
+  RuntimeCpuMemoryManager manager(graph, CpuMemOptions{ 4096, false });
+  REQUIRE(manager.mem_refs.size() == 2);
+  REQUIRE(manager.totalBytes() == 128);
+  REQUIRE(alignedTo(manager.getSpan<float>(0).data(), 4096));
+  REQUIRE(manager.getSpan<float>(1).data() == manager.getSpan<float>(0).data() + 16);
+  for (const float val : manager.getSpan<float>(1)) { REQUIRE(val == 0.0F); }
+
+  REQUIRE_THROWS_AS(RuntimeCpuMemoryManager(graph, CpuMemOptions{ 48, false }), std::invalid_argument);
+}
+
+TEST_CASE("Memory objects past the end of the graph are rejected", "[scions][v1][mem]")
+{
+  const std::array objects{ floats(0, 0, 16), floats(1, 96, 16) };
+  const scions::graph::RuntimeSequentialGraph graph(objects, {}, 128);
+  REQUIRE_THROWS_AS(RuntimeCpuMemoryManager(graph), std::runtime_error);
+  REQUIRE_THROWS_AS(RuntimeCpuMemoryManager(graph, CpuMemOptions{ 64, true }), std::runtime_error);
+}
+
+TEST_CASE("Runtime memory reports the pages it got", "[scions][v1][mem]")
+{
+  using scions::ep::cpu::PageKind;
+  const std::array small{ floats(0, 0, 16) };
+  const RuntimeCpuMemoryManager normal(scions::graph::RuntimeSequentialGraph(small, {}, 64), CpuMemOptions{ 64, true });
+  // too small for a huge page
+  REQUIRE(normal.pageKind() == PageKind::NORMAL);
+  REQUIRE(!normal.usesHugePages());
+
+  constexpr uint32_t COUNT = 1U << 20;
+  const std::array large{ floats(0, 0, COUNT) };
+  const scions::graph::RuntimeSequentialGraph graph(large, {}, COUNT * sizeof(float));
+  RuntimeCpuMemoryManager manager(graph, CpuMemOptions{ 64, true });
+  REQUIRE(manager.usesHugePages() == (manager.pageKind() != PageKind::NORMAL));
+  if (manager.usesHugePages()) { REQUIRE(alignedTo(manager.getSpan<float>(0).data(), size_t{ 2 } << 20)); }
+  REQUIRE(alignedTo(manager.getSpan<float>(0).data(), 64));
+  REQUIRE(manager.getSpan<float>(0).size() == COUNT);
+
+  const RuntimeCpuMemoryManager heap(graph, CpuMemOptions{ 64, false });
+  REQUIRE(heap.pageKind() == PageKind::NORMAL);
+}
+
+TEST_CASE("Op descriptors count operands up to the first unused index", "[scions][v1][op]")
+{
+  const OpDesc add = opDesc(scions::op::tensor::TENSOR_ADD_OP_ID, { 1, 2, 3 }, { 4 });
+  REQUIRE(add.num_inputs == 3);
+  REQUIRE(add.num_outputs == 1);
+  // 0 marks the end, indices after it are ignored
+  const OpDesc cut = opDesc(scions::op::tensor::TENSOR_ADD_OP_ID, { 1, 0, 3 }, { 4, 0, 2 });
+  REQUIRE(cut.num_inputs == 1);
+  REQUIRE(cut.num_outputs == 1);
+  const OpDesc none = opDesc(scions::op::tensor::TENSOR_ADD_OP_ID, {}, {});
+  REQUIRE(none.num_inputs == 0);
+  REQUIRE(none.num_outputs == 0);
+}
+
+TEST_CASE("Every v1 op runs on floating point tensors", "[scions][v1][op]")
+{
+  namespace tensor = scions::op::tensor;
+  using scions::d_type::F32;
+  // a, b, out (4 floats each), rows (2 floats) and mean (1 float)
+  const std::array objects{ typed<float>(0, 4, F32), typed<float>(1, 4, F32), typed<float>(2, 4, F32),
+    typed<float>(3, 2, F32), typed<float>(4, 1, F32) };
+  const scions::graph::RuntimeSequentialGraph graph(objects, {}, 5 * 64);
+  RuntimeCpuMemoryManager manager(graph);
+  const std::array a_vals{ 1.0F, 2.0F, 3.0F, 4.0F };
+  std::ranges::copy(a_vals, manager.getSpan<float>(0).begin());
+  std::ranges::fill(manager.getSpan<float>(1), 2.0F);
+  const auto out = manager.getSpan<float>(2);
+
+  const auto expect = [&](const int32_t op_id, const Inputs &inputs, auto fn) {
+    executeOp(opDesc(op_id, inputs, { 3 }), manager);
+    for (size_t i{}; i < out.size(); i++) { REQUIRE(out[i] == fn(a_vals[i])); }
+  };
+  expect(tensor::TENSOR_ADD_OP_ID, { 1, 2 }, [](float a) { return a + 2.0F; });
+  expect(tensor::TENSOR_ADD_OP_ID, { 1, 2, 2, 1 }, [](float a) { return a + 2.0F + 2.0F + a; });
+  expect(tensor::TENSOR_SUBTRACT_OP_ID, { 1, 2 }, [](float a) { return a - 2.0F; });
+  expect(tensor::TENSOR_MULTIPLY_OP_ID, { 1, 2, 2 }, [](float a) { return a * 4.0F; });
+  expect(tensor::TENSOR_DIVIDE_OP_ID, { 1, 2 }, [](float a) { return a / 2.0F; });
+  expect(tensor::TENSOR_EXPONENTIATION_OP_ID, { 1, 2 }, [](float a) { return a * a; });
+  expect(tensor::TENSOR_LOG_OP_ID, { 1 }, [](float a) { return std::log(a); });
+  expect(tensor::TENSOR_SQUARE_ROOT_OP_ID, { 1 }, [](float a) { return std::sqrt(a); });
+  expect(scions::op::mem::MEM_COPY_OP_ID, { 1 }, [](float a) { return a; });
+
+  // a single output is the mean of the whole tensor, an output per row the mean of each row
+  executeOp(opDesc(tensor::TENSOR_MEAN_OP_ID, { 1 }, { 5 }), manager);
+  REQUIRE(manager.getSpan<float>(4)[0] == 2.5F);
+  executeOp(opDesc(tensor::TENSOR_MEAN_OP_ID, { 1 }, { 4 }), manager);
+  REQUIRE(manager.getSpan<float>(3)[0] == 1.5F);
+  REQUIRE(manager.getSpan<float>(3)[1] == 3.5F);
+
+  executeOp(opDesc(scions::op::mem::MEM_FILL_RANDOM_OP_ID, { 1 }, { 3 }), manager);
+  for (const float val : out) { REQUIRE((val >= 0.0F && val < 1.0F)); }
+  executeOp(opDesc(scions::op::mem::MEM_FREE_OP_ID, { 3 }, { 3 }), manager);
+  REQUIRE(manager.getSpan<float>(0)[3] == 4.0F);
+}
+
+TEST_CASE("Every v1 op runs on integer tensors", "[scions][v1][op]")
+{
+  namespace tensor = scions::op::tensor;
+  using scions::d_type::INT32;
+  const std::array objects{ typed<int32_t>(0, 4, INT32), typed<int32_t>(1, 4, INT32), typed<int32_t>(2, 4, INT32),
+    typed<int32_t>(3, 1, INT32) };
+  const scions::graph::RuntimeSequentialGraph graph(objects, {}, 4 * 64);
+  RuntimeCpuMemoryManager manager(graph);
+  const std::array a_vals{ 1, 4, 7, 10 };
+  std::ranges::copy(a_vals, manager.getSpan<int32_t>(0).begin());
+  std::ranges::fill(manager.getSpan<int32_t>(1), 3);
+  const auto out = manager.getSpan<int32_t>(2);
+
+  const auto expect = [&](const int32_t op_id, const Inputs &inputs, auto fn) {
+    executeOp(opDesc(op_id, inputs, { 3 }), manager);
+    for (size_t i{}; i < out.size(); i++) { REQUIRE(out[i] == fn(a_vals[i])); }
+  };
+  expect(tensor::TENSOR_ADD_OP_ID, { 1, 2, 2 }, [](int32_t a) { return a + 6; });
+  expect(tensor::TENSOR_SUBTRACT_OP_ID, { 2, 1 }, [](int32_t a) { return 3 - a; });
+  expect(tensor::TENSOR_MULTIPLY_OP_ID, { 1, 2 }, [](int32_t a) { return a * 3; });
+  // integer division truncates
+  expect(tensor::TENSOR_DIVIDE_OP_ID, { 1, 2 }, [](int32_t a) { return a / 3; });
+  expect(tensor::TENSOR_EXPONENTIATION_OP_ID, { 1, 2 }, [](int32_t a) { return a * a * a; });
+  // math functions go through double and truncate back
+  expect(tensor::TENSOR_SQUARE_ROOT_OP_ID, { 1 }, [](int32_t a) { return static_cast<int32_t>(std::sqrt(a)); });
+  expect(tensor::TENSOR_LOG_OP_ID, { 1 }, [](int32_t a) { return static_cast<int32_t>(std::log(a)); });
+
+  // 22 / 4 = 5.5, truncated
+  executeOp(opDesc(tensor::TENSOR_MEAN_OP_ID, { 1 }, { 4 }), manager);
+  REQUIRE(manager.getSpan<int32_t>(3)[0] == 5);
+
+  executeOp(opDesc(scions::op::mem::MEM_FILL_RANDOM_OP_ID, { 1 }, { 3 }), manager);
+  for (const int32_t val : out) { REQUIRE((val >= 0 && val <= 100)); }
+}
+
+TEST_CASE("v1 ops may write one of their inputs", "[scions][v1][op]")
+{
+  namespace tensor = scions::op::tensor;
+  using scions::d_type::F64;
+  const std::array objects{ typed<double>(0, 4, F64), typed<double>(1, 4, F64) };
+  const scions::graph::RuntimeSequentialGraph graph(objects, {}, 2 * 64);
+  RuntimeCpuMemoryManager manager(graph);
+  const auto a = manager.getSpan<double>(0);
+  const auto b = manager.getSpan<double>(1);
+  std::ranges::fill(a, 2.0);
+  std::ranges::fill(b, 3.0);
+
+  // every input of an element is read before it is written, b is both the last input and the output
+  executeOp(opDesc(tensor::TENSOR_ADD_OP_ID, { 1, 1, 2 }, { 2 }), manager);
+  for (const double val : b) { REQUIRE(val == 7.0); }
+  executeOp(opDesc(tensor::TENSOR_MULTIPLY_OP_ID, { 1, 1 }, { 1 }), manager);
+  for (const double val : a) { REQUIRE(val == 4.0); }
+  executeOp(opDesc(tensor::TENSOR_SQUARE_ROOT_OP_ID, { 1 }, { 1 }), manager);
+  for (const double val : a) { REQUIRE(val == 2.0); }
+  executeOp(opDesc(scions::op::mem::MEM_COPY_OP_ID, { 2 }, { 2 }), manager);
+  for (const double val : b) { REQUIRE(val == 7.0); }
+}
+
+TEST_CASE("v1 ops reject bad operands", "[scions][v1][op]")
+{
+  namespace tensor = scions::op::tensor;
+  using scions::d_type::F16;
+  using scions::d_type::F32;
+  using scions::d_type::INT32;
+  const std::array objects{ typed<float>(0, 4, F32), typed<float>(1, 3, F32), typed<int32_t>(2, 4, INT32),
+    typed<int16_t>(3, 4, F16) };
+  const scions::graph::RuntimeSequentialGraph graph(objects, {}, 4 * 64);
+  RuntimeCpuMemoryManager manager(graph);
+
+  // unknown ops, and ops without inputs or outputs
+  REQUIRE_THROWS_AS(executeOp(opDesc(0, { 1 }, { 1 }), manager), std::runtime_error);
+  REQUIRE_THROWS_AS(executeOp(opDesc(9, { 1 }, { 1 }), manager), std::runtime_error);
+  REQUIRE_THROWS_AS(executeOp(opDesc(-4, { 1 }, { 1 }), manager), std::runtime_error);
+  REQUIRE_THROWS_AS(executeOp(opDesc(tensor::TENSOR_LOG_OP_ID, {}, { 1 }), manager), std::runtime_error);
+  REQUIRE_THROWS_AS(executeOp(opDesc(tensor::TENSOR_LOG_OP_ID, { 1 }, {}), manager), std::runtime_error);
+  // operand past the memory objects
+  REQUIRE_THROWS_AS(executeOp(opDesc(tensor::TENSOR_ADD_OP_ID, { 1, 5 }, { 1 }), manager), std::runtime_error);
+  REQUIRE_THROWS_AS(executeOp(opDesc(tensor::TENSOR_ADD_OP_ID, { 1 }, { 5 }), manager), std::runtime_error);
+  // operands of another data type, then of another size
+  REQUIRE_THROWS_AS(executeOp(opDesc(tensor::TENSOR_ADD_OP_ID, { 1, 3 }, { 1 }), manager), std::runtime_error);
+  REQUIRE_THROWS_AS(executeOp(opDesc(tensor::TENSOR_ADD_OP_ID, { 1, 2 }, { 1 }), manager), std::runtime_error);
+  REQUIRE_THROWS_AS(executeOp(opDesc(scions::op::mem::MEM_COPY_OP_ID, { 2 }, { 1 }), manager), std::runtime_error);
+  // F16 has no kernel
+  REQUIRE_THROWS_AS(executeOp(opDesc(tensor::TENSOR_ADD_OP_ID, { 4 }, { 4 }), manager), std::runtime_error);
+  // 4 elements can't be split in 3 means
+  REQUIRE_THROWS_AS(executeOp(opDesc(tensor::TENSOR_MEAN_OP_ID, { 1 }, { 2 }), manager), std::runtime_error);
+}
+
+TEST_CASE("Runtime graphs run end to end on the CPU EP", "[scions][v1][ep]")
+{
+  namespace tensor = scions::op::tensor;
+  using scions::d_type::F32;
+  using scions::ep::cpu::CPURuntimeExecutionProvider;
+  // c = a + b, then d = c * c
+  const std::array objects{ typed<float>(0, 4, F32), typed<float>(1, 4, F32), typed<float>(2, 4, F32),
+    typed<float>(3, 4, F32), typed<float>(4, 2, F32) };
+  const std::array ops{ opDesc(tensor::TENSOR_ADD_OP_ID, { 1, 2 }, { 3 }),
+    opDesc(tensor::TENSOR_MULTIPLY_OP_ID, { 3, 3 }, { 4 }) };
+  const scions::graph::RuntimeSequentialGraph graph(objects, ops, 5 * 64);
+  RuntimeCpuMemoryManager manager(graph);
+  std::ranges::fill(manager.getSpan<float>(0), 1.5F);
+  std::ranges::fill(manager.getSpan<float>(1), 2.0F);
+
+  CPURuntimeExecutionProvider provider(graph, manager, {});
+  const auto stats = provider.executeGraph();
+  REQUIRE(stats.has_value());
+  for (const float val : manager.getSpan<float>(2)) { REQUIRE(val == 3.5F); }
+  for (const float val : manager.getSpan<float>(3)) { REQUIRE(val == 12.25F); }
+
+  // a failing op ends the run with its error, the ops before it ran
+  const std::array failing{ opDesc(tensor::TENSOR_SUBTRACT_OP_ID, { 3, 1 }, { 3 }),
+    opDesc(tensor::TENSOR_ADD_OP_ID, { 1, 5 }, { 1 }) };
+  const scions::graph::RuntimeSequentialGraph failing_graph(objects, failing, 5 * 64);
+  const auto error = CPURuntimeExecutionProvider(failing_graph, manager, {}).executeGraph();
+  REQUIRE(!error.has_value());
+  REQUIRE(error.error().starts_with("Cpu EP"));
+  for (const float val : manager.getSpan<float>(2)) { REQUIRE(val == 2.0F); }
+
+  // the manager has to hold the memory objects of the graph
+  const scions::graph::RuntimeSequentialGraph fewer{ std::span(objects).first(2), ops, 2 * 64 };
+  REQUIRE_THROWS_AS(CPURuntimeExecutionProvider(fewer, manager, {}), std::invalid_argument);
+}